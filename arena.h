@@ -0,0 +1,154 @@
+#ifndef _DS_ARENA_H
+#define _DS_ARENA_H
+
+/* Linear Arena allocator
+ * Namespace: arena
+ *
+ * Bump allocator on a memory region of the user: it provides the arenas
+ * of the other structures without a malloc for each one.
+ * The allocations are released all together (arena_reset) or back to a
+ * mark (arena_rewind), never one by one.
+ *
+ *  static uint8_t mem[ARENA_SIZEOF(SLIST_SIZEOF(N)) +
+ *                     ARENA_SIZEOF(OBJPOOL_SIZEOF(N, sizeof(Obj)))];
+ *  Arena a;
+ *  arena_init(&a, mem, sizeof(mem));
+ *  SList *list = slist_init(arena_push(&a, SLIST_SIZEOF(N)), N);
+ *  objpool_init(&pool, arena_push(&a, OBJPOOL_SIZEOF(N, sizeof(Obj))), N,
+ *               sizeof(Obj));
+ *  ...
+ *  arena_reset(&a);
+ *
+ * The arena does not touch the memory it provides.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+typedef struct Arena Arena;
+
+/* Internal use.
+ * The types with the strictest alignment.
+ */
+typedef union {
+    long double ld;
+    void *p;
+    void (*f)(void);
+    uint64_t u;
+} _ArenaMaxAlign;
+
+/* Default alignment of arena_push, suitable for any object type */
+#define ARENA_ALIGN offsetof(struct { char c; _ArenaMaxAlign m; }, m)
+
+/* Bytes of the region for one arena_push of size bytes (the worst case
+ * padding included): the size of a region is the sum for its allocations.
+ */
+#define ARENA_SIZEOF(size) ( ((size_t)(size)) + ARENA_ALIGN - 1 )
+
+/* Position in the arena to rewind to, see arena_mark */
+typedef size_t ArenaMark;
+
+struct Arena {
+    uint8_t *base; /* the memory region */
+    size_t size;   /* bytes of the region */
+    size_t used;   /* bytes allocated (padding included) */
+    size_t hwm;    /* highest value of used, to size the region */
+};
+
+/* Initialize the arena on the region mem of size bytes.
+ * Time complexity: O(1)
+ * Return false if arena or mem are NULL.
+ */
+static inline bool arena_init(Arena *arena, void *mem, size_t size)
+{
+    if (arena == NULL || mem == NULL){
+        return false;
+    }
+
+    arena->base = (uint8_t*)mem;
+    arena->size = size;
+    arena->used = 0;
+    arena->hwm = 0;
+
+    return true;
+}
+
+/* Allocate size bytes aligned to align (a power of 2).
+ * Time complexity: O(1)
+ * Return the pointer or NULL if the region has no room (or bad arguments).
+ */
+static inline void * arena_alloc(Arena *arena, size_t size, size_t align)
+{
+    if (arena == NULL || align == 0 || (align & (align - 1)) != 0){
+        return NULL;
+    }
+
+    uintptr_t at = (uintptr_t)&arena->base[arena->used];
+    size_t pad = (size_t)(-at & (uintptr_t)(align - 1));
+
+    if (pad > arena->size - arena->used ||
+        size > arena->size - arena->used - pad){
+        return NULL;
+    }
+
+    void *p = &arena->base[arena->used + pad];
+    arena->used += pad + size;
+    arena->hwm = (arena->used > arena->hwm)?arena->used:arena->hwm;
+    return p;
+}
+
+/* Allocate size bytes with the default alignment (ARENA_ALIGN).
+ * Return the pointer or NULL if the region has no room.
+ */
+static inline void * arena_push(Arena *arena, size_t size)
+{
+    return arena_alloc(arena, size, ARENA_ALIGN);
+}
+
+/* Bytes still available, without padding */
+static inline size_t arena_avail(const Arena *arena)
+{
+    if (arena == NULL){
+        return 0;
+    }
+    return arena->size - arena->used;
+}
+
+/* Current position, every allocation after it is released by arena_rewind.
+ * Time complexity: O(1)
+ */
+static inline ArenaMark arena_mark(const Arena *arena)
+{
+    if (arena == NULL){
+        return 0;
+    }
+    return arena->used;
+}
+
+/* Release all the allocations after the mark.
+ * The marks taken after this one become invalid.
+ * Time complexity: O(1)
+ * Return false if the mark is beyond the current position.
+ */
+static inline bool arena_rewind(Arena *arena, ArenaMark mark)
+{
+    if (arena == NULL || mark > arena->used){
+        return false;
+    }
+    arena->used = mark;
+    return true;
+}
+
+/* Release all the allocations.
+ * Time complexity: O(1)
+ */
+static inline void arena_reset(Arena *arena)
+{
+    if (arena != NULL){
+        arena->used = 0;
+    }
+}
+
+#endif
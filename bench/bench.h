@@ -0,0 +1,244 @@
+#ifndef _DS_BENCH_H
+#define _DS_BENCH_H
+
+/* Benchmark harness
+ * Namespace: bench
+ *
+ * A measure runs a procedure of ops operations BENCH_WARMUP times untimed,
+ * then BENCH_REPS times timed with CLOCK_MONOTONIC. An optional setup
+ * procedure prepares the state before every run, out of the timing.
+ * The results are printed as CSV, one line per measure:
+ *
+ *  structure,operation,pattern,n,ns_per_op,min_ns_per_op,ops_per_s,
+ *  cycles_per_op,instructions_per_op,l1d_misses_per_op,llc_misses_per_op,
+ *  branch_misses_per_op
+ *
+ * n is the size of the structure under test, ns_per_op is the median of the
+ * repetitions, ops_per_s is derived from it.
+ * The hardware counters (perf.h) are the mean over the repetitions, empty
+ * fields when not available.
+ * BENCH_REPS and BENCH_WARMUP can be defined at compile time.
+ * Include it before any system header (it selects clock_gettime and
+ * syscall).
+ *
+ * BenchHist collects latencies in log buckets (BENCH_HIST_SUB buckets for
+ * every power of 2, relative error below 1/BENCH_HIST_SUB) for the
+ * percentiles of the tail.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "perf.h"
+
+#ifndef BENCH_REPS
+#define BENCH_REPS 7
+#endif
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 1
+#endif
+
+/* sub-buckets for every power of 2, must be a power of 2 */
+#define BENCH_HIST_SUB 8
+#define BENCH_HIST_BITS 3 /* log2(BENCH_HIST_SUB) */
+#define BENCH_HIST_BUCKETS (64 * BENCH_HIST_SUB)
+
+typedef struct BenchHist BenchHist;
+
+struct BenchHist {
+    uint64_t count[BENCH_HIST_BUCKETS];
+    uint64_t total; /* number of samples */
+    uint64_t max;   /* exact maximum */
+};
+
+/* Run n operations on the context (or prepare them, as setup) */
+typedef void (*BenchProc)(void *ctx, size_t n);
+
+/* keep the results alive */
+static volatile size_t bench_sink;
+
+/* counters of the measures, opened by bench_header */
+static BenchPerf bench_perf;
+
+static inline double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Print the CSV header and open the hardware counters */
+static inline void bench_header(void)
+{
+    bench_perf_open(&bench_perf);
+
+    printf("structure,operation,pattern,n,ns_per_op,min_ns_per_op,ops_per_s");
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        printf(",%s_per_op", bench_perf_names[e]);
+    }
+    putchar('\n');
+}
+
+/* Internal use.
+ * Insertion sort of the few repetitions.
+ */
+static inline void _bench_sort(double *v, size_t n)
+{
+    for (size_t i=1; i < n; i++){
+        double x = v[i];
+        size_t j = i;
+        for (; j > 0 && v[j-1] > x; j--){
+            v[j] = v[j-1];
+        }
+        v[j] = x;
+    }
+}
+
+/* Measure proc on ops operations and print the CSV line for a structure
+ * of size n.
+ * setup can be NULL, otherwise it is called before every run (untimed).
+ * Return the median ns per operation.
+ */
+static inline double bench_measure(const char *structure,
+                                   const char *operation,
+                                   const char *pattern, size_t n,
+                                   BenchProc setup, BenchProc proc,
+                                   void *ctx, size_t ops)
+{
+    double t[BENCH_REPS];
+
+    for (size_t r=0; r < BENCH_WARMUP; r++){
+        if (setup != NULL){
+            setup(ctx, ops);
+        }
+        proc(ctx, ops);
+    }
+
+    bench_perf_reset(&bench_perf);
+    for (size_t r=0; r < BENCH_REPS; r++){
+        if (setup != NULL){
+            setup(ctx, ops);
+        }
+        bench_perf_start(&bench_perf);
+        double start = bench_now_ns();
+        proc(ctx, ops);
+        t[r] = (bench_now_ns() - start) / (double)ops;
+        bench_perf_stop(&bench_perf);
+    }
+
+    _bench_sort(t, BENCH_REPS);
+    double median = t[BENCH_REPS / 2];
+
+    printf("%s,%s,%s,%zu,%.2f,%.2f,%.0f", structure, operation, pattern, n,
+           median, t[0], (median > 0)?1e9 / median:0.0);
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        if (bench_perf_has(&bench_perf, (BenchPerfEvent)e)){
+            printf(",%.3f", bench_perf.value[e] / ((double)BENCH_REPS * ops));
+        } else {
+            printf(",");
+        }
+    }
+    putchar('\n');
+    fflush(stdout);
+
+    return median;
+}
+
+static inline void bench_hist_init(BenchHist *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+/* Internal use.
+ * Bucket of the value: exact below BENCH_HIST_SUB, then BENCH_HIST_SUB
+ * buckets for every power of 2.
+ */
+static inline size_t _bench_hist_bucket(uint64_t v)
+{
+    if (v < BENCH_HIST_SUB){
+        return (size_t)v;
+    }
+    size_t e = 63 - (size_t)__builtin_clzll(v);
+    size_t sub = (size_t)(v >> (e - BENCH_HIST_BITS)) & (BENCH_HIST_SUB - 1);
+    return (e - BENCH_HIST_BITS + 1) * BENCH_HIST_SUB + sub;
+}
+
+/* Internal use.
+ * Greatest value of the bucket.
+ */
+static inline uint64_t _bench_hist_upper(size_t b)
+{
+    if (b < BENCH_HIST_SUB){
+        return b;
+    }
+    size_t e = b / BENCH_HIST_SUB + BENCH_HIST_BITS - 1;
+    uint64_t low = (uint64_t)(BENCH_HIST_SUB + b % BENCH_HIST_SUB)
+                   << (e - BENCH_HIST_BITS);
+    return low + ((uint64_t)1 << (e - BENCH_HIST_BITS)) - 1;
+}
+
+static inline void bench_hist_add(BenchHist *h, uint64_t v)
+{
+    h->count[_bench_hist_bucket(v)]++;
+    h->total++;
+    h->max = (v > h->max)?v:h->max;
+}
+
+/* Add the samples of src to dst */
+static inline void bench_hist_merge(BenchHist *dst, const BenchHist *src)
+{
+    for (size_t b=0; b < BENCH_HIST_BUCKETS; b++){
+        dst->count[b] += src->count[b];
+    }
+    dst->total += src->total;
+    dst->max = (src->max > dst->max)?src->max:dst->max;
+}
+
+/* Value below which the fraction q of the samples falls (q in [0, 1]),
+ * as the upper bound of its bucket. 0 if there are no samples.
+ */
+static inline uint64_t bench_hist_percentile(const BenchHist *h, double q)
+{
+    uint64_t rank = (uint64_t)(q * (double)h->total + 0.5);
+    rank = (rank == 0)?1:rank;
+    uint64_t seen = 0;
+
+    for (size_t b=0; b < BENCH_HIST_BUCKETS; b++){
+        seen += h->count[b];
+        if (seen >= rank){
+            uint64_t u = _bench_hist_upper(b);
+            return (u < h->max)?u:h->max;
+        }
+    }
+    return h->max;
+}
+
+/* Fill v with a random permutation of [0, n), deterministic for the seed */
+static inline void bench_shuffle(size_t *v, size_t n, uint64_t seed)
+{
+    uint64_t x = seed | 1;
+
+    for (size_t i=0; i < n; i++){
+        v[i] = i;
+    }
+    for (size_t i=n; i > 1; i--){
+        /* xorshift64* */
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        size_t j = (size_t)((x * 0x2545F4914F6CDD1DULL) % i);
+        size_t tmp = v[i-1];
+        v[i-1] = v[j];
+        v[j] = tmp;
+    }
+}
+
+#endif
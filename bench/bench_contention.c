@@ -0,0 +1,276 @@
+/* Benchmark Queue and Object Pool under contention
+ *
+ * The structures are not thread safe, every variant wraps them with a lock:
+ * a pthread mutex (the baseline) or a test-and-test-and-set spinlock.
+ * - queue: the producers enqueue their timestamp, the consumers dequeue it
+ *   and record the hand-off latency (queueing time included);
+ * - objpool: every thread acquires and releases an object in a loop and
+ *   records the latency of the acquire.
+ * The latencies go in per thread log histograms, merged at the end.
+ *
+ * Usage: bench_contention.exe [producers [consumers [ops [pin]]]]
+ * ops are the operations of every producer (every thread for objpool),
+ * pin = 1 pins the thread i to the cpu i % online cpus.
+ * Output: structure,operation,producers,consumers,ops,p50_ns,p99_ns,
+ *         p999_ns,max_ns,ops_per_s
+ */
+
+#define _GNU_SOURCE
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "queue.h"
+#include "objpool.h"
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define QUEUE_SIZE 1024
+#define POOL_SIZE 64
+#define OBJ_SIZE 64
+#define MAX_THREADS 64
+/* spins before yielding the cpu, a waiting thread can hold the lock owner */
+#define SPINS 64
+
+typedef enum {
+    LOCK_MUTEX,
+    LOCK_SPIN
+} LockKind;
+
+typedef struct {
+    LockKind kind;
+    pthread_mutex_t mutex;
+    char spin;
+} Lock;
+
+static
+void lock_acquire(Lock *l)
+{
+    if (l->kind == LOCK_MUTEX){
+        pthread_mutex_lock(&l->mutex);
+        return;
+    }
+    for (size_t i=1; __atomic_test_and_set(&l->spin, __ATOMIC_ACQUIRE); i++){
+        /* wait reading, without bouncing the cache line */
+        while (__atomic_load_n(&l->spin, __ATOMIC_RELAXED)){
+            if (i++ % SPINS == 0){
+                sched_yield();
+            }
+        }
+    }
+}
+
+static
+void lock_release(Lock *l)
+{
+    if (l->kind == LOCK_MUTEX){
+        pthread_mutex_unlock(&l->mutex);
+        return;
+    }
+    __atomic_clear(&l->spin, __ATOMIC_RELEASE);
+}
+
+typedef struct {
+    Lock lock;
+    QueueIndex queue;
+    uint64_t stamps[QUEUE_SIZE];
+    ObjPool pool;
+    size_t consumed;   /* values dequeued, atomic */
+    size_t total;      /* values to produce */
+    size_t ops;        /* operations of every producer */
+    bool pin;
+    pthread_barrier_t start;
+} Shared;
+
+typedef struct {
+    Shared *s;
+    size_t id;
+    BenchHist hist;
+} Worker;
+
+static
+uint64_t now(void)
+{
+    return (uint64_t)bench_now_ns();
+}
+
+static
+void pin_thread(Worker *w)
+{
+    if (!w->s->pin){
+        return;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((int)(w->id % (size_t)((cpus > 0)?cpus:1)), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static
+void * queue_producer(void *arg)
+{
+    Worker *w = arg;
+    Shared *s = w->s;
+
+    pin_thread(w);
+    pthread_barrier_wait(&s->start);
+
+    for (size_t i=0; i < s->ops;){
+        lock_acquire(&s->lock);
+        long k = queue_enqueue(&s->queue);
+        if (k >= 0){
+            s->stamps[k] = now();
+        }
+        lock_release(&s->lock);
+
+        if (k < 0){
+            sched_yield(); /* full */
+        } else {
+            i++;
+        }
+    }
+    return NULL;
+}
+
+static
+void * queue_consumer(void *arg)
+{
+    Worker *w = arg;
+    Shared *s = w->s;
+
+    pin_thread(w);
+    pthread_barrier_wait(&s->start);
+
+    while (__atomic_load_n(&s->consumed, __ATOMIC_RELAXED) < s->total){
+        uint64_t stamp = 0;
+        lock_acquire(&s->lock);
+        long k = queue_dequeue(&s->queue);
+        if (k >= 0){
+            stamp = s->stamps[k];
+        }
+        lock_release(&s->lock);
+
+        if (k < 0){
+            sched_yield(); /* empty */
+            continue;
+        }
+        uint64_t t = now();
+        bench_hist_add(&w->hist, (t > stamp)?t - stamp:0);
+        __atomic_add_fetch(&s->consumed, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static
+void * pool_worker(void *arg)
+{
+    Worker *w = arg;
+    Shared *s = w->s;
+
+    pin_thread(w);
+    pthread_barrier_wait(&s->start);
+
+    for (size_t i=0; i < s->ops;){
+        uint64_t t = now();
+        lock_acquire(&s->lock);
+        void *obj = objpool_acquire(&s->pool);
+        lock_release(&s->lock);
+
+        if (obj == NULL){
+            sched_yield(); /* exhausted */
+            continue;
+        }
+        bench_hist_add(&w->hist, now() - t);
+        i++;
+
+        lock_acquire(&s->lock);
+        objpool_release(&s->pool, obj);
+        lock_release(&s->lock);
+    }
+    return NULL;
+}
+
+static
+void run(const char *structure, LockKind kind, bool queue,
+         size_t producers, size_t consumers, size_t ops, bool pin)
+{
+    static Shared s;
+    static Worker w[MAX_THREADS];
+    static uint8_t arena[OBJPOOL_SIZEOF(POOL_SIZE, OBJ_SIZE)];
+    pthread_t th[MAX_THREADS];
+    size_t nthreads = producers + consumers;
+
+    s.lock.kind = kind;
+    pthread_mutex_init(&s.lock.mutex, NULL);
+    s.lock.spin = 0;
+    queue_init(&s.queue, QUEUE_SIZE);
+    objpool_init(&s.pool, arena, POOL_SIZE, OBJ_SIZE);
+    s.consumed = 0;
+    s.total = producers * ops;
+    s.ops = ops;
+    s.pin = pin;
+    pthread_barrier_init(&s.start, NULL, (unsigned)nthreads + 1);
+
+    for (size_t i=0; i < nthreads; i++){
+        w[i].s = &s;
+        w[i].id = i;
+        bench_hist_init(&w[i].hist);
+
+        void *(*proc)(void *) = pool_worker;
+        if (queue){
+            proc = (i < producers)?queue_producer:queue_consumer;
+        }
+        pthread_create(&th[i], NULL, proc, &w[i]);
+    }
+
+    pthread_barrier_wait(&s.start);
+    double t = bench_now_ns();
+    for (size_t i=0; i < nthreads; i++){
+        pthread_join(th[i], NULL);
+    }
+    t = bench_now_ns() - t;
+
+    BenchHist h;
+    bench_hist_init(&h);
+    for (size_t i=0; i < nthreads; i++){
+        bench_hist_merge(&h, &w[i].hist);
+    }
+
+    printf("%s,%s,%zu,%zu,%zu,%llu,%llu,%llu,%llu,%.0f\n",
+           structure, queue?"handoff":"acquire", producers, consumers, ops,
+           (unsigned long long)bench_hist_percentile(&h, 0.5),
+           (unsigned long long)bench_hist_percentile(&h, 0.99),
+           (unsigned long long)bench_hist_percentile(&h, 0.999),
+           (unsigned long long)h.max,
+           (double)h.total * 1e9 / t);
+    fflush(stdout);
+
+    pthread_barrier_destroy(&s.start);
+    pthread_mutex_destroy(&s.lock.mutex);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t producers = (argc > 1)?strtoul(argv[1], NULL, 10):2;
+    size_t consumers = (argc > 2)?strtoul(argv[2], NULL, 10):2;
+    size_t ops = (argc > 3)?strtoul(argv[3], NULL, 10):100000;
+    bool pin = (argc > 4)?(atoi(argv[4]) != 0):true;
+
+    if (producers == 0 || consumers == 0 || ops == 0 ||
+        producers + consumers > MAX_THREADS){
+        fprintf(stderr, "usage: %s [producers [consumers [ops [pin]]]]\n",
+                argv[0]);
+        return 1;
+    }
+
+    puts("structure,operation,producers,consumers,ops,"
+         "p50_ns,p99_ns,p999_ns,max_ns,ops_per_s");
+
+    run("queue_mutex", LOCK_MUTEX, true, producers, consumers, ops, pin);
+    run("queue_spin", LOCK_SPIN, true, producers, consumers, ops, pin);
+    run("objpool_mutex", LOCK_MUTEX, false, producers, consumers, ops, pin);
+    run("objpool_spin", LOCK_SPIN, false, producers, consumers, ops, pin);
+
+    return 0;
+}
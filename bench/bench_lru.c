@@ -0,0 +1,132 @@
+/* Benchmark the LRU Cache
+ *
+ * A cache of n entries (16 bytes) in the two modes (the patterns):
+ * - strict: a hit moves the entry to the head of the list;
+ * - clock: a hit sets the reference byte (second chance).
+ * Operations, per access:
+ * - get_hit: get of the cached keys in random order;
+ * - put_miss: put of new keys in a full cache, every one evicts;
+ * - mixed: get of keys from a range 2 * n wide, a miss puts the key.
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "lru.h"
+
+typedef struct {
+    uint64_t key;
+    uint64_t value;
+} Entry;
+
+typedef struct {
+    LRUCache *c;
+    void *arena;
+    size_t n;
+    unsigned mode;
+    size_t *order; /* random permutation of 2 * n keys */
+    uint64_t next; /* next new key */
+} LRUBench;
+
+static
+bool entry_match(const void *obj, const void *key)
+{
+    return ((const Entry*)obj)->key == *(const uint64_t*)key;
+}
+
+static
+void put_key(LRUCache *c, uint64_t key)
+{
+    bool found;
+    Entry *e = lru_put(c, hashidx_mix64(key), &key, &found);
+    if (!found){
+        e->key = key;
+    }
+    e->value = key;
+}
+
+static
+void build(void *ctx, size_t n)
+{
+    LRUBench *b = ctx;
+    (void)n;
+    b->c = lru_init(b->arena, b->n, sizeof(Entry), entry_match, b->mode);
+    for (uint64_t key=0; key < b->n; key++){
+        put_key(b->c, key);
+    }
+    b->next = b->n;
+}
+
+static
+void get_hit(void *ctx, size_t n)
+{
+    LRUBench *b = ctx;
+    uint64_t s = 0;
+    for (size_t i=0, k=0; i < n; i++, k++){
+        /* the first half of the permutation is not only the cached keys */
+        while (b->order[k] >= b->n){
+            k++;
+        }
+        uint64_t key = b->order[k];
+        Entry *e = lru_get(b->c, hashidx_mix64(key), &key);
+        s += e->value;
+    }
+    bench_sink = s;
+}
+
+static
+void put_miss(void *ctx, size_t n)
+{
+    LRUBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        put_key(b->c, b->next++);
+    }
+}
+
+static
+void mixed(void *ctx, size_t n)
+{
+    LRUBench *b = ctx;
+    uint64_t s = 0;
+    for (size_t i=0; i < n; i++){
+        uint64_t key = b->order[i];
+        Entry *e = lru_get(b->c, hashidx_mix64(key), &key);
+        if (e != NULL){
+            s += e->value;
+        } else {
+            put_key(b->c, key);
+        }
+    }
+    bench_sink = s;
+}
+
+int main()
+{
+    const size_t sizes[] = {1000, 100000, 1000000};
+    const char *patterns[] = {"strict", "clock"};
+    const unsigned modes[] = {LRU_STRICT, LRU_CLOCK};
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        LRUBench b;
+        b.n = sizes[k];
+        b.arena = malloc(LRU_SIZEOF(b.n, sizeof(Entry)));
+        b.order = malloc(2 * b.n * sizeof(size_t));
+        bench_shuffle(b.order, 2 * b.n, b.n);
+
+        for (size_t p=0; p < sizeof(patterns)/sizeof(patterns[0]); p++){
+            b.mode = modes[p];
+            bench_measure("lru", "get_hit", patterns[p], b.n,
+                          build, get_hit, &b, b.n);
+            bench_measure("lru", "put_miss", patterns[p], b.n,
+                          build, put_miss, &b, b.n);
+            bench_measure("lru", "mixed", patterns[p], b.n,
+                          build, mixed, &b, 2 * b.n);
+        }
+
+        free(b.order);
+        free(b.arena);
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+/* Benchmark Object Pool against malloc/free
+ *
+ * Acquire and release n objects of OBJ_SIZE bytes, the release order is
+ * the pattern: lifo, fifo or random. The acquire follows the free list left
+ * by the previous release, so the pattern matters for it too.
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "objpool.h"
+#include <stdbool.h>
+
+#define OBJ_SIZE 64
+
+typedef struct {
+    unsigned char data[OBJ_SIZE];
+} Obj;
+
+DS_DEFINE_POOL(TypedPool, Obj)
+
+typedef enum {
+    KIND_OBJPOOL,
+    KIND_TYPED,
+    KIND_MALLOC
+} Kind;
+
+typedef struct {
+    Kind kind;
+    ObjPool pool;
+    TypedPool typed;
+    void **objs;    /* acquired objects */
+    size_t *order;  /* release order, indexes of objs */
+    bool acquired;  /* objs are live */
+} PoolBench;
+
+static
+void acquire_all(void *ctx, size_t n)
+{
+    PoolBench *b = ctx;
+
+    switch (b->kind){
+    case KIND_OBJPOOL:
+        for (size_t i=0; i < n; i++){
+            b->objs[i] = objpool_acquire(&b->pool);
+        }
+        break;
+    case KIND_TYPED:
+        for (size_t i=0; i < n; i++){
+            b->objs[i] = TypedPool_acquire(&b->typed);
+        }
+        break;
+    case KIND_MALLOC:
+        for (size_t i=0; i < n; i++){
+            b->objs[i] = malloc(OBJ_SIZE);
+        }
+        break;
+    }
+    b->acquired = true;
+}
+
+static
+void release_all(void *ctx, size_t n)
+{
+    PoolBench *b = ctx;
+
+    switch (b->kind){
+    case KIND_OBJPOOL:
+        for (size_t i=0; i < n; i++){
+            objpool_release(&b->pool, b->objs[b->order[i]]);
+        }
+        break;
+    case KIND_TYPED:
+        for (size_t i=0; i < n; i++){
+            TypedPool_release(&b->typed, b->objs[b->order[i]]);
+        }
+        break;
+    case KIND_MALLOC:
+        for (size_t i=0; i < n; i++){
+            free(b->objs[b->order[i]]);
+        }
+        break;
+    }
+    b->acquired = false;
+}
+
+static
+void setup_acquire(void *ctx, size_t n)
+{
+    PoolBench *b = ctx;
+    if (b->acquired){
+        release_all(b, n);
+    }
+}
+
+static
+void setup_release(void *ctx, size_t n)
+{
+    PoolBench *b = ctx;
+    if (!b->acquired){
+        acquire_all(b, n);
+    }
+}
+
+static
+void set_order(size_t *order, size_t n, const char *pattern)
+{
+    if (pattern[0] == 'r'){
+        bench_shuffle(order, n, n);
+        return;
+    }
+    for (size_t i=0; i < n; i++){
+        order[i] = (pattern[0] == 'l')?n - 1 - i:i;
+    }
+}
+
+int main()
+{
+    const size_t sizes[] = {1000, 100000, 1000000};
+    const char *patterns[] = {"lifo", "fifo", "random"};
+    const char *names[] = {"objpool", "typedpool", "malloc"};
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        size_t n = sizes[k];
+        void *arena = malloc(OBJPOOL_SIZEOF(n, sizeof(Obj)));
+        TypedPoolSlot *slots = malloc(n * sizeof(TypedPoolSlot));
+        PoolBench b;
+        b.objs = malloc(n * sizeof(void *));
+        b.order = malloc(n * sizeof(size_t));
+
+        for (size_t p=0; p < sizeof(patterns)/sizeof(patterns[0]); p++){
+            set_order(b.order, n, patterns[p]);
+
+            for (Kind kind=KIND_OBJPOOL; kind <= KIND_MALLOC; kind++){
+                b.kind = kind;
+                b.acquired = false;
+                objpool_init(&b.pool, arena, n, sizeof(Obj));
+                TypedPool_init(&b.typed, slots, n);
+
+                bench_measure(names[kind], "acquire", patterns[p], n,
+                              setup_acquire, acquire_all, &b, n);
+                bench_measure(names[kind], "release", patterns[p], n,
+                              setup_release, release_all, &b, n);
+                setup_acquire(&b, n);
+            }
+        }
+
+        free(b.order);
+        free(b.objs);
+        free(slots);
+        free(arena);
+    }
+
+    return 0;
+}
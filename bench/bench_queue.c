@@ -0,0 +1,199 @@
+/* Benchmark Queue
+ *
+ * QueueIndex on an int array and the typed DS_DEFINE_QUEUE.
+ * Patterns:
+ * - burst: enqueue n values in the empty queue, dequeue n from the full one;
+ * - steady: n pairs of enqueue and dequeue on a half full queue;
+ * - batch: as burst, BATCH values for every call (typed only).
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "queue.h"
+
+#define BATCH 64
+
+DS_DEFINE_QUEUE(IntQueue, int)
+
+typedef struct {
+    QueueIndex index;
+    IntQueue typed;
+    int *values;
+    int *src;   /* BATCH values to copy */
+} QueueBench;
+
+static
+void index_reset(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    queue_init(&b->index, n);
+}
+
+static
+void index_enqueue(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        long k = queue_enqueue(&b->index);
+        b->values[k] = (int)i;
+    }
+}
+
+static
+void index_dequeue(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        long k = queue_dequeue(&b->index);
+        s += (size_t)b->values[k];
+    }
+    bench_sink = s;
+}
+
+static
+void index_fill(void *ctx, size_t n)
+{
+    index_reset(ctx, n);
+    index_enqueue(ctx, n);
+}
+
+static
+void index_half(void *ctx, size_t n)
+{
+    index_reset(ctx, n);
+    index_enqueue(ctx, n / 2);
+}
+
+static
+void index_steady(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        long k = queue_enqueue(&b->index);
+        b->values[k] = (int)i;
+        k = queue_dequeue(&b->index);
+        s += (size_t)b->values[k];
+    }
+    bench_sink = s;
+}
+
+static
+void typed_reset(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    IntQueue_init(&b->typed, b->values, n);
+}
+
+static
+void typed_enqueue(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        IntQueue_push(&b->typed, (int)i);
+    }
+}
+
+static
+void typed_dequeue(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        int v = 0;
+        IntQueue_pop(&b->typed, &v);
+        s += (size_t)v;
+    }
+    bench_sink = s;
+}
+
+static
+void typed_fill(void *ctx, size_t n)
+{
+    typed_reset(ctx, n);
+    typed_enqueue(ctx, n);
+}
+
+static
+void typed_half(void *ctx, size_t n)
+{
+    typed_reset(ctx, n);
+    typed_enqueue(ctx, n / 2);
+}
+
+static
+void typed_steady(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        int v = 0;
+        IntQueue_push(&b->typed, (int)i);
+        IntQueue_pop(&b->typed, &v);
+        s += (size_t)v;
+    }
+    bench_sink = s;
+}
+
+static
+void typed_enqueue_n(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    for (size_t i=0; i < n; i += BATCH){
+        IntQueue_push_n(&b->typed, b->src, BATCH);
+    }
+}
+
+static
+void typed_dequeue_n(void *ctx, size_t n)
+{
+    QueueBench *b = ctx;
+    int dst[BATCH];
+    size_t s = 0;
+    for (size_t i=0; i < n; i += BATCH){
+        IntQueue_pop_n(&b->typed, dst, BATCH);
+        s += (size_t)dst[0];
+    }
+    bench_sink = s;
+}
+
+int main()
+{
+    /* multiple of BATCH */
+    const size_t sizes[] = {1024, 131072, 1048576};
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        size_t n = sizes[k];
+        QueueBench b = {.values = malloc(n * sizeof(int)),
+                        .src = malloc(BATCH * sizeof(int))};
+        for (int i=0; i < BATCH; i++){
+            b.src[i] = i;
+        }
+
+        bench_measure("queue", "enqueue", "burst", n,
+                      index_reset, index_enqueue, &b, n);
+        bench_measure("queue", "dequeue", "burst", n,
+                      index_fill, index_dequeue, &b, n);
+        bench_measure("queue", "enqueue_dequeue", "steady", n,
+                      index_half, index_steady, &b, n);
+
+        bench_measure("typedqueue", "enqueue", "burst", n,
+                      typed_reset, typed_enqueue, &b, n);
+        bench_measure("typedqueue", "dequeue", "burst", n,
+                      typed_fill, typed_dequeue, &b, n);
+        bench_measure("typedqueue", "enqueue_dequeue", "steady", n,
+                      typed_half, typed_steady, &b, n);
+        bench_measure("typedqueue", "enqueue", "batch", n,
+                      typed_reset, typed_enqueue_n, &b, n);
+        bench_measure("typedqueue", "dequeue", "batch", n,
+                      typed_fill, typed_dequeue_n, &b, n);
+
+        free(b.src);
+        free(b.values);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+/* Benchmark Skip List against a sorted SList
+ *
+ * Ordered lookups and range scans (SCAN_LEN values) on n random keys,
+ * LOOKUPS probes, half of them missing. The SList is built with a single
+ * sort, inserts would be O(n^2), and its lookups are O(n): it runs only
+ * SLIST_LOOKUPS probes.
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "skiplist.h"
+#include "slist.h"
+
+#define LOOKUPS 2000
+#define SLIST_LOOKUPS 200
+#define SCAN_LEN 100
+
+typedef struct {
+    SkipList *sl;
+    SList *list;
+    void *arena;
+    const long *keys;
+    const long *probes;
+} SkipBench;
+
+static
+int key_cmp(const void *a, const void *b)
+{
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static
+void skiplist_reset(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    b->sl = skiplist_init(b->arena, n, key_cmp, 1);
+}
+
+static
+void skiplist_build(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    skiplist_reset(ctx, n);
+    for (size_t i=0; i < n; i++){
+        skiplist_insert(b->sl, (void*)&b->keys[i]);
+    }
+}
+
+static
+void skiplist_find_all(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    long s = 0;
+    for (size_t i=0; i < n; i++){
+        const long *v = skiplist_find(b->sl, &b->probes[i]);
+        s += (v != NULL)?*v:0;
+    }
+    bench_sink = (size_t)s;
+}
+
+static
+void skiplist_scan(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    long s = 0;
+    for (size_t i=0; i < n; i++){
+        SkipListIter it;
+        const long *v = skiplist_seek(&it, b->sl, &b->probes[i]);
+        for (size_t j=0; j < SCAN_LEN && v != NULL; j++){
+            s += *v;
+            skiplist_next(&it);
+            v = skiplist_value(it);
+        }
+    }
+    bench_sink = (size_t)s;
+}
+
+static
+void skiplist_delete_all(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        skiplist_delete(b->sl, &b->keys[i]);
+    }
+}
+
+static
+void slist_build(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    b->list = slist_init(b->arena, n);
+    for (size_t i=0; i < n; i++){
+        slist_push(b->list, (void*)&b->keys[i]);
+    }
+    slist_sort(b->list, key_cmp);
+}
+
+/* the search stops at the first value not less than the key */
+static
+const long * slist_lower_bound(SListIter *it, SList *list, long key)
+{
+    const long *v = slist_iter(it, list);
+    while (v != NULL && *v < key){
+        slist_next(it);
+        v = slist_value(*it);
+    }
+    return v;
+}
+
+static
+void slist_find_all(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    SListIter it;
+    long s = 0;
+    for (size_t i=0; i < n; i++){
+        const long *v = slist_lower_bound(&it, b->list, b->probes[i]);
+        s += (v != NULL && *v == b->probes[i])?*v:0;
+    }
+    bench_sink = (size_t)s;
+}
+
+static
+void slist_scan(void *ctx, size_t n)
+{
+    SkipBench *b = ctx;
+    SListIter it;
+    long s = 0;
+    for (size_t i=0; i < n; i++){
+        const long *v = slist_lower_bound(&it, b->list, b->probes[i]);
+        for (size_t j=0; j < SCAN_LEN && v != NULL; j++){
+            s += *v;
+            slist_next(&it);
+            v = slist_value(it);
+        }
+    }
+    bench_sink = (size_t)s;
+}
+
+int main()
+{
+    const size_t sizes[] = {1000, 10000, 100000};
+    char scan[32];
+
+    snprintf(scan, sizeof(scan), "scan%d", SCAN_LEN);
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        size_t n = sizes[k];
+        long *keys = (long*)malloc(n * sizeof(long));
+        long *probes = (long*)malloc(LOOKUPS * sizeof(long));
+        size_t bytes = SKIPLIST_SIZEOF(n);
+        bytes = (bytes > SLIST_SIZEOF(n))?bytes:SLIST_SIZEOF(n);
+        SkipBench b = {.arena = malloc(bytes), .keys = keys, .probes = probes};
+
+        /* random keys, half of the probes are missing */
+        srand(1);
+        for (size_t i=0; i < n; i++){
+            keys[i] = rand();
+        }
+        for (size_t i=0; i < LOOKUPS; i++){
+            probes[i] = (i % 2)?keys[(size_t)rand() % n]:rand();
+        }
+
+        bench_measure("skiplist", "insert", "random", n,
+                      skiplist_reset, skiplist_build, &b, n);
+        bench_measure("skiplist", "find", "random", n,
+                      NULL, skiplist_find_all, &b, LOOKUPS);
+        bench_measure("skiplist", scan, "random", n,
+                      NULL, skiplist_scan, &b, LOOKUPS);
+        bench_measure("skiplist", "delete", "random", n,
+                      skiplist_build, skiplist_delete_all, &b, n);
+
+        bench_measure("slist", "insert", "random", n,
+                      NULL, slist_build, &b, n);
+        bench_measure("slist", "find", "random", n,
+                      NULL, slist_find_all, &b, SLIST_LOOKUPS);
+        bench_measure("slist", scan, "random", n,
+                      NULL, slist_scan, &b, SLIST_LOOKUPS);
+
+        free(b.arena);
+        free(probes);
+        free(keys);
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/* Benchmark Single Linked List
+ *
+ * Push and pop at the head, traversal with the iterator, slist_foreach and
+ * slist_gather. Patterns:
+ * - sequential: the list order follows the items order in the arena;
+ * - shuffled: the list order is a random permutation of the arena (as after
+ *   many inserts and deletes), every step is a cache miss on big lists.
+ * The push reuses the free list left by popping the list of the pattern.
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "slist.h"
+
+#define BATCH 16
+
+typedef struct {
+    SList *list;
+    void *arena;
+    size_t *keys;  /* key of the value i, the list is sorted by key */
+} SListBench;
+
+static
+int key_cmp(const void *a, const void *b)
+{
+    size_t x = *(const size_t*)a;
+    size_t y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* the item i holds &keys[i], sorting relinks the items in keys order */
+static
+void build(void *ctx, size_t n)
+{
+    SListBench *b = ctx;
+    b->list = slist_init(b->arena, n);
+    for (size_t i=0; i < n; i++){
+        slist_push(b->list, &b->keys[i]);
+    }
+    slist_sort(b->list, key_cmp);
+}
+
+static
+void pop(void *ctx, size_t n)
+{
+    SListBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        s += *(size_t*)slist_pop(b->list);
+    }
+    bench_sink = s;
+}
+
+static
+void setup_push(void *ctx, size_t n)
+{
+    build(ctx, n);
+    pop(ctx, n);
+}
+
+static
+void push(void *ctx, size_t n)
+{
+    SListBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        slist_push(b->list, &b->keys[i]);
+    }
+}
+
+static
+void traverse(void *ctx, size_t n)
+{
+    SListBench *b = ctx;
+    SListIter it;
+    size_t s = 0;
+    (void)n;
+    for (size_t *v = slist_iter(&it, b->list); v != NULL; v = slist_value(it)){
+        s += *v;
+        slist_next(&it);
+    }
+    bench_sink = s;
+}
+
+static
+bool visit(void *value, void *ctx)
+{
+    *(size_t*)ctx += *(size_t*)value;
+    return true;
+}
+
+static
+void foreach(void *ctx, size_t n)
+{
+    SListBench *b = ctx;
+    size_t s = 0;
+    (void)n;
+    slist_foreach(b->list, visit, &s);
+    bench_sink = s;
+}
+
+static
+void gather(void *ctx, size_t n)
+{
+    SListBench *b = ctx;
+    SListIter it;
+    void *values[BATCH];
+    size_t s = 0;
+    (void)n;
+    if (slist_iter(&it, b->list) == NULL){
+        return;
+    }
+    for (size_t k; (k = slist_gather(&it, values, BATCH)) > 0;){
+        for (size_t j=0; j < k; j++){
+            s += *(size_t*)values[j];
+        }
+    }
+    bench_sink = s;
+}
+
+int main()
+{
+    const size_t sizes[] = {1000, 100000, 1000000};
+    const char *patterns[] = {"sequential", "shuffled"};
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        size_t n = sizes[k];
+        SListBench b;
+        b.arena = malloc(SLIST_SIZEOF(n));
+        b.keys = malloc(n * sizeof(size_t));
+
+        for (size_t p=0; p < sizeof(patterns)/sizeof(patterns[0]); p++){
+            if (p == 0){
+                for (size_t i=0; i < n; i++){
+                    b.keys[i] = i;
+                }
+            } else {
+                bench_shuffle(b.keys, n, n);
+            }
+
+            bench_measure("slist", "push", patterns[p], n,
+                          setup_push, push, &b, n);
+            bench_measure("slist", "pop", patterns[p], n, build, pop, &b, n);
+
+            build(&b, n);
+            bench_measure("slist", "traverse", patterns[p], n,
+                          NULL, traverse, &b, n);
+            bench_measure("slist", "foreach", patterns[p], n,
+                          NULL, foreach, &b, n);
+            bench_measure("slist", "gather", patterns[p], n,
+                          NULL, gather, &b, n);
+        }
+
+        free(b.keys);
+        free(b.arena);
+    }
+
+    return 0;
+}
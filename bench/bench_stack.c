@@ -0,0 +1,199 @@
+/* Benchmark Stack
+ *
+ * StackIndex on an int array and the typed DS_DEFINE_STACK.
+ * Patterns:
+ * - burst: push n values on the empty stack, pop n from the full one;
+ * - steady: n pairs of push and pop on a half full stack;
+ * - batch: as burst, BATCH values for every call (typed only).
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "stack.h"
+
+#define BATCH 64
+
+DS_DEFINE_STACK(IntStack, int)
+
+typedef struct {
+    StackIndex index;
+    IntStack typed;
+    int *values;
+    int *src;   /* BATCH values to copy */
+} StackBench;
+
+static
+void index_reset(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    stack_init(&b->index, n);
+}
+
+static
+void index_push(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        long k = stack_push(&b->index);
+        b->values[k] = (int)i;
+    }
+}
+
+static
+void index_pop(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        long k = stack_pop(&b->index);
+        s += (size_t)b->values[k];
+    }
+    bench_sink = s;
+}
+
+static
+void index_fill(void *ctx, size_t n)
+{
+    index_reset(ctx, n);
+    index_push(ctx, n);
+}
+
+static
+void index_half(void *ctx, size_t n)
+{
+    index_reset(ctx, n);
+    index_push(ctx, n / 2);
+}
+
+static
+void index_steady(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        long k = stack_push(&b->index);
+        b->values[k] = (int)i;
+        k = stack_pop(&b->index);
+        s += (size_t)b->values[k];
+    }
+    bench_sink = s;
+}
+
+static
+void typed_reset(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    IntStack_init(&b->typed, b->values, n);
+}
+
+static
+void typed_push(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        IntStack_push(&b->typed, (int)i);
+    }
+}
+
+static
+void typed_pop(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        int v = 0;
+        IntStack_pop(&b->typed, &v);
+        s += (size_t)v;
+    }
+    bench_sink = s;
+}
+
+static
+void typed_fill(void *ctx, size_t n)
+{
+    typed_reset(ctx, n);
+    typed_push(ctx, n);
+}
+
+static
+void typed_half(void *ctx, size_t n)
+{
+    typed_reset(ctx, n);
+    typed_push(ctx, n / 2);
+}
+
+static
+void typed_steady(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        int v = 0;
+        IntStack_push(&b->typed, (int)i);
+        IntStack_pop(&b->typed, &v);
+        s += (size_t)v;
+    }
+    bench_sink = s;
+}
+
+static
+void typed_push_n(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    for (size_t i=0; i < n; i += BATCH){
+        IntStack_push_n(&b->typed, b->src, BATCH);
+    }
+}
+
+static
+void typed_pop_n(void *ctx, size_t n)
+{
+    StackBench *b = ctx;
+    int dst[BATCH];
+    size_t s = 0;
+    for (size_t i=0; i < n; i += BATCH){
+        IntStack_pop_n(&b->typed, dst, BATCH);
+        s += (size_t)dst[0];
+    }
+    bench_sink = s;
+}
+
+int main()
+{
+    /* multiple of BATCH */
+    const size_t sizes[] = {1024, 131072, 1048576};
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        size_t n = sizes[k];
+        StackBench b = {.values = malloc(n * sizeof(int)),
+                        .src = malloc(BATCH * sizeof(int))};
+        for (int i=0; i < BATCH; i++){
+            b.src[i] = i;
+        }
+
+        bench_measure("stack", "push", "burst", n,
+                      index_reset, index_push, &b, n);
+        bench_measure("stack", "pop", "burst", n,
+                      index_fill, index_pop, &b, n);
+        bench_measure("stack", "push_pop", "steady", n,
+                      index_half, index_steady, &b, n);
+
+        bench_measure("typedstack", "push", "burst", n,
+                      typed_reset, typed_push, &b, n);
+        bench_measure("typedstack", "pop", "burst", n,
+                      typed_fill, typed_pop, &b, n);
+        bench_measure("typedstack", "push_pop", "steady", n,
+                      typed_half, typed_steady, &b, n);
+        bench_measure("typedstack", "push", "batch", n,
+                      typed_reset, typed_push_n, &b, n);
+        bench_measure("typedstack", "pop", "batch", n,
+                      typed_fill, typed_pop_n, &b, n);
+
+        free(b.src);
+        free(b.values);
+    }
+
+    return 0;
+}
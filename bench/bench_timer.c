@@ -0,0 +1,202 @@
+/* Benchmark the Timer Wheel against a Heap of deadlines
+ *
+ * n timers with distinct random deadlines, the heap (heap.h) orders the ids
+ * by their deadline in an array. Operations, per timer:
+ * - schedule: insert the n timers in an empty structure;
+ * - cancel: remove the n timers in random order;
+ * - expire: advance the time in TICKS steps up to the last deadline,
+ *   expiring all the timers (the heap pops while the top is due).
+ * Patterns, the span of the deadlines from the start:
+ * - near: 256 ticks, in the first levels of the wheel;
+ * - far: 2^20 ticks, most timers cascade down 2 or 3 levels.
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "timerwheel.h"
+#include "heap.h"
+
+/* advances of the expire operation, at most one per tick */
+#define TICKS 1024
+
+typedef struct {
+    size_t n;
+    uint64_t span;
+    uint64_t *deadlines; /* deadline of the timer i */
+    size_t *order;       /* random permutation of the timers */
+    size_t *handles;     /* handle of the timer i in the wheel */
+    void *wheel_arena;
+    void *heap_arena;
+    TimerWheel *tw;
+    HeapIndex *heap;
+} TimerBench;
+
+static
+int deadline_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static
+void wheel_reset(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    (void)n;
+    b->tw = timerwheel_init(b->wheel_arena, b->n, 0);
+}
+
+static
+void wheel_schedule(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        b->handles[i] = timerwheel_schedule(b->tw, b->deadlines[i]);
+    }
+}
+
+static
+void wheel_build(void *ctx, size_t n)
+{
+    wheel_reset(ctx, n);
+    wheel_schedule(ctx, n);
+}
+
+static
+void wheel_cancel(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        s += timerwheel_cancel(b->tw, b->handles[b->order[i]]);
+    }
+    bench_sink = s;
+}
+
+static
+void on_expire(size_t handle, uint64_t now, void *ctx)
+{
+    *(size_t*)ctx += handle + (size_t)now;
+}
+
+static
+void wheel_expire(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    size_t s = 0;
+    (void)n;
+    uint64_t step = (b->span > TICKS)?b->span / TICKS:1;
+    for (uint64_t now = 0; now < b->span; ){
+        now += step;
+        timerwheel_advance(b->tw, now, on_expire, &s);
+    }
+    bench_sink = s;
+}
+
+static
+void heap_reset(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    (void)n;
+    b->heap = heap_init(b->heap_arena, b->n, b->deadlines, sizeof(uint64_t),
+                        deadline_cmp);
+}
+
+static
+void heap_schedule(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    for (size_t i=0; i < n; i++){
+        heap_push(b->heap, i);
+    }
+}
+
+static
+void heap_build(void *ctx, size_t n)
+{
+    heap_reset(ctx, n);
+    heap_schedule(ctx, n);
+}
+
+static
+void heap_cancel(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    size_t s = 0;
+    for (size_t i=0; i < n; i++){
+        s += heap_remove(b->heap, b->order[i]);
+    }
+    bench_sink = s;
+}
+
+static
+void heap_expire(void *ctx, size_t n)
+{
+    TimerBench *b = ctx;
+    size_t s = 0;
+    (void)n;
+    uint64_t step = (b->span > TICKS)?b->span / TICKS:1;
+    for (uint64_t now = 0; now < b->span; ){
+        now += step;
+        for (size_t id = heap_top(b->heap);
+             id != HEAP_NIL && b->deadlines[id] <= now;
+             id = heap_top(b->heap)){
+            heap_pop(b->heap);
+            s += id + (size_t)now;
+        }
+    }
+    bench_sink = s;
+}
+
+int main()
+{
+    const size_t sizes[] = {1000, 100000, 1000000};
+    const char *patterns[] = {"near", "far"};
+    const uint64_t spans[] = {256, (uint64_t)1 << 20};
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(sizes)/sizeof(sizes[0]); k++){
+        size_t n = sizes[k];
+        TimerBench b;
+        b.n = n;
+        b.deadlines = malloc(n * sizeof(uint64_t));
+        b.order = malloc(n * sizeof(size_t));
+        b.handles = malloc(n * sizeof(size_t));
+        b.wheel_arena = malloc(TIMERWHEEL_SIZEOF(n));
+        b.heap_arena = malloc(HEAP_SIZEOF(n));
+
+        for (size_t p=0; p < sizeof(patterns)/sizeof(patterns[0]); p++){
+            b.span = spans[p];
+            /* deadlines in (0, span], spread in random order */
+            bench_shuffle(b.order, n, n + p);
+            for (size_t i=0; i < n; i++){
+                b.deadlines[i] = 1 + b.order[i] * (b.span - 1) / n;
+            }
+            bench_shuffle(b.order, n, 2 * n + p);
+
+            bench_measure("timerwheel", "schedule", patterns[p], n,
+                          wheel_reset, wheel_schedule, &b, n);
+            bench_measure("timerwheel", "cancel", patterns[p], n,
+                          wheel_build, wheel_cancel, &b, n);
+            bench_measure("timerwheel", "expire", patterns[p], n,
+                          wheel_build, wheel_expire, &b, n);
+
+            bench_measure("heap", "schedule", patterns[p], n,
+                          heap_reset, heap_schedule, &b, n);
+            bench_measure("heap", "cancel", patterns[p], n,
+                          heap_build, heap_cancel, &b, n);
+            bench_measure("heap", "expire", patterns[p], n,
+                          heap_build, heap_expire, &b, n);
+        }
+
+        free(b.heap_arena);
+        free(b.wheel_arena);
+        free(b.handles);
+        free(b.order);
+        free(b.deadlines);
+    }
+
+    return 0;
+}
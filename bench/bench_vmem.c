@@ -0,0 +1,156 @@
+/* Benchmark the Virtual Memory regions
+ *
+ * Patterns, the kind of pages of the region:
+ * - normal: 4 KB pages faulted in at the first touch;
+ * - populate: normal pages faulted in by the map (MAP_POPULATE);
+ * - prefault: normal pages faulted in by vmem_prefault with THREADS threads;
+ * - thp: transparent huge pages;
+ * - hugetlb: explicit huge pages, skipped if none is reserved.
+ * Operations:
+ * - first_touch: map the region and write every 4 KB page, per page;
+ * - traverse: iterate a shuffled SList whose items and values are in the
+ *   region, every step is a cache miss and often a TLB miss.
+ */
+
+#include "bench.h"
+#define DS_IMPLEMENTATION
+#include "vmem.h"
+#include "arena.h"
+#include "slist.h"
+
+#define REGION ((size_t)64 << 20)
+#define TOUCH_PAGE 4096
+#define ITEMS ((size_t)1 << 20)
+#define THREADS 4
+
+typedef struct {
+    unsigned flags;
+    size_t threads;  /* prefault threads, 0 for none */
+    VMem m;
+    SList *list;
+} VMemBench;
+
+static
+int key_cmp(const void *a, const void *b)
+{
+    size_t x = *(const size_t*)a;
+    size_t y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+static
+void unmap(void *ctx, size_t n)
+{
+    VMemBench *b = ctx;
+    (void)n;
+    vmem_unmap(&b->m);
+}
+
+static
+void first_touch(void *ctx, size_t n)
+{
+    VMemBench *b = ctx;
+    vmem_map(&b->m, n * TOUCH_PAGE, b->flags);
+    if (b->threads > 0){
+        vmem_prefault(&b->m, b->threads);
+    }
+    volatile uint8_t *p = b->m.base;
+    for (size_t i=0; i < n; i++){
+        p[i * TOUCH_PAGE] = 1;
+    }
+}
+
+static
+void traverse(void *ctx, size_t n)
+{
+    VMemBench *b = ctx;
+    SListIter it;
+    size_t s = 0;
+    (void)n;
+    for (size_t *v = slist_iter(&it, b->list); v != NULL; v = slist_value(it)){
+        s += *v;
+        slist_next(&it);
+    }
+    bench_sink = s;
+}
+
+/* the list with the keys in a shuffled order, all in the region */
+static
+bool build(VMemBench *b, size_t n)
+{
+    Arena a = {NULL, 0, 0, 0};
+    if (!vmem_map(&b->m, ARENA_SIZEOF(SLIST_SIZEOF(n)) +
+                         ARENA_SIZEOF(n * sizeof(size_t)), b->flags)){
+        return false;
+    }
+    arena_init(&a, b->m.base, b->m.size);
+
+    b->list = slist_init(arena_push(&a, SLIST_SIZEOF(n)), n);
+    size_t *keys = arena_push(&a, n * sizeof(size_t));
+    bench_shuffle(keys, n, n);
+    for (size_t i=0; i < n; i++){
+        slist_push(b->list, &keys[i]);
+    }
+    slist_sort(b->list, key_cmp);
+    return true;
+}
+
+/* pattern name from the flags applied */
+static
+const char * pattern(const VMemBench *b)
+{
+    if (b->m.flags & VMEM_HUGETLB){
+        return "hugetlb";
+    }
+    if (b->m.flags & VMEM_THP){
+        return "thp";
+    }
+    if (b->m.flags & VMEM_POPULATE){
+        return "populate";
+    }
+    return (b->threads > 0)?"prefault":"normal";
+}
+
+int main()
+{
+    const VMemBench variants[] = {
+        {.flags = 0},
+        {.flags = VMEM_POPULATE},
+        {.flags = 0, .threads = THREADS},
+        {.flags = VMEM_THP},
+        {.flags = VMEM_HUGETLB}
+    };
+
+    bench_header();
+
+    for (size_t k=0; k < sizeof(variants)/sizeof(variants[0]); k++){
+        VMemBench b = variants[k];
+        size_t pages = REGION / TOUCH_PAGE;
+
+        /* the flags applied are known after a map */
+        if (!vmem_map(&b.m, TOUCH_PAGE, b.flags)){
+            return 1;
+        }
+        const char *name = pattern(&b);
+        bool applied = (b.m.flags == b.flags);
+        vmem_unmap(&b.m);
+        if (!applied){
+            fprintf(stderr, "vmem: %s pages not available, skipped\n",
+                    (b.flags & VMEM_HUGETLB)?"hugetlb":"thp");
+            continue;
+        }
+
+        bench_measure("vmem", "first_touch", name, REGION, unmap,
+                      first_touch, &b, pages);
+        vmem_unmap(&b.m);
+
+        if (!build(&b, ITEMS)){
+            return 1;
+        }
+        bench_measure("vmem", "traverse", name, ITEMS, NULL, traverse, &b,
+                      ITEMS);
+        vmem_unmap(&b.m);
+    }
+
+    return 0;
+}
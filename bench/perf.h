@@ -0,0 +1,177 @@
+#ifndef _DS_BENCH_PERF_H
+#define _DS_BENCH_PERF_H
+
+/* Hardware performance counters for the benchmarks
+ * Namespace: bench_perf
+ *
+ * Linux perf_event_open wrapper counting, for the calling thread in user
+ * space: cycles, instructions, L1 data cache read misses, last level cache
+ * misses and branch misses.
+ * Every counter is opened on its own: the ones not supported (containers,
+ * virtual machines, perf_event_paranoid > 2) are reported as unavailable
+ * and the others keep working. Without any counter (or on other systems)
+ * the procedures do nothing. Set BENCH_PERF=0 in the environment to skip
+ * the counters.
+ * The values are scaled when the kernel multiplexes the counters.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BENCH_PERF_LINUX 1
+#endif
+
+typedef enum {
+    BENCH_PERF_CYCLES,
+    BENCH_PERF_INSTRUCTIONS,
+    BENCH_PERF_L1D_MISSES,
+    BENCH_PERF_LLC_MISSES,
+    BENCH_PERF_BRANCH_MISSES,
+    BENCH_PERF_COUNT
+} BenchPerfEvent;
+
+/* CSV names of the counters */
+static const char *const bench_perf_names[BENCH_PERF_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+typedef struct BenchPerf BenchPerf;
+
+struct BenchPerf {
+    int fd[BENCH_PERF_COUNT];           /* -1 if not available */
+    double value[BENCH_PERF_COUNT];     /* accumulated since the reset */
+};
+
+/* Open the counters, disabled.
+ * Return the number of available counters.
+ */
+static inline size_t bench_perf_open(BenchPerf *p)
+{
+    size_t n = 0;
+
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        p->fd[e] = -1;
+        p->value[e] = 0;
+    }
+
+#ifdef BENCH_PERF_LINUX
+    const char *env = getenv("BENCH_PERF");
+    if (env != NULL && strcmp(env, "0") == 0){
+        return 0;
+    }
+
+    static const uint32_t type[BENCH_PERF_COUNT] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+    };
+    static const uint64_t config[BENCH_PERF_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type[e];
+        attr.config = config[e];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd >= 0){
+            p->fd[e] = (int)fd;
+            n++;
+        }
+    }
+#endif
+
+    return n;
+}
+
+static inline void bench_perf_close(BenchPerf *p)
+{
+#ifdef BENCH_PERF_LINUX
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        if (p->fd[e] >= 0){
+            close(p->fd[e]);
+            p->fd[e] = -1;
+        }
+    }
+#else
+    (void)p;
+#endif
+}
+
+/* Return true if the counter is available */
+static inline bool bench_perf_has(const BenchPerf *p, BenchPerfEvent e)
+{
+    return p->fd[e] >= 0;
+}
+
+/* Clear the accumulated values */
+static inline void bench_perf_reset(BenchPerf *p)
+{
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        p->value[e] = 0;
+    }
+}
+
+/* Start counting */
+static inline void bench_perf_start(BenchPerf *p)
+{
+#ifdef BENCH_PERF_LINUX
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        if (p->fd[e] >= 0){
+            ioctl(p->fd[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(p->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)p;
+#endif
+}
+
+/* Stop counting and add the counts to the values */
+static inline void bench_perf_stop(BenchPerf *p)
+{
+#ifdef BENCH_PERF_LINUX
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        if (p->fd[e] >= 0){
+            ioctl(p->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t e=0; e < BENCH_PERF_COUNT; e++){
+        /* value, time enabled, time running */
+        uint64_t v[3];
+        if (p->fd[e] < 0 || read(p->fd[e], v, sizeof(v)) != sizeof(v)){
+            continue;
+        }
+        if (v[2] > 0 && v[2] < v[1]){
+            p->value[e] += (double)v[0] * ((double)v[1] / (double)v[2]);
+        } else {
+            p->value[e] += (double)v[0];
+        }
+    }
+#else
+    (void)p;
+#endif
+}
+
+#endif
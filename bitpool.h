@@ -0,0 +1,378 @@
+#ifndef _DS_BITPOOL_H
+#define _DS_BITPOOL_H
+
+/* Bitmap slot allocator on memory arena
+ * Namespace: bitpool
+ *
+ * Allocates slot indexes in [0, size) with one bit per slot and no per slot
+ * header: the slots (objects, pages, ...) are stored by the user, e.g. in an
+ * array indexed by the slot.
+ * The bits are set for the free slots. Above them the summary levels have a
+ * bit for every word of the level below, set if the word has a free slot,
+ * up to a single word: the first free slot is found going down the levels
+ * with a ctz per level, O(log64 size).
+ * The runs of k contiguous slots are searched skipping the full words
+ * through the summaries; with AVX2 (compile with -mavx2) the long runs are
+ * scanned 4 words at once.
+ * A slot freed twice is detected.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+#if defined(__AVX2__) && !defined(BITPOOL_NO_SIMD)
+#define BITPOOL_AVX2 1
+#include <immintrin.h>
+#endif
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define BITPOOL_NIL SIZE_MAX
+/* levels for 2^64 slots */
+#define BITPOOL_MAX_LEVELS 11
+
+/* Internal use.
+ * Words of the slots level.
+ */
+#define _BITPOOL_WORDS(n) ( (((size_t)(n)) + 63) / 64 )
+
+/* the summary levels take less than 1/63 of the slots level, plus the
+ * rounding of every level
+ */
+#define BITPOOL_SIZEOF(n) ( sizeof(BitPool) + sizeof(uint64_t) * \
+        (_BITPOOL_WORDS(n) + _BITPOOL_WORDS(n) / 63 + BITPOOL_MAX_LEVELS) )
+
+typedef struct BitPool BitPool;
+
+struct BitPool {
+    size_t size;   /* number of slots */
+    size_t len;    /* number of allocated slots */
+    size_t levels; /* number of levels, the slots one included */
+    uint64_t *level[BITPOOL_MAX_LEVELS]; /* level 0: a bit per slot */
+    size_t words[BITPOOL_MAX_LEVELS];    /* words of every level */
+};
+
+/* Construct a pool of size free slots into the memory arena.
+ * The arena must be at least BITPOOL_SIZEOF(size) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(size / 64)
+ * Returns the pointer to the pool in the arena or NULL in case of errors
+ */
+BitPool * bitpool_init(void *arena, size_t size);
+
+/* Allocate k contiguous slots, the first free run in index order.
+ * Time complexity: O(size / 64) in the worst case
+ * Return the first slot or BITPOOL_NIL if there is no such run.
+ */
+size_t bitpool_alloc_run(BitPool *b, size_t k);
+
+/* Free the k contiguous slots from slot.
+ * Return false (nothing is freed) if a slot is out of range or free.
+ */
+bool bitpool_free_run(BitPool *b, size_t slot, size_t k);
+
+/* Number of allocated slots.
+ * Time complexity: O(1)
+ */
+static inline size_t bitpool_len(const BitPool *b)
+{
+    if (b == NULL){
+        return 0;
+    }
+    return b->len;
+} /* bitpool_len */
+
+/* Return true if there are no free slots */
+static inline bool bitpool_isfull(const BitPool *b)
+{
+    if (b == NULL){
+        return true;
+    }
+    return b->len == b->size;
+} /* bitpool_isfull */
+
+/* Return true if the slot is in range and free */
+static inline bool bitpool_isfree(const BitPool *b, size_t slot)
+{
+    if (b == NULL || slot >= b->size){
+        return false;
+    }
+    return (b->level[0][slot / 64] >> (slot % 64)) & 1;
+} /* bitpool_isfree */
+
+/* Internal use.
+ * Index of the lowest set bit, w must not be 0.
+ */
+static inline size_t _bitpool_ctz(uint64_t w)
+{
+    assert(w != 0);
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(w);
+#else
+    size_t i = 0;
+    while ((w & 1) == 0){
+        w >>= 1;
+        i++;
+    }
+    return i;
+#endif
+} /* _bitpool_ctz */
+
+/* Internal use.
+ * Clear the bit i of the level l and the summary bits of the words left
+ * without free slots.
+ */
+static inline void _bitpool_take(BitPool *b, size_t l, size_t i)
+{
+    for (; l < b->levels; l++){
+        uint64_t *w = &b->level[l][i / 64];
+        *w &= ~((uint64_t)1 << (i % 64));
+        if (*w != 0){
+            return;
+        }
+        i /= 64;
+    }
+} /* _bitpool_take */
+
+/* Internal use.
+ * Set the bit i of the level l and the summary bits of the words that had
+ * no free slots.
+ */
+static inline void _bitpool_give(BitPool *b, size_t l, size_t i)
+{
+    for (; l < b->levels; l++){
+        uint64_t *w = &b->level[l][i / 64];
+        bool had = (*w != 0);
+        *w |= (uint64_t)1 << (i % 64);
+        if (had){
+            return;
+        }
+        i /= 64;
+    }
+} /* _bitpool_give */
+
+/* Allocate the first free slot.
+ * Time complexity: O(log64 size)
+ * Return the slot or BITPOOL_NIL if the pool is full.
+ */
+static inline size_t bitpool_alloc(BitPool *b)
+{
+    if (b == NULL || b->len == b->size){
+        return BITPOOL_NIL;
+    }
+
+    /* the top level has one word */
+    size_t i = 0;
+    for (size_t l = b->levels; l > 0; l--){
+        i = i * 64 + _bitpool_ctz(b->level[l-1][i]);
+    }
+    assert(i < b->size);
+
+    _bitpool_take(b, 0, i);
+    b->len++;
+    return i;
+} /* bitpool_alloc */
+
+/* Free the slot.
+ * Time complexity: O(log64 size)
+ * Return false if the slot is out of range or already free.
+ */
+static inline bool bitpool_free(BitPool *b, size_t slot)
+{
+    if (b == NULL || slot >= b->size || bitpool_isfree(b, slot)){
+        return false;
+    }
+
+    _bitpool_give(b, 0, slot);
+    b->len--;
+    return true;
+} /* bitpool_free */
+
+/* First free slot at or after pos, without allocating it.
+ * Time complexity: O(log64 size)
+ * Return the slot or BITPOOL_NIL.
+ */
+static inline size_t bitpool_next_free(const BitPool *b, size_t pos)
+{
+    if (b == NULL || pos >= b->size){
+        return BITPOOL_NIL;
+    }
+
+    /* up to the first level with a set bit at or after i */
+    size_t i = pos;
+    size_t l = 0;
+    for (; l < b->levels; l++){
+        if (i / 64 >= b->words[l]){
+            return BITPOOL_NIL;
+        }
+        uint64_t w = b->level[l][i / 64] & (~(uint64_t)0 << (i % 64));
+        if (w != 0){
+            i = (i & ~(size_t)63) + _bitpool_ctz(w);
+            break;
+        }
+        i = i / 64 + 1;
+    }
+    if (l == b->levels){
+        return BITPOOL_NIL;
+    }
+
+    /* down to the first free slot of that word */
+    for (; l > 0; l--){
+        i = i * 64 + _bitpool_ctz(b->level[l-1][i]);
+    }
+    return i;
+} /* bitpool_next_free */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_BITPOOL_IMPL)
+#define _DS_BITPOOL_IMPL
+
+BitPool * bitpool_init(void *arena, size_t size)
+{
+    if (arena == NULL || size == 0 || size == BITPOOL_NIL){
+        return NULL;
+    }
+
+    BitPool *b = (BitPool*)arena;
+    uint64_t *mem = (uint64_t*)&((uint8_t*)arena)[sizeof(BitPool)];
+
+    b->size = size;
+    b->len = 0;
+    b->levels = 0;
+
+    /* every level has a bit for each word of the level below */
+    size_t bits = size;
+    do {
+        size_t l = b->levels++;
+        assert(l < BITPOOL_MAX_LEVELS);
+        b->words[l] = _BITPOOL_WORDS(bits);
+        b->level[l] = mem;
+        mem += b->words[l];
+
+        /* all free, the bits beyond the level are clear */
+        for (size_t i=0; i < b->words[l]; i++){
+            b->level[l][i] = ~(uint64_t)0;
+        }
+        if (bits % 64 != 0){
+            b->level[l][bits / 64] = ((uint64_t)1 << (bits % 64)) - 1;
+        }
+        bits = b->words[l];
+    } while (bits > 1);
+
+    return b;
+} /* bitpool_init */
+
+/* Internal use.
+ * First allocated slot in [pos, limit), limit if none.
+ */
+static size_t _bitpool_run_end(const BitPool *b, size_t pos, size_t limit)
+{
+    const uint64_t *w = b->level[0];
+    size_t i = pos / 64;
+    size_t last = (limit - 1) / 64;
+
+    /* the first word from pos */
+    uint64_t used = ~w[i] & (~(uint64_t)0 << (pos % 64));
+    if (used != 0){
+        size_t e = i * 64 + _bitpool_ctz(used);
+        return (e < limit)?e:limit;
+    }
+    i++;
+
+#ifdef BITPOOL_AVX2
+    /* skip 4 words all free at once */
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    for (; i + 3 <= last; i += 4){
+        __m256i v = _mm256_loadu_si256((const __m256i *)&w[i]);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(v, ones)) != -1){
+            break;
+        }
+    }
+#endif
+
+    for (; i <= last; i++){
+        if (w[i] != ~(uint64_t)0){
+            size_t e = i * 64 + _bitpool_ctz(~w[i]);
+            return (e < limit)?e:limit;
+        }
+    }
+    return limit;
+} /* _bitpool_run_end */
+
+/* Internal use.
+ * Allocate (take) or free the slots [slot, slot + k) word by word, the
+ * summaries change only for the words that become full or not full.
+ */
+static void _bitpool_mark(BitPool *b, size_t slot, size_t k, bool take)
+{
+    size_t end = slot + k;
+
+    while (slot < end){
+        size_t i = slot / 64;
+        size_t lo = slot % 64;
+        size_t n = (end - slot < 64 - lo)?end - slot:64 - lo;
+        uint64_t mask = ((n == 64)?~(uint64_t)0:(((uint64_t)1 << n) - 1)) << lo;
+
+        uint64_t *w = &b->level[0][i];
+        bool had = (*w != 0);
+        if (take){
+            *w &= ~mask;
+            if (had && *w == 0 && b->levels > 1){
+                _bitpool_take(b, 1, i);
+            }
+        } else {
+            *w |= mask;
+            if (!had && b->levels > 1){
+                _bitpool_give(b, 1, i);
+            }
+        }
+        slot += n;
+    }
+} /* _bitpool_mark */
+
+size_t bitpool_alloc_run(BitPool *b, size_t k)
+{
+    if (b == NULL || k == 0 || k > b->size - b->len){
+        return BITPOOL_NIL;
+    }
+    if (k == 1){
+        return bitpool_alloc(b);
+    }
+
+    for (size_t pos = bitpool_next_free(b, 0); pos != BITPOOL_NIL;){
+        if (k > b->size - pos){
+            return BITPOOL_NIL;
+        }
+        size_t end = _bitpool_run_end(b, pos, pos + k);
+        if (end == pos + k){
+            _bitpool_mark(b, pos, k, true);
+            b->len += k;
+            return pos;
+        }
+        /* the run is too short, continue after its end */
+        pos = bitpool_next_free(b, end);
+    }
+    return BITPOOL_NIL;
+} /* bitpool_alloc_run */
+
+bool bitpool_free_run(BitPool *b, size_t slot, size_t k)
+{
+    if (b == NULL || k == 0 || slot >= b->size || k > b->size - slot){
+        return false;
+    }
+
+    /* all the slots must be allocated: no free slot in the run */
+    size_t f = bitpool_next_free(b, slot);
+    if (f != BITPOOL_NIL && f < slot + k){
+        return false;
+    }
+
+    _bitpool_mark(b, slot, k, false);
+    b->len -= k;
+    return true;
+} /* bitpool_free_run */
+
+#endif /* DS_IMPLEMENTATION */
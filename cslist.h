@@ -0,0 +1,556 @@
+#ifndef _DS_CSLIST_H
+#define _DS_CSLIST_H
+
+/* Concurrent Single Linked List on memory arena.
+ * Namespace: cslist
+ *
+ * Lock-free variant of slist.h (Harris-Michael list on index links):
+ * - insert prepends with a CAS on the head;
+ * - delete first marks the item (low bit of its next link, logical delete)
+ *   then unlinks it from the predecessor (physical delete);
+ * - readers traverse skipping the marked items, without retries (wait-free).
+ *
+ * The items are reused only when no thread can still read them, with an
+ * epoch based reclamation: every thread owns a CSListThread record and wraps
+ * its operations (or a whole traversal) between cslist_enter and
+ * cslist_leave. The unlinked items wait in the limbo of the thread that
+ * unlinked them until all the threads have moved two epochs forward, then
+ * they go back to the free list.
+ *
+ * It requires the GCC __atomic builtins (GCC, Clang).
+ *
+ * The actual values must be stored outside the list and
+ * guaranteed to be in the same scope of the list.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* null index, links store (index << 1 | mark) */
+#define CSLIST_NIL (SIZE_MAX >> 1)
+#define CSLIST_CACHELINE 64
+#define CSLIST_SIZEOF(n, threads) ( sizeof(CSList) + \
+        (sizeof(CSListThread) * (size_t)(threads)) + \
+        (sizeof(CSListItem) * (size_t)(n)) )
+
+typedef struct CSList CSList;
+typedef struct CSListItem CSListItem;
+typedef struct CSListThread CSListThread;
+typedef struct CSListIter CSListIter;
+
+struct CSListItem {
+    size_t next;   /* link to the next item, marked if deleted */
+    void *value;   /* pointer to the user object to store */
+    size_t limbo;  /* index of the next retired item in the limbo */
+};
+
+/* Per thread reclamation record, one cache line to avoid false sharing */
+struct CSListThread {
+    size_t epoch;    /* announced epoch (epoch << 1 | active) */
+    size_t local;    /* last epoch seen by the thread */
+    size_t depth;    /* nesting level of the critical sections */
+    size_t limbo[3]; /* retired items by epoch % 3 */
+    CSList *list;
+    uint8_t _pad[CSLIST_CACHELINE - (6 * sizeof(size_t) + sizeof(CSList*)) %
+                                     CSLIST_CACHELINE];
+};
+
+struct CSList {
+    size_t size;     /* capacity */
+    size_t len;      /* number of items not deleted */
+    size_t head;     /* link to the list head item, never marked */
+    size_t free;     /* index of the free list head item (linked by limbo) */
+    size_t used;     /* items never allocated are in [used, size) */
+    size_t epoch;    /* global epoch */
+    size_t nthreads; /* number of thread records */
+    CSListThread *threads; /* array of 'nthreads' records */
+    CSListItem *items;     /* array of 'size' items */
+    /* the records start on the next cache line, apart from the epoch */
+    uint8_t _pad[CSLIST_CACHELINE - (7 * sizeof(size_t) +
+                                     sizeof(CSListThread*) +
+                                     sizeof(CSListItem*)) % CSLIST_CACHELINE];
+};
+
+/* CSList iterator, valid only between cslist_enter and cslist_leave.
+ * It refers to the items not deleted from the first to the CSLIST_NIL
+ */
+struct CSListIter {
+    size_t curr; /* index to list->items of the current item */
+    CSList *list;
+};
+
+/* Construct a list of indicated capacity into the memory arena, used by
+ * at most nthreads threads.
+ * The arena must be at least CSLIST_SIZEOF(capacity, nthreads) long and
+ * aligned to CSLIST_CACHELINE for the best performance.
+ * The deleted items are reusable only after some epochs, the capacity must
+ * include them.
+ * It must be completed before sharing the list with the other threads.
+ * Time complexity: O(nthreads)
+ * Returns the pointer to the list in the arena or NULL in case of errors
+ */
+CSList * cslist_init(void *arena, size_t capacity, size_t nthreads);
+
+/* The reclamation record of the thread id, in [0, nthreads).
+ * Every thread must use its own record.
+ * Return NULL if id is out of range.
+ */
+static inline CSListThread * cslist_thread(CSList *list, size_t id)
+{
+    if (list == NULL || id >= list->nthreads){
+        return NULL;
+    }
+    return &list->threads[id];
+} /* cslist_thread */
+
+/* Number of items not deleted, it can be outdated when returned.
+ * Time complexity: O(1)
+ */
+static inline size_t cslist_len(CSList *list)
+{
+    if (list == NULL){
+        return 0;
+    }
+    return __atomic_load_n(&list->len, __ATOMIC_RELAXED);
+} /* cslist_len */
+
+/* Internal use.
+ * Link encoding of index and mark.
+ */
+static inline size_t _cslist_link(size_t index, bool mark)
+{
+    return (index << 1) | (mark?1:0);
+} /* _cslist_link */
+
+/* Internal use.
+ * Index referred by a link.
+ */
+static inline size_t _cslist_index(size_t link)
+{
+    return link >> 1;
+} /* _cslist_index */
+
+/* Internal use.
+ * True if the link is marked (the item owning the link is deleted).
+ */
+static inline bool _cslist_marked(size_t link)
+{
+    return (link & 1) != 0;
+} /* _cslist_marked */
+
+/* Internal use.
+ * Move a limbo chain into the free list.
+ */
+void _cslist_free_chain(CSList *list, size_t first);
+
+/* Start a critical section: the items read until cslist_leave are not
+ * reused. The critical sections can be nested (e.g. insert during a
+ * traversal), only the outermost one counts.
+ * Time complexity: O(1), O(k) when the k items retired three epochs ago by
+ * this thread are released.
+ */
+static inline void cslist_enter(CSListThread *t)
+{
+    assert(t != NULL);
+    CSList *list = t->list;
+    size_t e;
+
+    t->depth++;
+    if (t->depth > 1){
+        return;
+    }
+
+    /* announce an epoch still current after the announcement */
+    do {
+        e = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&t->epoch, (e << 1) | 1, __ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST) != e);
+
+    if (t->local != e){
+        /* the bucket has the items retired at epoch e - 3 (or before) */
+        _cslist_free_chain(list, t->limbo[e % 3]);
+        t->limbo[e % 3] = CSLIST_NIL;
+        t->local = e;
+    }
+} /* cslist_enter */
+
+/* End the critical section started with cslist_enter */
+static inline void cslist_leave(CSListThread *t)
+{
+    assert(t != NULL);
+    assert(t->depth > 0);
+
+    t->depth--;
+    if (t->depth > 0){
+        return;
+    }
+    __atomic_store_n(&t->epoch, 0, __ATOMIC_RELEASE);
+} /* cslist_leave */
+
+/* Prepend value to the list.
+ * value can be NULL.
+ * Lock-free, t is the record of the calling thread.
+ * Return true if value inserted, false if there is no space left.
+ */
+bool cslist_insert(CSListThread *t, void *value);
+
+/* Delete the first item with value (pointer comparison).
+ * Lock-free, t is the record of the calling thread.
+ * Return true if the value has been found and deleted.
+ */
+bool cslist_delete(CSListThread *t, const void *value);
+
+/* Return true if the iterator has reached the end of the list */
+static inline bool cslist_exhausted(CSListIter it)
+{
+    return it.curr == CSLIST_NIL;
+} /* cslist_exhausted */
+
+/* Get the value pointed by the iterator.
+ * Return NULL if iterator is exhausted.
+ */
+static inline void * cslist_value(CSListIter it)
+{
+    if (it.curr == CSLIST_NIL){
+        return NULL;
+    }
+
+    assert(it.list != NULL);
+    assert(it.curr < it.list->size);
+
+    return it.list->items[it.curr].value;
+} /* cslist_value */
+
+/* Internal use.
+ * First item not deleted starting from the link.
+ */
+static inline size_t _cslist_skip(CSList *list, size_t link)
+{
+    size_t curr = _cslist_index(link);
+
+    while (curr != CSLIST_NIL){
+        size_t next = __atomic_load_n(&list->items[curr].next, __ATOMIC_ACQUIRE);
+        if (!_cslist_marked(next)){
+            break;
+        }
+        curr = _cslist_index(next);
+    }
+
+    return curr;
+} /* _cslist_skip */
+
+/* Start an iterator and returns the first value.
+ * It must be called between cslist_enter and cslist_leave.
+ * Return NULL if no items present in the list.
+ */
+static inline void * cslist_iter(CSListIter *it, CSList *list)
+{
+    if (list == NULL || it == NULL){
+        return NULL;
+    }
+
+    it->list = list;
+    it->curr = _cslist_skip(list, __atomic_load_n(&list->head, __ATOMIC_ACQUIRE));
+
+    return cslist_value(*it);
+} /* cslist_iter */
+
+/* Move the iterator to the next item not deleted, if possible.
+ * Wait-free: it never retries, the items deleted concurrently can be seen.
+ * Return if the operation succeeded.
+ */
+static inline bool cslist_next(CSListIter *it)
+{
+    if (it == NULL){
+        return false;
+    }
+    if (it->curr == CSLIST_NIL){
+        return false;
+    }
+
+    CSList *list = it->list;
+    size_t next = __atomic_load_n(&list->items[it->curr].next, __ATOMIC_ACQUIRE);
+    it->curr = _cslist_skip(list, next);
+
+    return true;
+} /* cslist_next */
+
+/* Search value (pointer comparison).
+ * Wait-free, t is the record of the calling thread.
+ * Return true if found.
+ */
+static inline bool cslist_contains(CSListThread *t, const void *value)
+{
+    if (t == NULL){
+        return false;
+    }
+
+    CSListIter it;
+    bool found = false;
+
+    cslist_enter(t);
+    cslist_iter(&it, t->list);
+    while (!cslist_exhausted(it)){
+        if (cslist_value(it) == value){
+            found = true;
+            break;
+        }
+        cslist_next(&it);
+    }
+    cslist_leave(t);
+
+    return found;
+} /* cslist_contains */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_CSLIST_IMPL)
+#define _DS_CSLIST_IMPL
+
+CSList * cslist_init(void *arena, size_t capacity, size_t nthreads)
+{
+    if ((arena == NULL) || (capacity == 0) || (nthreads == 0)){
+        return NULL;
+    }
+    if (capacity >= CSLIST_NIL){
+        return NULL;
+    }
+
+    uint8_t *mem = (uint8_t*)arena;
+    CSList *list = (CSList*)arena;
+
+    list->size = capacity;
+    list->len = 0;
+    list->head = CSLIST_NIL << 1;
+    list->free = CSLIST_NIL;
+    list->used = 0;
+    list->epoch = 0;
+    list->nthreads = nthreads;
+
+    mem = &mem[sizeof(CSList)];
+    list->threads = (CSListThread*)mem;
+    mem = &mem[sizeof(CSListThread) * nthreads];
+    list->items = (CSListItem*)mem;
+
+    for (size_t i=0; i < nthreads; i++){
+        CSListThread *t = &list->threads[i];
+        t->epoch = 0;
+        t->local = 0;
+        t->depth = 0;
+        t->limbo[0] = CSLIST_NIL;
+        t->limbo[1] = CSLIST_NIL;
+        t->limbo[2] = CSLIST_NIL;
+        t->list = list;
+    }
+
+    return list;
+} /* cslist_init */
+
+void _cslist_free_chain(CSList *list, size_t first)
+{
+    if (first == CSLIST_NIL){
+        return;
+    }
+
+    size_t last = first;
+    while (list->items[last].limbo != CSLIST_NIL){
+        last = list->items[last].limbo;
+    }
+
+    size_t head = __atomic_load_n(&list->free, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&list->items[last].limbo, head, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&list->free, &head, first, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+} /* _cslist_free_chain */
+
+/* Internal use.
+ * Move the global epoch forward if all the active threads announced it.
+ */
+static void _cslist_advance(CSList *list)
+{
+    size_t e = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+
+    for (size_t i=0; i < list->nthreads; i++){
+        size_t a = __atomic_load_n(&list->threads[i].epoch, __ATOMIC_SEQ_CST);
+        if ((a & 1) && (a >> 1) != e){
+            return;
+        }
+    }
+
+    __atomic_compare_exchange_n(&list->epoch, &e, e + 1, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+} /* _cslist_advance */
+
+/* Internal use.
+ * Put the unlinked item in the limbo of the current epoch.
+ */
+static void _cslist_retire(CSListThread *t, size_t item)
+{
+    CSList *list = t->list;
+    size_t b = t->local % 3;
+
+    __atomic_store_n(&list->items[item].limbo, t->limbo[b], __ATOMIC_RELAXED);
+    t->limbo[b] = item;
+
+    _cslist_advance(list);
+} /* _cslist_retire */
+
+/* Internal use.
+ * Provide the next free item, inside a critical section.
+ * The critical section prevents the ABA on the free list head: an item
+ * popped by another thread cannot come back before this thread leaves.
+ * return the index or CSLIST_NIL
+ */
+static size_t _cslist_alloc(CSList *list)
+{
+    size_t head = __atomic_load_n(&list->free, __ATOMIC_ACQUIRE);
+
+    while (head != CSLIST_NIL){
+        /* head can be popped and retired meanwhile, then the CAS fails */
+        size_t next = __atomic_load_n(&list->items[head].limbo, __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&list->free, &head, next, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)){
+            return head;
+        }
+    }
+
+    /* free list runout items, take one never used: used stops at size,
+     * the attempts on a full list do not move it
+     */
+    size_t ind = __atomic_load_n(&list->used, __ATOMIC_RELAXED);
+    while (ind < list->size){
+        if (__atomic_compare_exchange_n(&list->used, &ind, ind + 1, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+            return ind;
+        }
+    }
+    return CSLIST_NIL;
+} /* _cslist_alloc */
+
+bool cslist_insert(CSListThread *t, void *value)
+{
+    if (t == NULL){
+        return false;
+    }
+
+    CSList *list = t->list;
+    cslist_enter(t);
+
+    size_t f = _cslist_alloc(list);
+    if (f == CSLIST_NIL){
+        /* help the retired items to come back for the next attempt */
+        _cslist_advance(list);
+        cslist_leave(t);
+        return false;
+    }
+
+    list->items[f].value = value;
+
+    size_t head = __atomic_load_n(&list->head, __ATOMIC_ACQUIRE);
+    do {
+        __atomic_store_n(&list->items[f].next, head, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&list->head, &head,
+                                          _cslist_link(f, false), true,
+                                          __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+
+    __atomic_fetch_add(&list->len, 1, __ATOMIC_RELAXED);
+    cslist_leave(t);
+
+    return true;
+} /* cslist_insert */
+
+/* Internal use.
+ * Search the first item not deleted with value, unlinking the marked items
+ * on the way. On return *prev is the link preceding the found item.
+ * If item is not CSLIST_NIL, the search stops once the (marked) item has
+ * been unlinked instead.
+ * return the index or CSLIST_NIL
+ */
+static size_t _cslist_search(CSListThread *t, const void *value, size_t item,
+                             size_t **prev)
+{
+    CSList *list = t->list;
+
+retry:
+    *prev = &list->head;
+    size_t curr = _cslist_index(__atomic_load_n(*prev, __ATOMIC_ACQUIRE));
+
+    while (curr != CSLIST_NIL){
+        size_t next = __atomic_load_n(&list->items[curr].next, __ATOMIC_ACQUIRE);
+
+        if (_cslist_marked(next)){
+            /* physical delete of the marked item */
+            size_t expected = _cslist_link(curr, false);
+            size_t succ = _cslist_link(_cslist_index(next), false);
+            if (!__atomic_compare_exchange_n(*prev, &expected, succ, false,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+                goto retry; /* the predecessor changed */
+            }
+            _cslist_retire(t, curr);
+            if (curr == item){
+                return CSLIST_NIL;
+            }
+            curr = _cslist_index(next);
+            continue;
+        }
+
+        if (item == CSLIST_NIL && list->items[curr].value == value){
+            return curr;
+        }
+
+        *prev = &list->items[curr].next;
+        curr = _cslist_index(next);
+    }
+
+    return CSLIST_NIL;
+} /* _cslist_search */
+
+bool cslist_delete(CSListThread *t, const void *value)
+{
+    if (t == NULL){
+        return false;
+    }
+
+    CSList *list = t->list;
+    bool found = false;
+    cslist_enter(t);
+
+    for (;;){
+        size_t *prev;
+        size_t curr = _cslist_search(t, value, CSLIST_NIL, &prev);
+        if (curr == CSLIST_NIL){
+            break;
+        }
+
+        /* logical delete */
+        size_t next = __atomic_load_n(&list->items[curr].next, __ATOMIC_ACQUIRE);
+        if (_cslist_marked(next)){
+            continue; /* deleted by another thread, search again */
+        }
+        if (!__atomic_compare_exchange_n(&list->items[curr].next, &next,
+                                         next | 1, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+            continue;
+        }
+        found = true;
+        __atomic_fetch_sub(&list->len, 1, __ATOMIC_RELAXED);
+
+        /* physical delete, if it fails a search does it */
+        size_t expected = _cslist_link(curr, false);
+        if (__atomic_compare_exchange_n(prev, &expected, next, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+            _cslist_retire(t, curr);
+        } else {
+            _cslist_search(t, NULL, curr, &prev);
+        }
+        break;
+    }
+
+    cslist_leave(t);
+    return found;
+} /* cslist_delete */
+
+#endif /* DS_IMPLEMENTATION */
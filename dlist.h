@@ -0,0 +1,372 @@
+#ifndef _DS_DLIST_H
+#define _DS_DLIST_H
+
+/* Doubly Linked List on memory arena.
+ * Namespace: dlist
+ *
+ * Same model of slist.h, but every item knows its previous one, therefore an
+ * item can be removed or moved knowing only its index (the handle returned
+ * by the insert procedures) in O(1).
+ *
+ * The actual values must be stored outside the list and
+ * guaranteed to be in the same scope of the list.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define DLIST_NIL SIZE_MAX
+#define DLIST_SIZEOF(n) ( sizeof(DList) + (sizeof(DListItem) * (size_t)(n)) )
+
+typedef struct DList DList;
+typedef struct DListItem DListItem;
+
+struct DListItem {
+    size_t prev;  /* index of the previous element in DList.items */
+    size_t next;  /* index of the next element in DList.items */
+    void *value;  /* pointer to the user object to store */
+};
+
+struct DList {
+    size_t size;  /* capacity */
+    size_t len;   /* number of stored items */
+    size_t head;  /* index of the list head item */
+    size_t tail;  /* index of the list tail item */
+    size_t free;  /* index of the free list head item (linked by next) */
+    size_t used;  /* items never allocated are in [used, size) */
+    DListItem *items; /* array of 'size' items */
+};
+
+/* Construct a list of indicated capacity into the memory arena.
+ * The arena must be at least DLIST_SIZEOF(capacity) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(1)
+ * Returns the pointer to the list in the arena or NULL in case of errors
+ */
+DList * dlist_init(void *arena, size_t capacity);
+
+/* Number of items in the list.
+ * Time complexity: O(1)
+ */
+static inline size_t dlist_len(const DList *list)
+{
+    if (list == NULL){
+        return 0;
+    }
+    return list->len;
+} /* dlist_len */
+
+/* same as
+ * dlist_len(list) == 0
+ */
+static inline bool dlist_isempty(const DList *list)
+{
+    if (list == NULL){
+        return true;
+    }
+    return list->len == 0;
+} /* dlist_isempty */
+
+/* Return true if the list has reached its maximum capacity */
+static inline bool dlist_isfull(const DList *list)
+{
+    if (list == NULL){
+        return true;
+    }
+    return list->len == list->size;
+} /* dlist_isfull */
+
+/* Index of the first item, DLIST_NIL if empty */
+static inline size_t dlist_first(const DList *list)
+{
+    if (list == NULL){
+        return DLIST_NIL;
+    }
+    return list->head;
+} /* dlist_first */
+
+/* Index of the last item, DLIST_NIL if empty */
+static inline size_t dlist_last(const DList *list)
+{
+    if (list == NULL){
+        return DLIST_NIL;
+    }
+    return list->tail;
+} /* dlist_last */
+
+/* Index of the item following item, DLIST_NIL at the end of the list */
+static inline size_t dlist_next(const DList *list, size_t item)
+{
+    if (list == NULL || item == DLIST_NIL){
+        return DLIST_NIL;
+    }
+    assert(item < list->size);
+    return list->items[item].next;
+} /* dlist_next */
+
+/* Index of the item preceding item, DLIST_NIL at the head of the list */
+static inline size_t dlist_prev(const DList *list, size_t item)
+{
+    if (list == NULL || item == DLIST_NIL){
+        return DLIST_NIL;
+    }
+    assert(item < list->size);
+    return list->items[item].prev;
+} /* dlist_prev */
+
+/* Get the value of the item.
+ * Return NULL if item is DLIST_NIL.
+ */
+static inline void * dlist_value(const DList *list, size_t item)
+{
+    if (list == NULL || item == DLIST_NIL){
+        return NULL;
+    }
+    assert(item < list->size);
+    return list->items[item].value;
+} /* dlist_value */
+
+/* Internal use.
+ * Provide the next free item.
+ * return the index or DLIST_NIL
+ */
+static inline size_t _dlist_alloc(DList *list)
+{
+    assert(list != NULL);
+
+    size_t ind;
+    if (list->free != DLIST_NIL){
+        assert(list->free < list->size);
+        ind = list->free;
+        list->free = list->items[ind].next;
+    } else if (list->used < list->size){
+        ind = list->used;
+        list->used++;
+    } else {
+        return DLIST_NIL;
+    }
+
+    list->len++;
+
+    assert(ind < list->size);
+    return ind;
+} /* _dlist_alloc */
+
+/* Internal use.
+ * Prepend the item to the free list
+ */
+static inline void _dlist_dealloc(DList *list, size_t item)
+{
+    assert(list != NULL);
+    assert(item < list->size);
+    assert(list->len > 0);
+
+    list->items[item].prev = DLIST_NIL;
+    list->items[item].next = list->free;
+    list->free = item;
+    list->len--;
+} /* _dlist_dealloc */
+
+/* Internal use.
+ * Detach the item from its neighbours, the item is not released.
+ */
+static inline void _dlist_unlink(DList *list, size_t item)
+{
+    DListItem *items = list->items;
+    size_t prev = items[item].prev;
+    size_t next = items[item].next;
+
+    if (prev == DLIST_NIL){
+        assert(list->head == item);
+        list->head = next;
+    } else {
+        items[prev].next = next;
+    }
+
+    if (next == DLIST_NIL){
+        assert(list->tail == item);
+        list->tail = prev;
+    } else {
+        items[next].prev = prev;
+    }
+} /* _dlist_unlink */
+
+/* Internal use.
+ * Link the detached item before pos (DLIST_NIL means at the end).
+ */
+static inline void _dlist_link(DList *list, size_t item, size_t pos)
+{
+    DListItem *items = list->items;
+    size_t prev = (pos == DLIST_NIL)?list->tail:items[pos].prev;
+
+    items[item].prev = prev;
+    items[item].next = pos;
+
+    if (prev == DLIST_NIL){
+        list->head = item;
+    } else {
+        items[prev].next = item;
+    }
+
+    if (pos == DLIST_NIL){
+        list->tail = item;
+    } else {
+        items[pos].prev = item;
+    }
+} /* _dlist_link */
+
+/* Insert value before the item pos.
+ * If pos is DLIST_NIL the value is appended at the end of the list.
+ * value can be NULL.
+ * Time complexity: O(1)
+ * Return the index of the new item or DLIST_NIL if the list is full.
+ */
+static inline size_t dlist_insert(DList *list, size_t pos, void *value)
+{
+    if (list == NULL){
+        return DLIST_NIL;
+    }
+    assert(pos < list->size || pos == DLIST_NIL);
+
+    size_t f = _dlist_alloc(list);
+    if (f == DLIST_NIL){
+        return DLIST_NIL;
+    }
+
+    list->items[f].value = value;
+    _dlist_link(list, f, pos);
+
+    return f;
+} /* dlist_insert */
+
+/* Insert value at the head of the list.
+ * Return the index of the new item or DLIST_NIL if the list is full.
+ */
+static inline size_t dlist_push_front(DList *list, void *value)
+{
+    if (list == NULL){
+        return DLIST_NIL;
+    }
+    return dlist_insert(list, list->head, value);
+} /* dlist_push_front */
+
+/* Append value at the end of the list.
+ * Return the index of the new item or DLIST_NIL if the list is full.
+ */
+static inline size_t dlist_push_back(DList *list, void *value)
+{
+    return dlist_insert(list, DLIST_NIL, value);
+} /* dlist_push_back */
+
+/* Remove the item from the list and release it.
+ * The item must be in the list, otherwise the behavior is undefined.
+ * Time complexity: O(1)
+ * Return the value of the removed item (NULL if item is DLIST_NIL).
+ */
+static inline void * dlist_remove(DList *list, size_t item)
+{
+    if (list == NULL || item == DLIST_NIL){
+        return NULL;
+    }
+    assert(item < list->size);
+    assert(list->len > 0);
+
+    void *v = list->items[item].value;
+    _dlist_unlink(list, item);
+    _dlist_dealloc(list, item);
+
+    return v;
+} /* dlist_remove */
+
+/* Remove the head of the list.
+ * Return its value (or NULL if empty).
+ */
+static inline void * dlist_pop_front(DList *list)
+{
+    if (list == NULL){
+        return NULL;
+    }
+    return dlist_remove(list, list->head);
+} /* dlist_pop_front */
+
+/* Remove the tail of the list.
+ * Return its value (or NULL if empty).
+ */
+static inline void * dlist_pop_back(DList *list)
+{
+    if (list == NULL){
+        return NULL;
+    }
+    return dlist_remove(list, list->tail);
+} /* dlist_pop_back */
+
+/* Move the item at the head of the list, the index does not change.
+ * Time complexity: O(1)
+ */
+static inline void dlist_move_front(DList *list, size_t item)
+{
+    if (list == NULL || item == DLIST_NIL){
+        return;
+    }
+    assert(item < list->size);
+
+    if (list->head == item){
+        return;
+    }
+    _dlist_unlink(list, item);
+    _dlist_link(list, item, list->head);
+} /* dlist_move_front */
+
+/* Move the item at the end of the list, the index does not change.
+ * Time complexity: O(1)
+ */
+static inline void dlist_move_back(DList *list, size_t item)
+{
+    if (list == NULL || item == DLIST_NIL){
+        return;
+    }
+    assert(item < list->size);
+
+    if (list->tail == item){
+        return;
+    }
+    _dlist_unlink(list, item);
+    _dlist_link(list, item, DLIST_NIL);
+} /* dlist_move_back */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_DLIST_IMPL)
+#define _DS_DLIST_IMPL
+
+DList * dlist_init(void *arena, size_t capacity)
+{
+    if ((arena == NULL) || (capacity == 0) || (capacity == DLIST_NIL)){
+        return NULL;
+    }
+
+    /* point to the end of the DList struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(DList)];
+
+    DList *list = (DList*)arena;
+    list->size = capacity;
+    list->len = 0;
+    list->head = DLIST_NIL;
+    list->tail = DLIST_NIL;
+    list->items = (DListItem*)mem;
+
+    /* the free list contains only the released items, the items never
+     * allocated are taken from 'used' to avoid an O(n) initialization.
+     */
+    list->free = DLIST_NIL;
+    list->used = 0;
+
+    return list;
+} /* dlist_init */
+
+#endif /* DS_IMPLEMENTATION */
@@ -0,0 +1,302 @@
+#ifndef _DS_EBR_H
+#define _DS_EBR_H
+
+/* Epoch Based Reclamation on memory arena
+ * Namespace: ebr
+ *
+ * Deferred release of the items (SList items, ObjPool objects by index,
+ * ...) that lock-free readers can still be reading, as cslist.h does for
+ * its own items.
+ * Every thread owns an EBRThread record and wraps its reads between
+ * ebr_enter and ebr_leave (cheap: a store and a load of the global epoch).
+ * An unlinked item is retired inside a critical section: it waits in the
+ * limbo of the thread, a bucket per epoch, until all the threads have moved
+ * two epochs forward, then the whole bucket is passed to the release
+ * callback of the user in one call (e.g. objpool_release of every object
+ * under a single lock, since the owning pool is not thread safe).
+ *
+ *  EBR *ebr = ebr_init(arena, THREADS, LIMBO, release_objs, &pool);
+ *  EBRThread *t = ebr_thread(ebr, id);
+ *  ebr_enter(t);
+ *  Obj *old = __atomic_exchange_n(&shared, new, __ATOMIC_ACQ_REL);
+ *  ebr_retire(t, objpool_index(&pool, old));
+ *  ebr_leave(t);
+ *
+ * The global epoch moves forward when every active thread has announced
+ * it: a thread that stays in a critical section blocks the releases of all
+ * the threads.
+ *
+ * It requires the GCC __atomic builtins (GCC, Clang).
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define EBR_CACHELINE 64
+/* buckets of the limbo: current epoch, previous one, releasable one */
+#define EBR_BUCKETS 3
+/* retires between the attempts to move the epoch forward */
+#ifndef EBR_BATCH
+#define EBR_BATCH 32
+#endif
+#define EBR_SIZEOF(threads, limbo) ( sizeof(EBR) + (size_t)(threads) * \
+        (sizeof(EBRThread) + EBR_BUCKETS * sizeof(size_t) * (size_t)(limbo)) )
+
+typedef struct EBR EBR;
+typedef struct EBRThread EBRThread;
+
+/* Release the n retired items, no thread can read them anymore.
+ * ctx is the user pointer passed to ebr_init.
+ * It is called by the thread that retired them, concurrently with the
+ * other threads.
+ */
+typedef void (*EBRRelease)(const size_t *items, size_t n, void *ctx);
+
+/* Per thread record, on its own cache lines to avoid false sharing */
+struct EBRThread {
+    size_t epoch;    /* announced epoch (epoch << 1 | active) */
+    size_t local;    /* last epoch seen by the thread */
+    size_t depth;    /* nesting level of the critical sections */
+    size_t len[EBR_BUCKETS]; /* retired items in every bucket */
+    size_t released; /* items released so far */
+    size_t *limbo;   /* EBR_BUCKETS buckets of EBR.limbo items */
+    EBR *ebr;
+    uint8_t _pad[EBR_CACHELINE - (7 * sizeof(size_t) + sizeof(size_t*) +
+                                  sizeof(EBR*)) % EBR_CACHELINE];
+};
+
+struct EBR {
+    size_t epoch;       /* global epoch */
+    size_t nthreads;    /* number of thread records */
+    size_t limbo;       /* capacity of every bucket */
+    EBRRelease release;
+    void *ctx;          /* user pointer for release */
+    EBRThread *threads; /* array of 'nthreads' records */
+    /* the records start on the next cache line, apart from the epoch */
+    uint8_t _pad[EBR_CACHELINE - (3 * sizeof(size_t) + sizeof(EBRRelease) +
+                                  sizeof(void*) + sizeof(EBRThread*)) %
+                                 EBR_CACHELINE];
+};
+
+/* Construct the reclamation domain of nthreads threads into the memory
+ * arena, every thread can have limbo items retired in every epoch.
+ * release is called for the items no thread can read anymore.
+ * The arena must be at least EBR_SIZEOF(nthreads, limbo) long and aligned
+ * to EBR_CACHELINE for the best performance.
+ * It must be completed before sharing the domain with the other threads.
+ * Time complexity: O(nthreads)
+ * Returns the pointer to the domain in the arena or NULL in case of errors
+ */
+EBR * ebr_init(void *arena, size_t nthreads, size_t limbo,
+               EBRRelease release, void *ctx);
+
+/* Move the global epoch forward if all the active threads announced it.
+ * Called by ebr_retire, a thread waiting for the releases can call it too.
+ * Time complexity: O(nthreads)
+ */
+void ebr_advance(EBR *ebr);
+
+/* Release all the retired items of all the threads.
+ * No thread can be in a critical section (e.g. at the shutdown).
+ * Time complexity: O(nthreads + retired)
+ */
+void ebr_drain(EBR *ebr);
+
+/* Internal use.
+ * Pass the bucket b of the thread to the release callback.
+ */
+void _ebr_release(EBRThread *t, size_t b);
+
+/* The record of the thread id, in [0, nthreads).
+ * Every thread must use its own record.
+ * Return NULL if id is out of range.
+ */
+static inline EBRThread * ebr_thread(EBR *ebr, size_t id)
+{
+    if (ebr == NULL || id >= ebr->nthreads){
+        return NULL;
+    }
+    return &ebr->threads[id];
+} /* ebr_thread */
+
+/* Number of items retired by the thread and not released yet */
+static inline size_t ebr_pending(const EBRThread *t)
+{
+    if (t == NULL){
+        return 0;
+    }
+    return t->len[0] + t->len[1] + t->len[2];
+} /* ebr_pending */
+
+/* Start a critical section: the items read until ebr_leave are not
+ * released. The critical sections can be nested, only the outermost one
+ * counts.
+ * Time complexity: O(1), plus the release of the items retired three
+ * epochs ago by this thread
+ */
+static inline void ebr_enter(EBRThread *t)
+{
+    assert(t != NULL);
+    EBR *ebr = t->ebr;
+    size_t e;
+
+    t->depth++;
+    if (t->depth > 1){
+        return;
+    }
+
+    /* announce an epoch still current after the announcement */
+    do {
+        e = __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&t->epoch, (e << 1) | 1, __ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST) != e);
+
+    if (t->local != e){
+        /* The bucket of the epoch x can be read by the threads that
+         * announced x + 1 (the epoch moved during the retire): it is
+         * released at x + 3, including the bucket of the new epoch.
+         */
+        size_t d = e - t->local;
+        for (size_t k = (d >= 3)?0:3 - d; k < EBR_BUCKETS; k++){
+            _ebr_release(t, (t->local + EBR_BUCKETS - k) % EBR_BUCKETS);
+        }
+        t->local = e;
+    }
+} /* ebr_enter */
+
+/* End the critical section started with ebr_enter */
+static inline void ebr_leave(EBRThread *t)
+{
+    assert(t != NULL);
+    assert(t->depth > 0);
+
+    t->depth--;
+    if (t->depth > 0){
+        return;
+    }
+    __atomic_store_n(&t->epoch, 0, __ATOMIC_RELEASE);
+} /* ebr_leave */
+
+/* Retire the item, already unreachable for the threads that enter from
+ * now on: it is released once the threads that could read it have left.
+ * It must be called inside a critical section.
+ * Time complexity: O(1), O(nthreads) every EBR_BATCH retires
+ * Return false if the bucket of the epoch is full (the item is not
+ * retired): leave, and retry after the epoch has moved forward.
+ */
+static inline bool ebr_retire(EBRThread *t, size_t item)
+{
+    assert(t != NULL);
+    assert(t->depth > 0);
+    EBR *ebr = t->ebr;
+    size_t b = t->local % EBR_BUCKETS;
+
+    if (t->len[b] == ebr->limbo){
+        ebr_advance(ebr);
+        return false;
+    }
+
+    t->limbo[b * ebr->limbo + t->len[b]] = item;
+    t->len[b]++;
+    if (t->len[b] % EBR_BATCH == 0){
+        ebr_advance(ebr);
+    }
+    return true;
+} /* ebr_retire */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_EBR_IMPL)
+#define _DS_EBR_IMPL
+
+EBR * ebr_init(void *arena, size_t nthreads, size_t limbo,
+               EBRRelease release, void *ctx)
+{
+    if (arena == NULL || release == NULL){
+        return NULL;
+    }
+    if (nthreads == 0 || limbo == 0){
+        return NULL;
+    }
+
+    uint8_t *mem = (uint8_t*)arena;
+    EBR *ebr = (EBR*)arena;
+
+    ebr->epoch = 0;
+    ebr->nthreads = nthreads;
+    ebr->limbo = limbo;
+    ebr->release = release;
+    ebr->ctx = ctx;
+
+    /* point to the end of the EBR struct */
+    mem = &mem[sizeof(EBR)];
+    ebr->threads = (EBRThread*)mem;
+    mem = &mem[sizeof(EBRThread) * nthreads];
+
+    for (size_t i=0; i < nthreads; i++){
+        EBRThread *t = &ebr->threads[i];
+        t->epoch = 0;
+        t->local = 0;
+        t->depth = 0;
+        for (size_t b=0; b < EBR_BUCKETS; b++){
+            t->len[b] = 0;
+        }
+        t->released = 0;
+        t->limbo = (size_t*)mem;
+        mem = &mem[EBR_BUCKETS * limbo * sizeof(size_t)];
+        t->ebr = ebr;
+    }
+
+    return ebr;
+} /* ebr_init */
+
+void ebr_advance(EBR *ebr)
+{
+    if (ebr == NULL){
+        return;
+    }
+
+    size_t e = __atomic_load_n(&ebr->epoch, __ATOMIC_SEQ_CST);
+
+    for (size_t i=0; i < ebr->nthreads; i++){
+        size_t a = __atomic_load_n(&ebr->threads[i].epoch, __ATOMIC_SEQ_CST);
+        if ((a & 1) && (a >> 1) != e){
+            return;
+        }
+    }
+
+    __atomic_compare_exchange_n(&ebr->epoch, &e, e + 1, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+} /* ebr_advance */
+
+void _ebr_release(EBRThread *t, size_t b)
+{
+    EBR *ebr = t->ebr;
+    size_t n = t->len[b];
+
+    if (n == 0){
+        return;
+    }
+    ebr->release(&t->limbo[b * ebr->limbo], n, ebr->ctx);
+    t->len[b] = 0;
+    t->released += n;
+} /* _ebr_release */
+
+void ebr_drain(EBR *ebr)
+{
+    if (ebr == NULL){
+        return;
+    }
+
+    for (size_t i=0; i < ebr->nthreads; i++){
+        EBRThread *t = &ebr->threads[i];
+        assert(t->depth == 0);
+        for (size_t b=0; b < EBR_BUCKETS; b++){
+            _ebr_release(t, b);
+        }
+    }
+} /* ebr_drain */
+
+#endif /* DS_IMPLEMENTATION */
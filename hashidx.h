@@ -0,0 +1,371 @@
+#ifndef _DS_HASHIDX_H
+#define _DS_HASHIDX_H
+
+/* Hash Index on memory arena
+ * Namespace: hashidx
+ *
+ * Open addressing hash table that maps keys to indexes (size_t values),
+ * for example ObjPool indexes (objpool_index): the keys stay in the user
+ * objects, the index stores the hash and the value.
+ * The caller computes the 64 bits hash of the key and provides a match
+ * callback that compares the key with the object referred by a value.
+ *
+ *  size_t slots = hashidx_slots(1000);
+ *  HashIdx *h = hashidx_init(malloc(HASHIDX_SIZEOF(slots)), slots);
+ *  hashidx_insert(h, hash(key), objpool_index(pool, obj));
+ *  size_t i = hashidx_find(h, hash(key), key, match, pool);
+ *
+ * The layout follows the Swiss tables: the slots are in groups of
+ * HASHIDX_GROUP, every slot has a control byte (empty, deleted or the 7 low
+ * bits of the hash as fingerprint) in a separate array, so a probe compares
+ * 16 fingerprints at once (SSE2) and calls match only for the candidates.
+ * The groups are probed in triangular order.
+ * A deleted slot becomes empty again if its group has never been full,
+ * otherwise it remains as tombstone until hashidx_clear.
+ *
+ * The index does not resize: the insert fails once the used slots (with
+ * the tombstones) reach 7/8 of the total.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__) && !defined(HASHIDX_NO_SIMD)
+#define HASHIDX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define HASHIDX_NIL SIZE_MAX
+/* slots compared by a probe step */
+#define HASHIDX_GROUP 16
+/* control bytes, the full slots have the fingerprint in [0, 127] */
+#define HASHIDX_EMPTY ((uint8_t)0x80)
+#define HASHIDX_DELETED ((uint8_t)0xFE)
+/* slots is a power of 2, at least HASHIDX_GROUP, see hashidx_slots */
+#define HASHIDX_SIZEOF(slots) ( sizeof(HashIdx) + \
+        ((1 + sizeof(uint64_t) + sizeof(size_t)) * (size_t)(slots)) )
+
+typedef struct HashIdx HashIdx;
+
+/* Return true if the object referred by value has the key.
+ * ctx is the user pointer passed to the procedures.
+ */
+typedef bool (*HashIdxMatch)(size_t value, const void *key, void *ctx);
+
+struct HashIdx {
+    size_t size;      /* number of slots, power of 2 */
+    size_t len;       /* number of stored values */
+    size_t tombs;     /* number of deleted slots */
+    uint8_t *ctrl;    /* control byte of every slot */
+    uint64_t *hashes; /* hash of every full slot */
+    size_t *values;   /* value of every full slot */
+};
+
+/* Number of slots for n values within the maximum load (7/8).
+ * Return 0 if n is too big.
+ */
+static inline size_t hashidx_slots(size_t n)
+{
+    size_t slots = HASHIDX_GROUP;
+
+    while (slots - slots / 8 < n){
+        if (slots > SIZE_MAX / 2){
+            return 0;
+        }
+        slots <<= 1;
+    }
+    return slots;
+} /* hashidx_slots */
+
+/* Mix the bits of an integer key into a hash (Murmur3 finalizer), for the
+ * keys without a hash function of their own.
+ */
+static inline uint64_t hashidx_mix64(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+} /* hashidx_mix64 */
+
+/* Construct an empty index of slots slots into the memory arena.
+ * slots must be a power of 2, at least HASHIDX_GROUP (see hashidx_slots),
+ * the arena must be at least HASHIDX_SIZEOF(slots) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(slots)
+ * Returns the pointer to the index in the arena or NULL in case of errors
+ */
+HashIdx * hashidx_init(void *arena, size_t slots);
+
+/* Remove all the values and the tombstones.
+ * Time complexity: O(slots)
+ */
+void hashidx_clear(HashIdx *h);
+
+/* Number of values in the index.
+ * Time complexity: O(1)
+ */
+static inline size_t hashidx_len(const HashIdx *h)
+{
+    if (h == NULL){
+        return 0;
+    }
+    return h->len;
+} /* hashidx_len */
+
+/* Return true if an insert would fail for the load limit */
+static inline bool hashidx_isfull(const HashIdx *h)
+{
+    if (h == NULL){
+        return true;
+    }
+    return (h->len + h->tombs + 1) > h->size - h->size / 8;
+} /* hashidx_isfull */
+
+/* Internal use.
+ * Bit i of the result is set if the control byte i of the group at ctrl
+ * is equal to c.
+ */
+static inline uint32_t _hashidx_match(const uint8_t *ctrl, uint8_t c)
+{
+#ifdef HASHIDX_SSE2
+    __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+    __m128i m = _mm_cmpeq_epi8(g, _mm_set1_epi8((char)c));
+    return (uint32_t)_mm_movemask_epi8(m);
+#else
+    uint32_t m = 0;
+    for (uint32_t i=0; i < HASHIDX_GROUP; i++){
+        m |= (uint32_t)(ctrl[i] == c) << i;
+    }
+    return m;
+#endif
+} /* _hashidx_match */
+
+/* Internal use.
+ * Bit i of the result is set if the slot i of the group at ctrl is free
+ * (empty or deleted).
+ */
+static inline uint32_t _hashidx_free(const uint8_t *ctrl)
+{
+#ifdef HASHIDX_SSE2
+    /* the free control bytes are the only negative ones */
+    __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+    return (uint32_t)_mm_movemask_epi8(g);
+#else
+    uint32_t m = 0;
+    for (uint32_t i=0; i < HASHIDX_GROUP; i++){
+        m |= (uint32_t)(ctrl[i] >> 7) << i;
+    }
+    return m;
+#endif
+} /* _hashidx_free */
+
+/* Internal use.
+ * Index of the lowest set bit, m must not be 0.
+ */
+static inline uint32_t _hashidx_first(uint32_t m)
+{
+    assert(m != 0);
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(m);
+#else
+    uint32_t i = 0;
+    while ((m & 1) == 0){
+        m >>= 1;
+        i++;
+    }
+    return i;
+#endif
+} /* _hashidx_first */
+
+/* Internal use.
+ * Search the slot of the value with the key.
+ * return the slot or HASHIDX_NIL
+ */
+static inline size_t _hashidx_search(const HashIdx *h, uint64_t hash,
+                                     const void *key, HashIdxMatch match,
+                                     void *ctx)
+{
+    const uint8_t h2 = (uint8_t)(hash & 0x7F);
+    const size_t mask = h->size - 1;
+    size_t pos = (size_t)(hash >> 7) & mask & ~(size_t)(HASHIDX_GROUP - 1);
+
+    for (size_t step=HASHIDX_GROUP; ; step += HASHIDX_GROUP){
+        const uint8_t *g = &h->ctrl[pos];
+
+        for (uint32_t m = _hashidx_match(g, h2); m != 0; m &= m - 1){
+            size_t s = pos + _hashidx_first(m);
+            if (h->hashes[s] == hash && match(h->values[s], key, ctx)){
+                return s;
+            }
+        }
+        /* the value would be in the first empty slot */
+        if (_hashidx_match(g, HASHIDX_EMPTY) != 0){
+            return HASHIDX_NIL;
+        }
+        /* triangular probing visits all the groups */
+        pos = (pos + step) & mask;
+        if (step > h->size){
+            return HASHIDX_NIL;
+        }
+    }
+} /* _hashidx_search */
+
+/* Search the value of the key.
+ * hash is the hash of key, match compares key with the object of a value.
+ * Time complexity: O(1) expected
+ * Return the value or HASHIDX_NIL if not found.
+ */
+static inline size_t hashidx_find(const HashIdx *h, uint64_t hash,
+                                  const void *key, HashIdxMatch match,
+                                  void *ctx)
+{
+    if (h == NULL || match == NULL){
+        return HASHIDX_NIL;
+    }
+
+    size_t s = _hashidx_search(h, hash, key, match, ctx);
+    if (s == HASHIDX_NIL){
+        return HASHIDX_NIL;
+    }
+    return h->values[s];
+} /* hashidx_find */
+
+/* Insert the value with the hash of its key.
+ * The key must not be already in the index (hashidx_find first),
+ * otherwise the duplicate is stored.
+ * value can not be HASHIDX_NIL.
+ * Time complexity: O(1) expected
+ * Return true if inserted, false if the index is full.
+ */
+static inline bool hashidx_insert(HashIdx *h, uint64_t hash, size_t value)
+{
+    if (h == NULL || value == HASHIDX_NIL){
+        return false;
+    }
+    if (hashidx_isfull(h)){
+        return false;
+    }
+
+    const size_t mask = h->size - 1;
+    size_t pos = (size_t)(hash >> 7) & mask & ~(size_t)(HASHIDX_GROUP - 1);
+
+    /* there is at least a free slot, the first one in probe order */
+    for (size_t step=HASHIDX_GROUP; ; step += HASHIDX_GROUP){
+        uint32_t m = _hashidx_free(&h->ctrl[pos]);
+        if (m != 0){
+            size_t s = pos + _hashidx_first(m);
+            if (h->ctrl[s] == HASHIDX_DELETED){
+                h->tombs--;
+            }
+            h->ctrl[s] = (uint8_t)(hash & 0x7F);
+            h->hashes[s] = hash;
+            h->values[s] = value;
+            h->len++;
+            return true;
+        }
+        pos = (pos + step) & mask;
+    }
+} /* hashidx_insert */
+
+/* Remove the value of the key.
+ * Time complexity: O(1) expected
+ * Return the removed value or HASHIDX_NIL if not found.
+ */
+static inline size_t hashidx_delete(HashIdx *h, uint64_t hash,
+                                    const void *key, HashIdxMatch match,
+                                    void *ctx)
+{
+    if (h == NULL || match == NULL){
+        return HASHIDX_NIL;
+    }
+
+    size_t s = _hashidx_search(h, hash, key, match, ctx);
+    if (s == HASHIDX_NIL){
+        return HASHIDX_NIL;
+    }
+
+    /* A group with an empty slot has never been full, so no probe went
+     * beyond it: the slot can be empty again.
+     */
+    const uint8_t *g = &h->ctrl[s & ~(size_t)(HASHIDX_GROUP - 1)];
+    if (_hashidx_match(g, HASHIDX_EMPTY) != 0){
+        h->ctrl[s] = HASHIDX_EMPTY;
+    } else {
+        h->ctrl[s] = HASHIDX_DELETED;
+        h->tombs++;
+    }
+    h->len--;
+
+    return h->values[s];
+} /* hashidx_delete */
+
+/* Iterate the values in slot order, starting with *pos = 0.
+ * The index must not change during the iteration.
+ * Return the next value or HASHIDX_NIL at the end.
+ */
+static inline size_t hashidx_next(const HashIdx *h, size_t *pos)
+{
+    if (h == NULL || pos == NULL){
+        return HASHIDX_NIL;
+    }
+
+    for (size_t s = *pos; s < h->size; s++){
+        if ((h->ctrl[s] & 0x80) == 0){
+            *pos = s + 1;
+            return h->values[s];
+        }
+    }
+    *pos = h->size;
+    return HASHIDX_NIL;
+} /* hashidx_next */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_HASHIDX_IMPL)
+#define _DS_HASHIDX_IMPL
+
+HashIdx * hashidx_init(void *arena, size_t slots)
+{
+    if (arena == NULL || slots < HASHIDX_GROUP){
+        return NULL;
+    }
+    if ((slots & (slots - 1)) != 0){
+        return NULL;
+    }
+
+    /* point to the end of the HashIdx struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(HashIdx)];
+
+    HashIdx *h = (HashIdx*)arena;
+    h->size = slots;
+    /* the hashes and the values are aligned: slots is a multiple of 16 */
+    h->hashes = (uint64_t*)mem;
+    h->values = (size_t*)&mem[slots * sizeof(uint64_t)];
+    h->ctrl = &mem[slots * (sizeof(uint64_t) + sizeof(size_t))];
+
+    hashidx_clear(h);
+
+    return h;
+} /* hashidx_init */
+
+void hashidx_clear(HashIdx *h)
+{
+    if (h == NULL){
+        return;
+    }
+
+    memset(h->ctrl, HASHIDX_EMPTY, h->size);
+    h->len = 0;
+    h->tombs = 0;
+} /* hashidx_clear */
+
+#endif /* DS_IMPLEMENTATION */
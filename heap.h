@@ -0,0 +1,308 @@
+#ifndef _DS_HEAP_H
+#define _DS_HEAP_H
+
+/* Heap (priority queue index) on memory arena.
+ * Namespace: heap
+ *
+ * Min-heap of the ids [0, capacity) of the elements of a user array of
+ * keys: the heap stores and moves only the ids, the keys stay in the array
+ * and are compared through the user comparator.
+ * It is 4-ary: the 4 children of a node are adjacent (often in the same
+ * cache line) and the tree is half as deep as a binary one.
+ * A position map (id -> position in the heap) gives O(log n) update of the
+ * key of any id (decrease-key) and removal by id.
+ *
+ * The keys must be stored outside the heap and
+ * guaranteed to be in the same scope of the heap.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define HEAP_NIL SIZE_MAX
+/* children of every node */
+#define HEAP_ARITY 4
+#define HEAP_SIZEOF(n) ( sizeof(HeapIndex) + (2 * sizeof(size_t) * (size_t)(n)) )
+
+typedef struct HeapIndex HeapIndex;
+
+/* Compare two keys, as qsort does.
+ * Return <0, 0, >0 if a is less, equal or greater than b: the least key is
+ * the top of the heap.
+ */
+typedef int (*HeapCompare)(const void *a, const void *b);
+
+struct HeapIndex {
+    size_t size;   /* capacity, the ids are in [0, size) */
+    size_t len;    /* number of ids in the heap */
+    const uint8_t *keys; /* user array of 'size' keys */
+    size_t keysize;      /* bytes of a key */
+    HeapCompare cmp;
+    size_t *heap;  /* ids in heap order */
+    size_t *pos;   /* position of every id in heap, HEAP_NIL if absent */
+};
+
+/* Construct an empty heap of indicated capacity into the memory arena,
+ * over the array keys of capacity keys of keysize bytes.
+ * The arena must be at least HEAP_SIZEOF(capacity) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(capacity)
+ * Returns the pointer to the heap in the arena or NULL in case of errors
+ */
+HeapIndex * heap_init(void *arena, size_t capacity, const void *keys,
+                      size_t keysize, HeapCompare cmp);
+
+/* Put the ids [0, n) in the heap, replacing its content, in O(n) instead
+ * of n pushes (bottom-up heap construction).
+ * Return false if n is greater than the capacity.
+ */
+bool heap_heapify(HeapIndex *h, size_t n);
+
+/* Number of ids in the heap.
+ * Time complexity: O(1)
+ */
+static inline size_t heap_len(const HeapIndex *h)
+{
+    if (h == NULL){
+        return 0;
+    }
+    return h->len;
+} /* heap_len */
+
+static inline bool heap_isempty(const HeapIndex *h)
+{
+    return heap_len(h) == 0;
+} /* heap_isempty */
+
+/* Return true if the id is in the heap */
+static inline bool heap_contains(const HeapIndex *h, size_t id)
+{
+    if (h == NULL || id >= h->size){
+        return false;
+    }
+    return h->pos[id] != HEAP_NIL;
+} /* heap_contains */
+
+/* Id with the least key, without removing it.
+ * Time complexity: O(1)
+ * Return the id or HEAP_NIL if the heap is empty.
+ */
+static inline size_t heap_top(const HeapIndex *h)
+{
+    if (h == NULL || h->len == 0){
+        return HEAP_NIL;
+    }
+    return h->heap[0];
+} /* heap_top */
+
+/* Internal use.
+ * Compare the keys of two ids.
+ */
+static inline int _heap_cmp(const HeapIndex *h, size_t a, size_t b)
+{
+    return h->cmp(&h->keys[a * h->keysize], &h->keys[b * h->keysize]);
+} /* _heap_cmp */
+
+/* Internal use.
+ * Move the id at i up to its place, shifting down the parents (no swaps).
+ * Return the final position.
+ */
+static inline size_t _heap_up(HeapIndex *h, size_t i)
+{
+    size_t id = h->heap[i];
+
+    while (i > 0){
+        size_t parent = (i - 1) / HEAP_ARITY;
+        size_t p = h->heap[parent];
+        if (_heap_cmp(h, id, p) >= 0){
+            break;
+        }
+        h->heap[i] = p;
+        h->pos[p] = i;
+        i = parent;
+    }
+    h->heap[i] = id;
+    h->pos[id] = i;
+    return i;
+} /* _heap_up */
+
+/* Internal use.
+ * Move the id at i down to its place, shifting up the least children.
+ */
+static inline void _heap_down(HeapIndex *h, size_t i)
+{
+    size_t id = h->heap[i];
+
+    for (;;){
+        size_t first = i * HEAP_ARITY + 1;
+        if (first >= h->len){
+            break;
+        }
+        size_t last = first + HEAP_ARITY;
+        last = (last > h->len)?h->len:last;
+
+        size_t least = first;
+        for (size_t c = first + 1; c < last; c++){
+            if (_heap_cmp(h, h->heap[c], h->heap[least]) < 0){
+                least = c;
+            }
+        }
+        size_t l = h->heap[least];
+        if (_heap_cmp(h, l, id) >= 0){
+            break;
+        }
+        h->heap[i] = l;
+        h->pos[l] = i;
+        i = least;
+    }
+    h->heap[i] = id;
+    h->pos[id] = i;
+} /* _heap_down */
+
+/* Insert the id, with its key already in the array.
+ * Time complexity: O(log n)
+ * Return false if the id is out of range or already in the heap.
+ */
+static inline bool heap_push(HeapIndex *h, size_t id)
+{
+    if (h == NULL || id >= h->size || h->pos[id] != HEAP_NIL){
+        return false;
+    }
+
+    h->heap[h->len] = id;
+    h->len++;
+    _heap_up(h, h->len - 1);
+    return true;
+} /* heap_push */
+
+/* Internal use.
+ * Remove the id at position i, filling the hole with the last one.
+ */
+static inline void _heap_remove_at(HeapIndex *h, size_t i)
+{
+    size_t id = h->heap[i];
+    h->pos[id] = HEAP_NIL;
+    h->len--;
+
+    if (i == h->len){
+        return;
+    }
+    h->heap[i] = h->heap[h->len];
+    /* the last one can go up (another subtree) or down */
+    if (_heap_up(h, i) == i){
+        _heap_down(h, i);
+    }
+} /* _heap_remove_at */
+
+/* Remove the id with the least key.
+ * Time complexity: O(log n)
+ * Return the id or HEAP_NIL if the heap is empty.
+ */
+static inline size_t heap_pop(HeapIndex *h)
+{
+    if (h == NULL || h->len == 0){
+        return HEAP_NIL;
+    }
+
+    size_t id = h->heap[0];
+    _heap_remove_at(h, 0);
+    return id;
+} /* heap_pop */
+
+/* Remove the id from any position (e.g. a cancelled timer).
+ * Time complexity: O(log n)
+ * Return false if the id is not in the heap.
+ */
+static inline bool heap_remove(HeapIndex *h, size_t id)
+{
+    if (!heap_contains(h, id)){
+        return false;
+    }
+
+    _heap_remove_at(h, h->pos[id]);
+    return true;
+} /* heap_remove */
+
+/* Restore the order after the key of id has changed in the array, lower
+ * (decrease-key) or greater.
+ * Time complexity: O(log n)
+ * Return false if the id is not in the heap.
+ */
+static inline bool heap_update(HeapIndex *h, size_t id)
+{
+    if (!heap_contains(h, id)){
+        return false;
+    }
+
+    size_t i = h->pos[id];
+    if (_heap_up(h, i) == i){
+        _heap_down(h, i);
+    }
+    return true;
+} /* heap_update */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_HEAP_IMPL)
+#define _DS_HEAP_IMPL
+
+HeapIndex * heap_init(void *arena, size_t capacity, const void *keys,
+                      size_t keysize, HeapCompare cmp)
+{
+    if (arena == NULL || keys == NULL || cmp == NULL){
+        return NULL;
+    }
+    if (capacity == 0 || capacity == HEAP_NIL || keysize == 0){
+        return NULL;
+    }
+
+    /* point to the end of the HeapIndex struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(HeapIndex)];
+
+    HeapIndex *h = (HeapIndex*)arena;
+    h->size = capacity;
+    h->len = 0;
+    h->keys = (const uint8_t*)keys;
+    h->keysize = keysize;
+    h->cmp = cmp;
+    h->heap = (size_t*)mem;
+    h->pos = &h->heap[capacity];
+
+    for (size_t id=0; id < capacity; id++){
+        h->pos[id] = HEAP_NIL;
+    }
+
+    return h;
+} /* heap_init */
+
+bool heap_heapify(HeapIndex *h, size_t n)
+{
+    if (h == NULL || n > h->size){
+        return false;
+    }
+
+    for (size_t i=0; i < h->len; i++){
+        h->pos[h->heap[i]] = HEAP_NIL;
+    }
+    for (size_t id=0; id < n; id++){
+        h->heap[id] = id;
+        h->pos[id] = id;
+    }
+    h->len = n;
+
+    /* sift down the internal nodes, from the last one */
+    if (n > 1){
+        for (size_t i = (n - 2) / HEAP_ARITY + 1; i > 0; i--){
+            _heap_down(h, i - 1);
+        }
+    }
+
+    return true;
+} /* heap_heapify */
+
+#endif /* DS_IMPLEMENTATION */
@@ -0,0 +1,287 @@
+#ifndef _DS_ILIST_H
+#define _DS_ILIST_H
+
+/* Intrusive Single Linked List
+ * Namespace: ilist
+ *
+ * The link is embedded in the user objects (IListLink member), stored in
+ * an array of objects with a fixed stride (a plain array or the arena of an
+ * ObjPool). The objects are identified by their index in the array and the
+ * list walks them directly, without the item to object indirection of
+ * SList.
+ *
+ *  struct Job {
+ *      int deadline;
+ *      IListLink link;
+ *  };
+ *
+ *  struct Job jobs[N];
+ *  IList list;
+ *  ILIST_INIT(&list, jobs, struct Job, link);
+ *
+ * The list does not own the objects: an object can be in one list at time
+ * for every IListLink member it has.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define ILIST_NIL SIZE_MAX
+
+/* Initialize the list on an array of objects of the given type,
+ * member is the name of the IListLink field.
+ */
+#define ILIST_INIT(list, base, type, member) \
+    ilist_init((list), (base), sizeof(type), offsetof(type, member))
+
+typedef struct IList IList;
+typedef struct IListLink IListLink;
+typedef struct IListIter IListIter;
+
+/* the link to embed in the user object */
+struct IListLink {
+    size_t next;  /* index of the next object */
+};
+
+struct IList {
+    size_t len;     /* number of linked objects */
+    size_t head;    /* index of the list head object */
+    uint8_t *base;  /* address of the object of index 0 */
+    size_t stride;  /* bytes between two consecutive objects */
+    size_t offset;  /* offset of the IListLink in the object */
+};
+
+/* IList iterator.
+ * It refers to objects from the first to the ILIST_NIL
+ */
+struct IListIter {
+    size_t prev; /* index of the previous object */
+    size_t curr; /* index of the current object */
+    IList *list; /* the reference to the list under iteration */
+};
+
+/* Initialize an empty list on the objects starting from base, stride bytes
+ * apart, with the IListLink at offset bytes from the object start.
+ * For an ObjPool: ilist_init(list, objpool_at(pool, 0), pool->blksize, off)
+ * Time complexity: O(1)
+ * Return false in case of invalid arguments.
+ */
+static inline bool ilist_init(IList *list, void *base, size_t stride, size_t offset)
+{
+    if (list == NULL || base == NULL){
+        return false;
+    }
+    if (stride == 0 || offset + sizeof(IListLink) > stride){
+        return false;
+    }
+
+    list->len = 0;
+    list->head = ILIST_NIL;
+    list->base = (uint8_t*)base;
+    list->stride = stride;
+    list->offset = offset;
+
+    return true;
+} /* ilist_init */
+
+/* Number of objects in the list.
+ * Time complexity: O(1)
+ */
+static inline size_t ilist_len(const IList *list)
+{
+    if (list == NULL){
+        return 0;
+    }
+    return list->len;
+} /* ilist_len */
+
+/* same as
+ * ilist_len(list) == 0
+ */
+static inline bool ilist_isempty(const IList *list)
+{
+    if (list == NULL){
+        return true;
+    }
+    return list->len == 0;
+} /* ilist_isempty */
+
+/* Pointer to the object of index i, NULL for ILIST_NIL */
+static inline void * ilist_object(const IList *list, size_t i)
+{
+    if (list == NULL || i == ILIST_NIL){
+        return NULL;
+    }
+    return (void *)&list->base[i * list->stride];
+} /* ilist_object */
+
+/* Index of the object, the inverse of ilist_object.
+ * obj must be in the array of the list.
+ */
+static inline size_t ilist_index(const IList *list, const void *obj)
+{
+    if (list == NULL || obj == NULL){
+        return ILIST_NIL;
+    }
+
+    const uint8_t *p = (const uint8_t *)obj;
+    assert(p >= list->base);
+    assert((size_t)(p - list->base) % list->stride == 0);
+
+    return (size_t)(p - list->base) / list->stride;
+} /* ilist_index */
+
+/* Internal use.
+ * The link embedded in the object of index i.
+ */
+static inline IListLink * _ilist_link(const IList *list, size_t i)
+{
+    assert(i != ILIST_NIL);
+    return (IListLink *)&list->base[i * list->stride + list->offset];
+} /* _ilist_link */
+
+/* Return true if the iterator has reached the end of the list */
+static inline bool ilist_exhausted(IListIter it)
+{
+    return it.curr == ILIST_NIL;
+} /* ilist_exhausted */
+
+/* Get the object pointed by the iterator.
+ * Return NULL if iterator is exhausted.
+ */
+static inline void * ilist_value(IListIter it)
+{
+    if (it.curr == ILIST_NIL){
+        return NULL;
+    }
+
+    assert(it.list != NULL);
+
+    return ilist_object(it.list, it.curr);
+} /* ilist_value */
+
+/* Start an iterator and returns the first object.
+ * Return NULL if no objects present in the list.
+ */
+static inline void * ilist_iter(IListIter *it, IList *list)
+{
+    if (list == NULL || it == NULL){
+        return NULL;
+    }
+
+    it->prev = ILIST_NIL;
+    it->curr = list->head;
+    it->list = list;
+
+    return ilist_value(*it);
+} /* ilist_iter */
+
+/* Move the iterator to the next object, if possible.
+ * Return if the operation succeeded.
+ */
+static inline bool ilist_next(IListIter *it)
+{
+    if (it == NULL){
+        return false;
+    }
+    if (it->curr == ILIST_NIL){
+        return false;
+    }
+
+    it->prev = it->curr;
+    it->curr = _ilist_link(it->list, it->curr)->next;
+
+    return true;
+} /* ilist_next */
+
+/* Link obj before the object pointed by it.
+ * obj must be in the array of the list and not already linked.
+ * Time complexity: O(1)
+ * Return true if obj is inserted.
+ */
+static inline bool ilist_insert(IListIter *it, void *obj)
+{
+    if (it == NULL || obj == NULL){
+        return false;
+    }
+
+    IList *list = it->list;
+    size_t i = ilist_index(list, obj);
+
+    _ilist_link(list, i)->next = it->curr;
+
+    if (it->prev == ILIST_NIL){
+        list->head = i; /* new head */
+    } else {
+        _ilist_link(list, it->prev)->next = i;
+    }
+
+    /* the new object is now preceding the current (untouched) */
+    it->prev = i;
+    list->len++;
+
+    return true;
+} /* ilist_insert */
+
+/* Unlink the object referred by it, the object is not touched.
+ * Return true if the operation succeed.
+ */
+static inline bool ilist_delete(IListIter *it)
+{
+    if (it == NULL){
+        return false;
+    }
+    if (it->curr == ILIST_NIL){
+        return false;
+    }
+
+    IList *list = it->list;
+    assert(list != NULL);
+    assert(list->len > 0);
+
+    size_t next = _ilist_link(list, it->curr)->next;
+    if (it->prev == ILIST_NIL){
+        assert(list->head == it->curr);
+        list->head = next;
+    } else {
+        _ilist_link(list, it->prev)->next = next;
+    }
+    it->curr = next;
+    list->len--;
+
+    return true;
+} /* ilist_delete */
+
+/* as stacks, link obj at the head.
+ * Return true if succeed.
+ */
+static inline bool ilist_push(IList *list, void *obj)
+{
+    if (list == NULL){
+        return false;
+    }
+
+    IListIter it;
+    ilist_iter(&it, list);
+    return ilist_insert(&it, obj);
+} /* ilist_push */
+
+/* as stacks, unlink the head
+ * return the unlinked object (or NULL if empty)
+ */
+static inline void * ilist_pop(IList *list)
+{
+    if (list == NULL){
+        return NULL;
+    }
+
+    IListIter it;
+    void *obj = ilist_iter(&it, list);
+    ilist_delete(&it);
+    return obj;
+} /* ilist_pop */
+
+#endif
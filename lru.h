@@ -0,0 +1,408 @@
+#ifndef _DS_LRU_H
+#define _DS_LRU_H
+
+/* LRU Cache on memory arena
+ * Namespace: lru
+ *
+ * Fixed capacity cache of objects of objsize bytes: the objects come from
+ * an ObjPool, a HashIdx finds them by key and a doubly linked list by index
+ * (a link per pool slot, beside the pool) keeps them in order of recency.
+ * get, put, delete and evict are O(1).
+ * The keys are stored by the user in the objects: the caller computes the
+ * 64 bits hash of the key (see hashidx_mix64) and provides a match callback
+ * that compares the key with an object.
+ *
+ *  LRUCache *c = lru_init(malloc(LRU_SIZEOF(n, sizeof(Entry))), n,
+ *                         sizeof(Entry), entry_match, LRU_STRICT);
+ *  Entry *e = lru_get(c, hash(key), &key);
+ *  if (e == NULL){
+ *      e = lru_put(c, hash(key), &key, NULL); // evicts the least recent
+ *      e->key = key;
+ *      ...
+ *  }
+ *
+ * Modes:
+ * - LRU_STRICT: a hit moves the object to the head of the list, the victim
+ *   is the least recently used;
+ * - LRU_CLOCK: a hit only sets the reference byte of the object (no write
+ *   of the links, better for read heavy workloads), the list is in order of
+ *   insertion and the victim is the oldest object not referenced since its
+ *   last chance: the referenced ones are moved to the head with the byte
+ *   cleared (second chance).
+ *
+ * The index has room for 2 * capacity keys, the tombstones left by the
+ * deletes are removed rebuilding it from the list when it gets full.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+#include "objpool.h"
+#include "hashidx.h"
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define LRU_NIL SIZE_MAX
+
+/* modes of the cache */
+#define LRU_STRICT 0
+#define LRU_CLOCK 1
+
+/* Internal use.
+ * Slots of the index for cnt objects.
+ */
+#define _LRU_SLOTS(cnt) hashidx_slots(2 * (size_t)(cnt))
+
+/* the reference bytes are the last ones, after the pool blocks */
+#define LRU_SIZEOF(cnt, objsize) ( sizeof(LRUCache) + \
+        ((sizeof(LRULink) + sizeof(uint64_t) + 1) * (size_t)(cnt)) + \
+        HASHIDX_SIZEOF(_LRU_SLOTS(cnt)) + OBJPOOL_SIZEOF(cnt, objsize) )
+
+typedef struct LRUCache LRUCache;
+typedef struct LRULink LRULink;
+
+/* Return true if the object has the key */
+typedef bool (*LRUMatch)(const void *obj, const void *key);
+
+struct LRULink {
+    size_t prev;  /* index of the previous (more recent) object */
+    size_t next;  /* index of the next (less recent) object */
+};
+
+struct LRUCache {
+    size_t size;      /* capacity */
+    unsigned mode;    /* LRU_STRICT or LRU_CLOCK */
+    size_t head;      /* index of the most recent object */
+    size_t tail;      /* index of the least recent object, the victim */
+    LRUMatch match;
+    ObjPool pool;     /* the objects, indexed by objpool_index */
+    LRULink *links;   /* link of every pool slot */
+    uint64_t *hashes; /* hash of the key of every pool slot */
+    uint8_t *refs;    /* reference byte of every pool slot (LRU_CLOCK) */
+    HashIdx *index;   /* hash of the key -> pool slot */
+};
+
+/* Construct an empty cache of capacity objects of objsize bytes into the
+ * memory arena, match compares a key with an object.
+ * The arena must be at least LRU_SIZEOF(capacity, objsize) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(capacity)
+ * Returns the pointer to the cache in the arena or NULL in case of errors
+ */
+LRUCache * lru_init(void *arena, size_t capacity, size_t objsize,
+                    LRUMatch match, unsigned mode);
+
+/* Remove all the objects.
+ * Time complexity: O(capacity)
+ */
+void lru_clear(LRUCache *c);
+
+/* Internal use.
+ * Rebuild the index from the list, without the tombstones.
+ */
+void _lru_rehash(LRUCache *c);
+
+/* Number of objects in the cache.
+ * Time complexity: O(1)
+ */
+static inline size_t lru_len(const LRUCache *c)
+{
+    if (c == NULL){
+        return 0;
+    }
+    return c->pool.len;
+} /* lru_len */
+
+/* Return true if a put of a new key evicts an object */
+static inline bool lru_isfull(const LRUCache *c)
+{
+    if (c == NULL){
+        return true;
+    }
+    return c->pool.len == c->size;
+} /* lru_isfull */
+
+/* Internal use.
+ * Match adapter for the index, ctx is the cache.
+ */
+static inline bool _lru_match(size_t value, const void *key, void *ctx)
+{
+    LRUCache *c = (LRUCache*)ctx;
+    return c->match(objpool_at(&c->pool, value), key);
+} /* _lru_match */
+
+/* Internal use.
+ * Match the slot itself, key points to the slot index.
+ */
+static inline bool _lru_same(size_t value, const void *key, void *ctx)
+{
+    (void)ctx;
+    return value == *(const size_t*)key;
+} /* _lru_same */
+
+/* Internal use.
+ * Link the slot i at the head of the list.
+ */
+static inline void _lru_link_head(LRUCache *c, size_t i)
+{
+    c->links[i].prev = LRU_NIL;
+    c->links[i].next = c->head;
+    if (c->head != LRU_NIL){
+        c->links[c->head].prev = i;
+    } else {
+        c->tail = i;
+    }
+    c->head = i;
+} /* _lru_link_head */
+
+/* Internal use.
+ * Unlink the slot i from the list.
+ */
+static inline void _lru_unlink(LRUCache *c, size_t i)
+{
+    LRULink *l = &c->links[i];
+
+    if (l->prev != LRU_NIL){
+        c->links[l->prev].next = l->next;
+    } else {
+        c->head = l->next;
+    }
+    if (l->next != LRU_NIL){
+        c->links[l->next].prev = l->prev;
+    } else {
+        c->tail = l->prev;
+    }
+} /* _lru_unlink */
+
+/* Internal use.
+ * Remove the slot i from the index and the list and release its object.
+ */
+static inline void _lru_remove(LRUCache *c, size_t i)
+{
+    size_t r = hashidx_delete(c->index, c->hashes[i], &i, _lru_same, NULL);
+    assert(r == i);
+    (void)r;
+    _lru_unlink(c, i);
+    objpool_release(&c->pool, objpool_at(&c->pool, i));
+} /* _lru_remove */
+
+/* Search the object of the key without changing its recency.
+ * Time complexity: O(1) expected
+ * Return the object or NULL if not found.
+ */
+static inline void * lru_peek(const LRUCache *c, uint64_t hash,
+                              const void *key)
+{
+    if (c == NULL){
+        return NULL;
+    }
+
+    size_t i = hashidx_find(c->index, hash, key, _lru_match, (void*)c);
+    if (i == HASHIDX_NIL){
+        return NULL;
+    }
+    return objpool_at(&c->pool, i);
+} /* lru_peek */
+
+/* Search the object of the key and mark it as recently used.
+ * Time complexity: O(1) expected
+ * Return the object or NULL if not found.
+ */
+static inline void * lru_get(LRUCache *c, uint64_t hash, const void *key)
+{
+    if (c == NULL){
+        return NULL;
+    }
+
+    size_t i = hashidx_find(c->index, hash, key, _lru_match, c);
+    if (i == HASHIDX_NIL){
+        return NULL;
+    }
+
+    if (c->mode == LRU_CLOCK){
+        /* no write if already referenced */
+        if (c->refs[i] == 0){
+            c->refs[i] = 1;
+        }
+    } else if (c->head != i){
+        _lru_unlink(c, i);
+        _lru_link_head(c, i);
+    }
+    return objpool_at(&c->pool, i);
+} /* lru_get */
+
+/* Remove the victim: the least recently used object (LRU_STRICT) or the
+ * oldest one not referenced (LRU_CLOCK).
+ * Time complexity: O(1), amortized for LRU_CLOCK
+ * Return the evicted object, its content is valid up to the next put, or
+ * NULL if the cache is empty.
+ */
+static inline void * lru_evict(LRUCache *c)
+{
+    if (c == NULL || c->tail == LRU_NIL){
+        return NULL;
+    }
+
+    size_t i = c->tail;
+    if (c->mode == LRU_CLOCK){
+        /* second chance: the referenced ones go to the head */
+        while (c->refs[i] != 0){
+            c->refs[i] = 0;
+            _lru_unlink(c, i);
+            _lru_link_head(c, i);
+            i = c->tail;
+        }
+    }
+
+    _lru_remove(c, i);
+    return objpool_at(&c->pool, i);
+} /* lru_evict */
+
+/* Search the object of the key, or add one for it evicting the victim if
+ * the cache is full (see lru_evict). The new object is not initialized:
+ * the caller writes the key in it before any other lookup.
+ * found (if not NULL) tells if the key was already in the cache.
+ * Time complexity: O(1) expected
+ * Return the object or NULL in case of errors.
+ */
+static inline void * lru_put(LRUCache *c, uint64_t hash, const void *key,
+                             bool *found)
+{
+    if (c == NULL){
+        return NULL;
+    }
+
+    void *obj = lru_get(c, hash, key);
+    if (found != NULL){
+        *found = (obj != NULL);
+    }
+    if (obj != NULL){
+        return obj;
+    }
+
+    if (c->pool.len == c->size){
+        lru_evict(c);
+    }
+    if (hashidx_isfull(c->index)){
+        _lru_rehash(c);
+    }
+
+    obj = objpool_acquire(&c->pool);
+    assert(obj != NULL);
+    size_t i = objpool_index(&c->pool, obj);
+
+    bool ok = hashidx_insert(c->index, hash, i);
+    assert(ok);
+    (void)ok;
+    c->hashes[i] = hash;
+    c->refs[i] = 0;
+    _lru_link_head(c, i);
+    return obj;
+} /* lru_put */
+
+/* Remove the object of the key.
+ * Time complexity: O(1) expected
+ * Return false if not found.
+ */
+static inline bool lru_delete(LRUCache *c, uint64_t hash, const void *key)
+{
+    if (c == NULL){
+        return false;
+    }
+
+    size_t i = hashidx_find(c->index, hash, key, _lru_match, c);
+    if (i == HASHIDX_NIL){
+        return false;
+    }
+    _lru_remove(c, i);
+    return true;
+} /* lru_delete */
+
+/* Iterate the objects from the most recent, starting with *pos = LRU_NIL.
+ * The cache must not change during the iteration.
+ * Return the next object or NULL at the end.
+ */
+static inline void * lru_next(const LRUCache *c, size_t *pos)
+{
+    if (c == NULL || pos == NULL){
+        return NULL;
+    }
+
+    size_t i = (*pos == LRU_NIL)?c->head:c->links[*pos].next;
+    *pos = i;
+    if (i == LRU_NIL){
+        return NULL;
+    }
+    return objpool_at(&c->pool, i);
+} /* lru_next */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_LRU_IMPL)
+#define _DS_LRU_IMPL
+
+LRUCache * lru_init(void *arena, size_t capacity, size_t objsize,
+                    LRUMatch match, unsigned mode)
+{
+    if (arena == NULL || match == NULL || objsize == 0){
+        return NULL;
+    }
+    if (capacity == 0 || capacity >= SIZE_MAX / 4){
+        return NULL;
+    }
+    if (mode != LRU_STRICT && mode != LRU_CLOCK){
+        return NULL;
+    }
+
+    /* point to the end of the LRUCache struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(LRUCache)];
+
+    LRUCache *c = (LRUCache*)arena;
+    c->size = capacity;
+    c->mode = mode;
+    c->match = match;
+
+    c->links = (LRULink*)mem;
+    mem = &mem[capacity * sizeof(LRULink)];
+    c->hashes = (uint64_t*)mem;
+    mem = &mem[capacity * sizeof(uint64_t)];
+
+    size_t slots = _LRU_SLOTS(capacity);
+    c->index = hashidx_init(mem, slots);
+    mem = &mem[HASHIDX_SIZEOF(slots)];
+
+    if (c->index == NULL || !objpool_init(&c->pool, mem, capacity, objsize)){
+        return NULL;
+    }
+    c->refs = &mem[OBJPOOL_SIZEOF(capacity, objsize)];
+    c->head = LRU_NIL;
+    c->tail = LRU_NIL;
+
+    return c;
+} /* lru_init */
+
+void lru_clear(LRUCache *c)
+{
+    if (c == NULL){
+        return;
+    }
+
+    objpool_init(&c->pool, c->pool.blocks, c->size, c->pool.objsize);
+    hashidx_clear(c->index);
+    c->head = LRU_NIL;
+    c->tail = LRU_NIL;
+} /* lru_clear */
+
+void _lru_rehash(LRUCache *c)
+{
+    hashidx_clear(c->index);
+    for (size_t i = c->head; i != LRU_NIL; i = c->links[i].next){
+        bool ok = hashidx_insert(c->index, c->hashes[i], i);
+        assert(ok);
+        (void)ok;
+    }
+} /* _lru_rehash */
+
+#endif /* DS_IMPLEMENTATION */
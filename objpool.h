@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
+#include "stats.h"
 
 struct ObjPoolBlock {
     size_t next;   /* index in the pool of the next free block */
@@ -24,7 +25,9 @@ struct ObjPoolBlock {
 
 typedef struct ObjPoolBlock ObjPoolBlock;
 
-#define OBJPOOL_SIZEOF(cnt, objsize) (((size_t)cnt) * (((size_t)objsize) + sizeof(ObjPoolBlock)))
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define OBJPOOL_NIL SIZE_MAX
+#define OBJPOOL_SIZEOF(cnt, objsize) (((size_t)(cnt)) * (((size_t)(objsize)) + sizeof(ObjPoolBlock)))
 
 struct ObjPool {
     size_t size;     /* max number of blocks */
@@ -33,6 +36,7 @@ struct ObjPool {
     size_t len;      /* number of blocks allocated */
     size_t head;     /* index of the first free block */
     uint8_t *blocks; /* the raw memmory in bytes */
+    DS_STATS_MEMBER  /* see stats.h */
 };
 
 typedef struct ObjPool ObjPool;
@@ -42,47 +46,34 @@ typedef struct ObjPool ObjPool;
  * It set cnt objects of dimension objsize in the arena.
  * Return true if all the arguments are not zero or NULL.
  */
-bool objpool_init(ObjPool *pool, void *arena, size_t cnt, size_t objsize)
-{
-    if (pool == NULL){
-        return false;
-    }
-    if (arena == NULL){
-        return false;
-    }
-    if (cnt == 0){
-        return false;
-    }
-    if (objsize == 0){
-        return false;
-    }
-
-    pool->size = cnt;
-    pool->objsize = objsize;
-    pool->blksize = sizeof(ObjPoolBlock) + objsize;
-    pool->len = 0;
-    pool->head = 0;
-    pool->blocks = (uint8_t*)arena;
+bool objpool_init(ObjPool *pool, void *arena, size_t cnt, size_t objsize);
 
-    /* init free list over all the arena */
-    for (size_t i=0; i < pool->size - 1; i++){
-        ObjPoolBlock *b = (ObjPoolBlock*)&pool->blocks[i * pool->blksize];
-        b->next = i+1;
-    }
+/* Attach the pool to its arena after a restart (e.g. a file mapped at
+ * another address, see persist.h): the pool struct and the arena must be
+ * the ones stored by the previous run, the free list is kept.
+ * Time complexity: O(1)
+ * Return false in case of NULL arguments or invalid pool.
+ */
+bool objpool_attach(ObjPool *pool, void *arena);
 
-    return true;
-}
+/* Clear the arena pointer, valid only in this run, before storing the
+ * pool. The pool can be used again after objpool_attach.
+ */
+void objpool_detach(ObjPool *pool);
 
 /* Get an instance among the available in the pool.
  * Return the pointer to the object.
  * Return NULL if the poll is NULL or no more instances available.
  */
-void * objpool_acquire(ObjPool *pool)
+static inline void * objpool_acquire(ObjPool *pool)
 {
     if (pool == NULL){
         return NULL;
     }
+    DS_HOOK_ENTER("objpool_acquire", pool);
     if (pool->len >= pool->size){ /* defensive */
+        DS_STATS_OP(pool->stats, false);
+        DS_HOOK_EXIT("objpool_acquire", pool, false);
         return NULL;
     }
 
@@ -97,13 +88,16 @@ void * objpool_acquire(ObjPool *pool)
 
     assert(pool->len <= pool->size);
 
+    DS_STATS_OP(pool->stats, true);
+    DS_STATS_LEN(pool->stats, pool->len);
+    DS_HOOK_EXIT("objpool_acquire", pool, true);
     return (void *)o->obj;
 }
 
 /* Release a previously acquired object from the pool.
  * If obj is NULL nothing happen.
  */
-void objpool_release(ObjPool *pool, void *obj)
+static inline void objpool_release(ObjPool *pool, void *obj)
 {
     if (pool == NULL){
         return;
@@ -111,7 +105,10 @@ void objpool_release(ObjPool *pool, void *obj)
     if (obj == NULL){
         return;
     }
+    DS_HOOK_ENTER("objpool_release", pool);
     if (pool->len == 0){
+        DS_STATS_OP(pool->stats, false);
+        DS_HOOK_EXIT("objpool_release", pool, false);
         return;
     }
 
@@ -131,6 +128,265 @@ void objpool_release(ObjPool *pool, void *obj)
     pool->head = blkidx;
 
     pool->len--;
+    DS_STATS_OP(pool->stats, true);
+    DS_HOOK_EXIT("objpool_release", pool, true);
+}
+
+/* Pointer to the object of index i in the arena, acquired or not.
+ * The objects are blksize bytes apart, starting from objpool_at(pool, 0).
+ * Return NULL if the index is out of the pool.
+ */
+static inline void * objpool_at(const ObjPool *pool, size_t i)
+{
+    if (pool == NULL){
+        return NULL;
+    }
+    if (i >= pool->size){
+        return NULL;
+    }
+
+    ObjPoolBlock *b = (ObjPoolBlock*)&pool->blocks[i * pool->blksize];
+    return (void *)b->obj;
+}
+
+/* Index of the object in the pool, the inverse of objpool_at.
+ * Return OBJPOOL_NIL if obj is NULL or not in the pool.
+ */
+static inline size_t objpool_index(const ObjPool *pool, const void *obj)
+{
+    if (pool == NULL || obj == NULL){
+        return OBJPOOL_NIL;
+    }
+
+    const uint8_t *p = (const uint8_t *)obj - sizeof(ObjPoolBlock);
+    if (p < pool->blocks){
+        return OBJPOOL_NIL;
+    }
+
+    size_t offset = (size_t)(p - pool->blocks);
+    if (offset % pool->blksize != 0){
+        return OBJPOOL_NIL;
+    }
+    if (offset / pool->blksize >= pool->size){
+        return OBJPOOL_NIL;
+    }
+
+    return offset / pool->blksize;
+}
+
+/* Snapshot of the statistics (see stats.h), all zero without DS_STATS */
+static inline DSStats objpool_stats(const ObjPool *pool)
+{
+    return DS_STATS_GET(pool);
+}
+
+/* Reset the statistics, the high-water mark restarts from the length */
+static inline void objpool_stats_reset(ObjPool *pool)
+{
+    if (pool == NULL){
+        return;
+    }
+    DS_STATS_RESET(pool->stats, pool->len);
+}
+
+/* Define a typed pool of objects on a caller array of slots, as static
+ * inline procedures. A slot is an object or, while free, the link of the
+ * free list, so it has the size and the alignment of the object (at least
+ * of size_t) and there is no block header.
+ *
+ *  DS_DEFINE_POOL(PointPool, struct Point)
+ *
+ *  PointPoolSlot slots[64];
+ *  PointPool pool;
+ *  PointPool_init(&pool, slots, 64);
+ *  struct Point *p = PointPool_acquire(&pool);
+ *
+ * It generates the union idSlot, the struct id and the procedures
+ * id_init(p, slots, size): O(1), false if slots is NULL or size is 0;
+ * id_len(p), id_isempty(p), id_isfull(p);
+ * id_acquire(p): pointer to a free object, NULL if the pool is exhausted;
+ * id_release(p, obj): obj can be NULL;
+ * id_acquire_n(p, objs, n): acquire up to n objects into objs, return
+ *   how many are acquired;
+ * id_release_n(p, objs, n): release the n objects;
+ * id_put(p, v): acquire an object and copy v in it, return its index or
+ *   OBJPOOL_NIL if the pool is exhausted;
+ * id_at(p, i), id_index(p, obj): as objpool_at and objpool_index.
+ * The array is not owned by the pool. Use it at file scope.
+ */
+#define DS_DEFINE_POOL(id, type) \
+typedef union id##Slot id##Slot; \
+union id##Slot { \
+    type obj;    /* the object, while acquired */ \
+    size_t next; /* index of the next free slot, while released */ \
+}; \
+typedef struct id id; \
+struct id { \
+    id##Slot *slots; /* support array */ \
+    size_t size;     /* capacity */ \
+    size_t len;      /* number of acquired objects */ \
+    size_t head;     /* first released slot */ \
+    size_t used;     /* slots never acquired are in [used, size) */ \
+}; \
+static inline bool id##_init(id *p, id##Slot *slots, size_t size) \
+{ \
+    if (p == NULL || slots == NULL || size == 0 || size == OBJPOOL_NIL){ \
+        return false; \
+    } \
+    p->slots = slots; \
+    p->size = size; \
+    p->len = 0; \
+    p->head = OBJPOOL_NIL; \
+    p->used = 0; \
+    return true; \
+} \
+static inline size_t id##_len(const id *p) \
+{ \
+    return p->len; \
+} \
+static inline bool id##_isempty(const id *p) \
+{ \
+    return p->len == 0; \
+} \
+static inline bool id##_isfull(const id *p) \
+{ \
+    return p->len == p->size; \
+} \
+static inline type * id##_acquire(id *p) \
+{ \
+    size_t i; \
+    if (p->head != OBJPOOL_NIL){ \
+        i = p->head; \
+        p->head = p->slots[i].next; \
+    } else if (p->used < p->size){ \
+        i = p->used++; \
+    } else { \
+        return NULL; \
+    } \
+    p->len++; \
+    return &p->slots[i].obj; \
+} \
+static inline size_t id##_index(const id *p, const type *obj) \
+{ \
+    const id##Slot *s = (const id##Slot *)(const void *)obj; \
+    if (obj == NULL || s < p->slots || s >= p->slots + p->size){ \
+        return OBJPOOL_NIL; \
+    } \
+    return (size_t)(s - p->slots); \
+} \
+static inline type * id##_at(id *p, size_t i) \
+{ \
+    if (i >= p->size){ \
+        return NULL; \
+    } \
+    return &p->slots[i].obj; \
+} \
+static inline void id##_release(id *p, type *obj) \
+{ \
+    if (obj == NULL){ \
+        return; \
+    } \
+    size_t i = id##_index(p, obj); \
+    assert(i != OBJPOOL_NIL); \
+    assert(p->len > 0); \
+    p->slots[i].next = p->head; \
+    p->head = i; \
+    p->len--; \
+} \
+static inline size_t id##_acquire_n(id *p, type **objs, size_t n) \
+{ \
+    size_t k = 0; \
+    for (; k < n && p->head != OBJPOOL_NIL; k++){ \
+        size_t i = p->head; \
+        p->head = p->slots[i].next; \
+        objs[k] = &p->slots[i].obj; \
+    } \
+    /* the never acquired slots are contiguous */ \
+    for (; k < n && p->used < p->size; k++){ \
+        objs[k] = &p->slots[p->used++].obj; \
+    } \
+    p->len += k; \
+    return k; \
+} \
+static inline void id##_release_n(id *p, type **objs, size_t n) \
+{ \
+    for (size_t k=0; k < n; k++){ \
+        id##_release(p, objs[k]); \
+    } \
+} \
+static inline size_t id##_put(id *p, type v) \
+{ \
+    type *obj = id##_acquire(p); \
+    if (obj == NULL){ \
+        return OBJPOOL_NIL; \
+    } \
+    *obj = v; \
+    return id##_index(p, obj); \
 }
 
 #endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_OBJPOOL_IMPL)
+#define _DS_OBJPOOL_IMPL
+
+bool objpool_init(ObjPool *pool, void *arena, size_t cnt, size_t objsize)
+{
+    if (pool == NULL){
+        return false;
+    }
+    if (arena == NULL){
+        return false;
+    }
+    if (cnt == 0){
+        return false;
+    }
+    if (objsize == 0){
+        return false;
+    }
+
+    pool->size = cnt;
+    pool->objsize = objsize;
+    pool->blksize = sizeof(ObjPoolBlock) + objsize;
+    pool->len = 0;
+    pool->head = 0;
+    pool->blocks = (uint8_t*)arena;
+    DS_STATS_RESET(pool->stats, 0);
+
+    /* init free list over all the arena */
+    for (size_t i=0; i < pool->size - 1; i++){
+        ObjPoolBlock *b = (ObjPoolBlock*)&pool->blocks[i * pool->blksize];
+        b->next = i+1;
+    }
+
+    return true;
+}
+
+bool objpool_attach(ObjPool *pool, void *arena)
+{
+    if (pool == NULL || arena == NULL){
+        return false;
+    }
+    if (pool->size == 0 || pool->objsize == 0 || pool->len > pool->size){
+        return false;
+    }
+    if (pool->blksize != sizeof(ObjPoolBlock) + pool->objsize){
+        return false;
+    }
+    /* the head is meaningful only with free blocks */
+    if (pool->len < pool->size && pool->head >= pool->size){
+        return false;
+    }
+
+    pool->blocks = (uint8_t*)arena;
+
+    return true;
+}
+
+void objpool_detach(ObjPool *pool)
+{
+    if (pool != NULL){
+        pool->blocks = NULL;
+    }
+}
+
+#endif /* DS_IMPLEMENTATION */
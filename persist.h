@@ -0,0 +1,341 @@
+#ifndef _DS_PERSIST_H
+#define _DS_PERSIST_H
+
+/* Persistent arenas on memory mapped files
+ * Namespace: persist
+ *
+ * A file holds a versioned header and an arena of fixed size, mapped
+ * shared: the structures built in the arena survive the process and a
+ * restart attaches to them in O(1) instead of building them again.
+ * The index based structures are almost position independent:
+ * - QueueIndex and StackIndex (and the Queue/Stack data) are stored as is;
+ * - SList and ObjPool keep pointers valid only in one run, re-derived by
+ *   slist_attach, slist_attach_shared and objpool_attach (the ObjPool
+ *   struct must be stored in the arena too);
+ * - the values of the lists are user pointers: they must be valid in the
+ *   new run, persist_rebase moves the ones pointing into the arena.
+ * Allocating the same sequence with arena.h gives the same offsets at
+ * every run, since the arena has always the same alignment (64 bytes past
+ * the start of the mapping).
+ *
+ *  Persist p;
+ *  int rc = persist_open(&p, "list.db", SLIST_SIZEOF(n), KIND_LIST);
+ *  SList *list = NULL;
+ *  if (rc == PERSIST_CREATED){
+ *      list = slist_init(p.arena, n);
+ *  } else if (rc == PERSIST_ATTACHED){
+ *      list = slist_attach(p.arena);
+ *  }
+ *  ...
+ *  persist_checkpoint(&p);
+ *  ...
+ *  persist_close(&p);
+ *
+ * persist_checkpoint stores the checksum of the arena and writes the whole
+ * mapping to the file (msync), then it writes the header marked clean: a
+ * crash in the middle leaves the header dirty. The header is marked dirty
+ * again after the checkpoint, so a
+ * file left by a crash is accepted only if the arena is still equal to the
+ * last checkpoint (the checksum is verified, O(size)); persist_close does a
+ * last checkpoint and leaves the file clean, opened again in O(1).
+ * The writes after the last checkpoint are not atomic: a crash in the
+ * middle of them makes the file rejected.
+ *
+ * Linux (POSIX) only. Include it before any system header (it selects mmap
+ * and ftruncate).
+ */
+
+#if !defined(_DEFAULT_SOURCE) && !defined(_GNU_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* "DSPS" */
+#define PERSIST_MAGIC UINT32_C(0x53505344)
+#define PERSIST_VERSION 1
+/* bytes of the header, the arena starts after them */
+#define PERSIST_HEADER 64
+/* bytes of the file for an arena of size bytes */
+#define PERSIST_SIZEOF(size) ( PERSIST_HEADER + (size_t)(size) )
+
+/* results of persist_open */
+#define PERSIST_CREATED 0  /* new file, the arena is zero filled */
+#define PERSIST_ATTACHED 1 /* existing file, the arena is the stored one */
+
+/* states of the header */
+#define PERSIST_CLEAN 0
+#define PERSIST_DIRTY 1
+
+typedef struct PersistHeader PersistHeader;
+typedef struct Persist Persist;
+
+/* the header is stored in the file, with the native byte order */
+struct PersistHeader {
+    uint32_t magic;    /* PERSIST_MAGIC */
+    uint32_t version;  /* PERSIST_VERSION */
+    uint32_t kind;     /* tag of the content, chosen by the user */
+    uint32_t state;    /* PERSIST_CLEAN or PERSIST_DIRTY */
+    uint64_t size;     /* bytes of the arena */
+    uint64_t base;     /* address of the arena at the last checkpoint */
+    uint64_t checksum; /* of the arena at the last checkpoint */
+    uint64_t epoch;    /* number of checkpoints */
+};
+
+struct Persist {
+    int fd;                /* the file, -1 if closed */
+    PersistHeader *header; /* start of the mapping */
+    void *arena;           /* the arena after the header */
+    size_t size;           /* bytes of the arena */
+    uintptr_t prev;        /* address of the arena in the previous run */
+};
+
+/* Checksum of size bytes (64 bits, not cryptographic).
+ * Time complexity: O(size)
+ */
+uint64_t persist_checksum(const void *mem, size_t size);
+
+/* Open (or create) the file at path with an arena of size bytes tagged with
+ * kind.
+ * An existing file must have the same version, kind and size, and it is
+ * verified if not closed cleanly.
+ * Return PERSIST_CREATED or PERSIST_ATTACHED, -1 in case of errors (the
+ * existing file is not changed).
+ */
+int persist_open(Persist *p, const char *path, size_t size, uint32_t kind);
+
+/* Store the checksum of the arena and write the mapping to the file.
+ * Time complexity: O(size)
+ * Return false in case of errors.
+ */
+bool persist_checkpoint(Persist *p);
+
+/* Verify the arena with the checksum of the last checkpoint.
+ * Time complexity: O(size)
+ */
+bool persist_verify(const Persist *p);
+
+/* Checkpoint and close the file, leaving it clean.
+ * Return false if the checkpoint failed (the file is closed anyway).
+ */
+bool persist_close(Persist *p);
+
+/* Move a pointer stored in the previous run into the arena of this run.
+ * The pointers outside the previous arena are returned unchanged.
+ */
+static inline void * persist_rebase(const Persist *p, void *ptr)
+{
+    uintptr_t u = (uintptr_t)ptr;
+    if (p == NULL || u < p->prev || u - p->prev >= p->size){
+        return ptr;
+    }
+    return &((uint8_t*)p->arena)[u - p->prev];
+}
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_PERSIST_IMPL)
+#define _DS_PERSIST_IMPL
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Internal use.
+ * The header must fit in PERSIST_HEADER bytes.
+ */
+typedef char _persist_header_fits[
+    (sizeof(PersistHeader) <= PERSIST_HEADER)?1:-1];
+
+uint64_t persist_checksum(const void *mem, size_t size)
+{
+    const uint8_t *b = (const uint8_t*)mem;
+    uint64_t h = UINT64_C(0xCBF29CE484222325) ^ (uint64_t)size;
+    size_t i = 0;
+
+    /* 8 bytes per step, multiply and rotate */
+    for (; i + 8 <= size; i += 8){
+        uint64_t w;
+        memcpy(&w, &b[i], sizeof(w));
+        h = (h ^ w) * UINT64_C(0x100000001B3);
+        h = (h << 29) | (h >> 35);
+    }
+    for (; i < size; i++){
+        h = (h ^ b[i]) * UINT64_C(0x100000001B3);
+    }
+
+    /* final mix */
+    h ^= h >> 33;
+    h *= UINT64_C(0xFF51AFD7ED558CCD);
+    h ^= h >> 33;
+    return h;
+}
+
+bool persist_verify(const Persist *p)
+{
+    if (p == NULL || p->header == NULL){
+        return false;
+    }
+    return persist_checksum(p->arena, p->size) == p->header->checksum;
+}
+
+/* Internal use.
+ * Check the header of an existing file.
+ */
+static bool _persist_valid(const Persist *p, uint32_t kind)
+{
+    const PersistHeader *h = p->header;
+
+    if (h->magic != PERSIST_MAGIC || h->version != PERSIST_VERSION){
+        return false;
+    }
+    if (h->kind != kind || h->size != p->size){
+        return false;
+    }
+    if (h->state == PERSIST_CLEAN){
+        return true;
+    }
+    /* not closed: valid only if unchanged since the last checkpoint */
+    return h->state == PERSIST_DIRTY && persist_verify(p);
+}
+
+/* Internal use.
+ * Mark the file dirty before any change of the arena, on the disk too:
+ * a crash would leave the arena written only in part.
+ */
+static bool _persist_dirty(Persist *p)
+{
+    p->header->state = PERSIST_DIRTY;
+    return msync(p->header, PERSIST_HEADER, MS_SYNC) == 0;
+}
+
+int persist_open(Persist *p, const char *path, size_t size, uint32_t kind)
+{
+    if (p == NULL || path == NULL || size == 0 ||
+        size > SIZE_MAX - PERSIST_HEADER){
+        return -1;
+    }
+    p->fd = -1;
+    p->header = NULL;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0){
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+        close(fd);
+        return -1;
+    }
+
+    /* an empty file is new */
+    bool created = (st.st_size == 0);
+    size_t len = PERSIST_SIZEOF(size);
+    if (created){
+        if (ftruncate(fd, (off_t)len) != 0){
+            close(fd);
+            return -1;
+        }
+    } else if ((uint64_t)st.st_size != (uint64_t)len){
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED){
+        close(fd);
+        return -1;
+    }
+
+    p->fd = fd;
+    p->header = (PersistHeader*)map;
+    p->arena = &((uint8_t*)map)[PERSIST_HEADER];
+    p->size = size;
+
+    PersistHeader *h = p->header;
+    if (created){
+        h->magic = PERSIST_MAGIC;
+        h->version = PERSIST_VERSION;
+        h->kind = kind;
+        h->size = size;
+        h->base = (uint64_t)(uintptr_t)p->arena;
+        h->checksum = persist_checksum(p->arena, size);
+        h->epoch = 0;
+    } else if (!_persist_valid(p, kind)){
+        munmap(map, len);
+        close(fd);
+        p->fd = -1;
+        p->header = NULL;
+        return -1;
+    }
+
+    p->prev = (uintptr_t)h->base;
+    /* clean again only at the close */
+    if (!_persist_dirty(p)){
+        munmap(map, len);
+        close(fd);
+        p->fd = -1;
+        p->header = NULL;
+        return -1;
+    }
+
+    return created?PERSIST_CREATED:PERSIST_ATTACHED;
+}
+
+/* Internal use.
+ * Store the checksum and write the mapping, then the header in the state.
+ * msync does not order the pages: the header changes its state only after
+ * the arena is on the disk, otherwise a crash could leave a clean header
+ * over an arena written in part.
+ */
+static bool _persist_sync(Persist *p, uint32_t state)
+{
+    PersistHeader *h = p->header;
+
+    /* still dirty: accepted after a crash only if the arena verifies */
+    h->base = (uint64_t)(uintptr_t)p->arena;
+    h->checksum = persist_checksum(p->arena, p->size);
+    h->epoch++;
+    if (msync(h, PERSIST_SIZEOF(p->size), MS_SYNC) != 0){
+        return false;
+    }
+
+    h->state = state;
+    return msync(h, PERSIST_HEADER, MS_SYNC) == 0;
+}
+
+bool persist_checkpoint(Persist *p)
+{
+    if (p == NULL || p->header == NULL){
+        return false;
+    }
+
+    bool ok = _persist_sync(p, PERSIST_CLEAN);
+    /* the arena can change after the checkpoint */
+    ok = _persist_dirty(p) && ok;
+
+    return ok;
+}
+
+bool persist_close(Persist *p)
+{
+    if (p == NULL || p->header == NULL){
+        return false;
+    }
+
+    bool ok = _persist_sync(p, PERSIST_CLEAN);
+    munmap(p->header, PERSIST_SIZEOF(p->size));
+    close(p->fd);
+    p->fd = -1;
+    p->header = NULL;
+    p->arena = NULL;
+
+    return ok;
+}
+
+#endif /* DS_IMPLEMENTATION */
@@ -11,16 +11,19 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
+#include "stats.h"
 
 struct QueueIndex {
     size_t size; /* capacity */
     size_t head; /* start of the data */
     size_t len;  /* how many data */
+    DS_STATS_MEMBER /* see stats.h */
 };
 
 typedef struct QueueIndex QueueIndex;
 
-int queue_init(QueueIndex *q, const size_t size)
+static inline int queue_init(QueueIndex *q, const size_t size)
 {
     if (q == NULL){
         return -1;
@@ -28,11 +31,12 @@ int queue_init(QueueIndex *q, const size_t size)
     q->size = size;
     q->head = 0;
     q->len = 0;
+    DS_STATS_RESET(q->stats, 0);
 
     return 0;
 }
 
-bool queue_isempty(const QueueIndex *q)
+static inline bool queue_isempty(const QueueIndex *q)
 {
     if (q == NULL){
         return false;
@@ -40,7 +44,7 @@ bool queue_isempty(const QueueIndex *q)
     return q->len == 0;
 }
 
-bool queue_isfull(const QueueIndex *q)
+static inline bool queue_isfull(const QueueIndex *q)
 {
     if (q == NULL){
         return false;
@@ -48,7 +52,7 @@ bool queue_isfull(const QueueIndex *q)
     return q->len == q->size;
 }
 
-size_t queue_length(const QueueIndex *q)
+static inline size_t queue_length(const QueueIndex *q)
 {
     if (q == NULL){
         return false;
@@ -56,7 +60,7 @@ size_t queue_length(const QueueIndex *q)
     return q->len;
 }
 
-size_t queue_size(const QueueIndex *q)
+static inline size_t queue_size(const QueueIndex *q)
 {
     if (q == NULL){
         return false;
@@ -67,38 +71,180 @@ size_t queue_size(const QueueIndex *q)
 /* return the index for setting the value in the support array.
  * -1 in case of overflow
  */
-long queue_enqueue(QueueIndex *q)
+static inline long queue_enqueue(QueueIndex *q)
 {
     if (q == NULL){
         return -1;
     }
 
+    DS_HOOK_ENTER("queue_enqueue", q);
     if (queue_isfull(q)){
+        DS_STATS_OP(q->stats, false);
+        DS_HOOK_EXIT("queue_enqueue", q, false);
         return -1;
     }
 
     /* circular */
     long i = (long)((q->head + q->len) % q->size);
     q->len++;
+    DS_STATS_OP(q->stats, true);
+    DS_STATS_LEN(q->stats, q->len);
+    DS_HOOK_EXIT("queue_enqueue", q, true);
     return i;
 }
 
 /* return the index for getting the value in the support array.
  * -1 in case of underflow
  */
-long queue_dequeue(QueueIndex *q)
+static inline long queue_dequeue(QueueIndex *q)
 {
     if (q == NULL){
         return -1;
     }
 
+    DS_HOOK_ENTER("queue_dequeue", q);
     if (queue_isempty(q)){
+        DS_STATS_OP(q->stats, false);
+        DS_HOOK_EXIT("queue_dequeue", q, false);
         return -1;
     }
 
     long i = (long)q->head;
     q->head = (q->head + 1) % q->size;
     q->len--;
+    DS_STATS_OP(q->stats, true);
+    DS_HOOK_EXIT("queue_dequeue", q, true);
     return i;
 }
+
+/* Snapshot of the statistics (see stats.h), all zero without DS_STATS */
+static inline DSStats queue_stats(const QueueIndex *q)
+{
+    return DS_STATS_GET(q);
+}
+
+/* Reset the statistics, the high-water mark restarts from the length */
+static inline void queue_stats_reset(QueueIndex *q)
+{
+    if (q == NULL){
+        return;
+    }
+    DS_STATS_RESET(q->stats, q->len);
+}
+
+/* Define a typed circular queue of values on a caller array, as static
+ * inline procedures without the index casts and the modulo of QueueIndex:
+ *
+ *  DS_DEFINE_QUEUE(IntQueue, int)
+ *
+ *  int buf[64];
+ *  IntQueue q;
+ *  IntQueue_init(&q, buf, 64);
+ *  IntQueue_push(&q, 42);
+ *
+ * It generates the struct id and the procedures
+ * id_init(q, data, size): false if data is NULL or size is 0;
+ * id_len(q), id_isempty(q), id_isfull(q);
+ * id_push(q, v): enqueue, false if full;
+ * id_pop(q, &v): dequeue, false if empty, v untouched;
+ * id_front(q): pointer to the next value to dequeue, NULL if empty;
+ * id_push_n(q, src, n): copy the values as n push, return how many fit;
+ * id_pop_n(q, dst, n): copy in dst the min(n, len) values as n pop,
+ *   return how many are removed.
+ * The batch procedures copy at most two contiguous blocks.
+ * The array is not owned by the queue. Use it at file scope.
+ */
+#define DS_DEFINE_QUEUE(id, type) \
+typedef struct id id; \
+struct id { \
+    type *data;  /* support array */ \
+    size_t size; /* capacity */ \
+    size_t head; /* start of the data */ \
+    size_t len;  /* how many data */ \
+}; \
+static inline bool id##_init(id *q, type *data, size_t size) \
+{ \
+    if (q == NULL || data == NULL || size == 0){ \
+        return false; \
+    } \
+    q->data = data; \
+    q->size = size; \
+    q->head = 0; \
+    q->len = 0; \
+    return true; \
+} \
+static inline size_t id##_len(const id *q) \
+{ \
+    return q->len; \
+} \
+static inline bool id##_isempty(const id *q) \
+{ \
+    return q->len == 0; \
+} \
+static inline bool id##_isfull(const id *q) \
+{ \
+    return q->len == q->size; \
+} \
+static inline bool id##_push(id *q, type v) \
+{ \
+    if (q->len == q->size){ \
+        return false; \
+    } \
+    size_t i = q->head + q->len; \
+    i = (i >= q->size)?i - q->size:i; \
+    q->data[i] = v; \
+    q->len++; \
+    return true; \
+} \
+static inline bool id##_pop(id *q, type *v) \
+{ \
+    if (q->len == 0){ \
+        return false; \
+    } \
+    *v = q->data[q->head]; \
+    q->head = (q->head + 1 == q->size)?0:q->head + 1; \
+    q->len--; \
+    return true; \
+} \
+static inline type * id##_front(id *q) \
+{ \
+    if (q->len == 0){ \
+        return NULL; \
+    } \
+    return &q->data[q->head]; \
+} \
+static inline size_t id##_push_n(id *q, const type *src, size_t n) \
+{ \
+    size_t room = q->size - q->len; \
+    n = (n < room)?n:room; \
+    size_t tail = q->head + q->len; \
+    tail = (tail >= q->size)?tail - q->size:tail; \
+    size_t first = q->size - tail; \
+    first = (n < first)?n:first; \
+    if (first > 0){ \
+        memcpy(&q->data[tail], src, first * sizeof(type)); \
+    } \
+    if (n > first){ \
+        memcpy(q->data, &src[first], (n - first) * sizeof(type)); \
+    } \
+    q->len += n; \
+    return n; \
+} \
+static inline size_t id##_pop_n(id *q, type *dst, size_t n) \
+{ \
+    n = (n < q->len)?n:q->len; \
+    size_t first = q->size - q->head; \
+    first = (n < first)?n:first; \
+    if (first > 0){ \
+        memcpy(dst, &q->data[q->head], first * sizeof(type)); \
+    } \
+    if (n > first){ \
+        memcpy(&dst[first], q->data, (n - first) * sizeof(type)); \
+    } \
+    q->head += n; \
+    q->head = (q->head >= q->size)?q->head - q->size:q->head; \
+    q->len -= n; \
+    return n; \
+}
+
 #endif
@@ -16,6 +16,18 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include "stats.h"
+
+/* SSE2 path of the bulk procedures, for 32 bits RangeType and 64 bits size_t.
+ * The scalar loops are written to be vectorized as well (e.g. -O3).
+ */
+#if defined(__SSE2__) && (INT_MAX == 0x7fffffff) && (SIZE_MAX == UINT64_MAX)
+#define RANGE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 #define RANGE_SIZE(start, end) ((size_t)((end) - (start) + 1))
 
@@ -30,8 +42,26 @@ struct Range {
     RangeType end;
     RangeCallback clbk;
     const char *name;
+#ifdef DS_STATS
+    DSStats *stats; /* counters owned by the user, can be NULL (stats.h) */
+#endif
 };
 
+/* Internal use.
+ * Count n conversions, bad out of range and c callback invocations.
+ */
+#ifdef DS_STATS
+#define _RANGE_STATS(r, n, bad, c) \
+    do { \
+        if ((r).stats != NULL){ \
+            DS_STATS_OPS(*(r).stats, (n), (bad)); \
+            (r).stats->clbks += (c); \
+        } \
+    } while (0)
+#else
+#define _RANGE_STATS(r, n, bad, c) ((void)0)
+#endif
+
 /* Create the range from start to end (both included).
  * It stores a callback pointer that will be called in case of index out of
  * bound in the auxiliary methods.
@@ -42,7 +72,7 @@ struct Range {
  * start, end: can be negative
  * clbk: the callback function. It can be NULL.
  */
-Range range_init(const char *name, RangeType start, RangeType end, RangeCallback clbk)
+static inline Range range_init(const char *name, RangeType start, RangeType end, RangeCallback clbk)
 {
     Range r = {.start = start, .end = end, .clbk = clbk, .name = name};
 
@@ -54,35 +84,250 @@ Range range_init(const char *name, RangeType start, RangeType end, RangeCallback
 }
 
 /* Check if the range index is in the boundaries after a change (i++) */
-bool range_in(Range r, RangeType i)
+static inline bool range_in(Range r, RangeType i)
 {
     return (r.start <= i) && (i <= r.end);
 }
 
 /* Convert the range index i into the canonical index zero based */
-size_t range_at(Range r, RangeType i)
+static inline size_t range_at(Range r, RangeType i)
 {
-    if (r.clbk != NULL && !range_in(r, i)){
+    DS_HOOK_ENTER("range_at", &r);
+    bool in = range_in(r, i);
+    _RANGE_STATS(r, 1, !in, !in && r.clbk != NULL);
+    if (r.clbk != NULL && !in){
         i = r.clbk(r, i);
     }
+    DS_HOOK_EXIT("range_at", &r, in);
     return i - r.start;
 }
 
 /* Convert the canonical index i into the range index */
-RangeType range_of(Range r, size_t i)
+static inline RangeType range_of(Range r, size_t i)
 {
+    DS_HOOK_ENTER("range_of", &r);
     RangeType j = r.start + i;
-    if (r.clbk != NULL && !range_in(r, j)){
+    bool in = range_in(r, j);
+    _RANGE_STATS(r, 1, !in, !in && r.clbk != NULL);
+    if (r.clbk != NULL && !in){
         j = r.clbk(r, j);
     }
+    DS_HOOK_EXIT("range_of", &r, in);
     return j;
 }
 
 /* Number of element in the range (or in the array indexed by the range) */
-size_t range_size(Range r)
+static inline size_t range_size(Range r)
 {
     return RANGE_SIZE(r.start, r.end);
 }
 
+/* Count the operations of the range in stats (see stats.h), NULL to stop.
+ * Without DS_STATS it does nothing.
+ */
+static inline void range_set_stats(Range *r, DSStats *stats)
+{
+#ifdef DS_STATS
+    r->stats = stats;
+#else
+    (void)r;
+    (void)stats;
+#endif
+}
+
+/* Snapshot of the statistics, all zero without DS_STATS or counters */
+static inline DSStats range_stats(Range r)
+{
+#ifdef DS_STATS
+    return ds_stats_copy(r.stats);
+#else
+    (void)r;
+    return ds_stats_copy(NULL);
+#endif
+}
+
+/* Convert n range indexes into canonical indexes zero based,
+ * as out[k] = range_at(r, in[k]) for every k.
+ * The callback is called only for the indexes out of range, after a first
+ * branch free pass written to be vectorized by the compiler.
+ * in and out must not overlap.
+ * Return the number of indexes out of range.
+ */
+size_t range_at_n(Range r, const RangeType *restrict in, size_t *restrict out,
+                  size_t n);
+
+/* Check n range indexes, as range_in(r, in[k]) for every k.
+ * If mask is not NULL, mask[k] is set to 1 if in[k] is out of range and
+ * to 0 otherwise. The callback is not called.
+ * in and mask must not overlap.
+ * Return the number of indexes out of range.
+ */
+size_t range_in_n(Range r, const RangeType *restrict in, uint8_t *restrict mask,
+                  size_t n);
+
+/* Define a range with constant bounds, as static inline procedures with
+ * the bounds and the callback folded in the code:
+ *
+ *  RANGE_DEFINE(Degrees, -90, 90, NULL)
+ *
+ *  int std[RANGE_SIZE(-90, 90)];
+ *  std[Degrees_at(-90)] = 0; // first element
+ *
+ * It generates id_range() (the equivalent Range), id_in(i),
+ * id_at(i), id_of(i) and id_size(), with the same semantics of the
+ * range_* procedures, callback included (clbk can be NULL).
+ * The compiler can remove the checks when it can prove the index is in the
+ * range, or move them out of the loops.
+ * Use it at file scope.
+ */
+#define RANGE_DEFINE(id, start_, end_, clbk_) \
+static inline Range id##_range(void) \
+{ \
+    Range r = {.start = (start_), .end = (end_), .clbk = (clbk_), \
+               .name = #id}; \
+    return r; \
+} \
+static inline bool id##_in(RangeType i) \
+{ \
+    return ((start_) <= i) && (i <= (end_)); \
+} \
+static inline size_t id##_at(RangeType i) \
+{ \
+    RangeCallback clbk = (clbk_); \
+    if (clbk != NULL && !id##_in(i)){ \
+        i = clbk(id##_range(), i); \
+    } \
+    return i - (start_); \
+} \
+static inline RangeType id##_of(size_t i) \
+{ \
+    RangeCallback clbk = (clbk_); \
+    RangeType j = (start_) + i; \
+    if (clbk != NULL && !id##_in(j)){ \
+        j = clbk(id##_range(), j); \
+    } \
+    return j; \
+} \
+static inline size_t id##_size(void) \
+{ \
+    return RANGE_SIZE((start_), (end_)); \
+}
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_RANGE_IMPL)
+#define _DS_RANGE_IMPL
+
+size_t range_at_n(Range r, const RangeType *restrict in, size_t *restrict out,
+                  size_t n)
+{
+    const RangeType start = r.start;
+    /* i in [start, end] <=> (unsigned)(i - start) <= (unsigned)(end - start) */
+    const unsigned width = (unsigned)r.end - (unsigned)r.start;
+    size_t bad = 0;
+    size_t k = 0;
+
+    DS_HOOK_ENTER("range_at_n", &r);
+
+#ifdef RANGE_SSE2
+    /* unsigned compare as signed one, flipping the sign bits */
+    const __m128i vstart = _mm_set1_epi32(start);
+    const __m128i vsign = _mm_set1_epi32(INT_MIN);
+    const __m128i vwidth = _mm_set1_epi32((int)(width ^ 0x80000000u));
+
+    for (; k + 4 <= n; k += 4){
+        __m128i v = _mm_loadu_si128((const __m128i *)&in[k]);
+        __m128i off = _mm_sub_epi32(v, vstart);
+        __m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(off, vsign), vwidth);
+        /* sign extension to size_t */
+        __m128i ext = _mm_srai_epi32(off, 31);
+        _mm_storeu_si128((__m128i *)&out[k], _mm_unpacklo_epi32(off, ext));
+        _mm_storeu_si128((__m128i *)&out[k + 2], _mm_unpackhi_epi32(off, ext));
+        int m = _mm_movemask_ps(_mm_castsi128_ps(gt));
+        bad += (size_t)((m & 1) + ((m >> 1) & 1) + ((m >> 2) & 1) + ((m >> 3) & 1));
+    }
+#endif
+
+    for (; k < n; k++){
+        unsigned off = (unsigned)in[k] - (unsigned)start;
+        out[k] = (size_t)(in[k] - start);
+        bad += (off > width);
+    }
+
+    _RANGE_STATS(r, n, bad, (r.clbk != NULL)?bad:0);
+
+    if (bad > 0 && r.clbk != NULL){
+        for (k=0; k < n; k++){
+            if (!range_in(r, in[k])){
+                out[k] = r.clbk(r, in[k]) - start;
+            }
+        }
+    }
+
+    DS_HOOK_EXIT("range_at_n", &r, bad == 0);
+    return bad;
+}
+
+size_t range_in_n(Range r, const RangeType *restrict in, uint8_t *restrict mask,
+                  size_t n)
+{
+    const unsigned start = (unsigned)r.start;
+    const unsigned width = (unsigned)r.end - (unsigned)r.start;
+    size_t bad = 0;
+    size_t k = 0;
+
+    DS_HOOK_ENTER("range_in_n", &r);
+
+#ifdef RANGE_SSE2
+    const __m128i vstart = _mm_set1_epi32(r.start);
+    const __m128i vsign = _mm_set1_epi32(INT_MIN);
+    const __m128i vwidth = _mm_set1_epi32((int)(width ^ 0x80000000u));
+    const __m128i vone = _mm_set1_epi8(1);
+    /* lanes counters, flushed before they can overflow */
+    __m128i vbad = _mm_setzero_si128();
+    size_t lanes = 0;
+
+    for (; k + 4 <= n; k += 4){
+        __m128i v = _mm_loadu_si128((const __m128i *)&in[k]);
+        __m128i off = _mm_sub_epi32(v, vstart);
+        __m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(off, vsign), vwidth);
+        vbad = _mm_sub_epi32(vbad, gt);
+
+        if (mask != NULL){
+            __m128i b = _mm_packs_epi16(_mm_packs_epi32(gt, gt), gt);
+            int32_t m = _mm_cvtsi128_si32(_mm_and_si128(b, vone));
+            memcpy(&mask[k], &m, 4);
+        }
 
+        if (++lanes == INT32_MAX){
+            int32_t c[4];
+            _mm_storeu_si128((__m128i *)c, vbad);
+            bad += (size_t)c[0] + (size_t)c[1] + (size_t)c[2] + (size_t)c[3];
+            vbad = _mm_setzero_si128();
+            lanes = 0;
+        }
+    }
+
+    int32_t c[4];
+    _mm_storeu_si128((__m128i *)c, vbad);
+    bad += (size_t)c[0] + (size_t)c[1] + (size_t)c[2] + (size_t)c[3];
 #endif
+
+    if (mask == NULL){
+        for (; k < n; k++){
+            bad += (((unsigned)in[k] - start) > width);
+        }
+    } else {
+        for (; k < n; k++){
+            uint8_t v = (((unsigned)in[k] - start) > width);
+            mask[k] = v;
+            bad += v;
+        }
+    }
+
+    _RANGE_STATS(r, n, bad, 0);
+    DS_HOOK_EXIT("range_in_n", &r, bad == 0);
+    return bad;
+}
+
+#endif /* DS_IMPLEMENTATION */
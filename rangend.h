@@ -0,0 +1,252 @@
+#ifndef _DS_RANGEND_H
+#define _DS_RANGEND_H
+
+/* N-dimensional Range Data Structure (for array indexing)
+ * Namespace: rangend
+ *
+ * Grid of up to RANGEND_MAXDIM axes, every axis is a Range with its own
+ * start, end and callback. The grid converts the coordinates into the
+ * offset of the cell in the support array, according to a layout:
+ *
+ * - RANGEND_ROWMAJOR: as C arrays, the last axis is contiguous;
+ * - RANGEND_TILED: square tiles of side 'tile' (power of 2) stored
+ *   contiguously, the tiles and the cells in a tile are row-major;
+ * - RANGEND_MORTON: Z-order, the bits of the coordinates are interleaved.
+ *
+ * The tiled and Morton layouts keep the neighbours on every axis close in
+ * memory (stencils, neighborhood scans), but they pad the axes: the support
+ * array must have rangend_size() cells.
+ *
+ *  Range axes[2] = {
+ *      range_init("Lat", -90, 90, clbk),
+ *      range_init("Lon", -180, 180, clbk)
+ *  };
+ *  RangeND g;
+ *  rangend_init(&g, 2, axes, RANGEND_MORTON, 0);
+ *  float *temp = calloc(rangend_size(&g), sizeof(float));
+ *  temp[rangend_at2(&g, -45, 120)] = 1.0;
+ */
+
+#include "range.h"
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define RANGEND_MAXDIM 4
+
+typedef struct RangeND RangeND;
+
+typedef enum {
+    RANGEND_ROWMAJOR,
+    RANGEND_TILED,
+    RANGEND_MORTON
+} RangeNDLayout;
+
+struct RangeND {
+    size_t ndim;                 /* number of axes */
+    RangeNDLayout layout;
+    Range axis[RANGEND_MAXDIM];  /* index range of every axis */
+    size_t dims[RANGEND_MAXDIM]; /* padded extent of every axis */
+    size_t shift;                /* log2 of the tile (block) side */
+    size_t size;                 /* cells of the support array */
+};
+
+/* Initialize the grid with ndim axes.
+ * tile is the tile side for RANGEND_TILED (power of 2, 0 for the default
+ * 8), ignored by the other layouts.
+ * The axes are copied, their callbacks are called for the coordinates out
+ * of range as in range_at.
+ * Return false if the arguments are not valid.
+ */
+bool rangend_init(RangeND *g, size_t ndim, const Range *axes,
+                  RangeNDLayout layout, size_t tile);
+
+/* Number of cells of the support array, padding included */
+static inline size_t rangend_size(const RangeND *g)
+{
+    return g->size;
+}
+
+/* Internal use.
+ * Spread the bits of x, leaving ndim - 1 zero bits between them.
+ */
+static inline size_t _rangend_spread(size_t x, size_t ndim)
+{
+    uint64_t v = x;
+
+    switch (ndim){
+    case 1:
+        return x;
+    case 2:
+        v &= 0xFFFFFFFFULL;
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+        v = (v | (v << 8))  & 0x00FF00FF00FF00FFULL;
+        v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+        v = (v | (v << 2))  & 0x3333333333333333ULL;
+        v = (v | (v << 1))  & 0x5555555555555555ULL;
+        return (size_t)v;
+    case 3:
+        v &= 0x1FFFFFULL;
+        v = (v | (v << 32)) & 0x001F00000000FFFFULL;
+        v = (v | (v << 16)) & 0x001F0000FF0000FFULL;
+        v = (v | (v << 8))  & 0x100F00F00F00F00FULL;
+        v = (v | (v << 4))  & 0x10C30C30C30C30C3ULL;
+        v = (v | (v << 2))  & 0x1249249249249249ULL;
+        return (size_t)v;
+    default:
+        break;
+    }
+
+    size_t r = 0;
+    for (size_t b=0; x != 0; b++, x >>= 1){
+        r |= (x & 1) << (b * ndim);
+    }
+    return r;
+}
+
+/* Convert the ndim coordinates (range indexes) into the offset of the cell
+ * in the support array, according to the layout.
+ * Every coordinate is checked by its axis with range_at.
+ */
+static inline size_t rangend_at(const RangeND *g, const RangeType *idx)
+{
+    size_t c[RANGEND_MAXDIM];
+    for (size_t a=0; a < g->ndim; a++){
+        c[a] = range_at(g->axis[a], idx[a]);
+    }
+
+    size_t off = 0;
+
+    switch (g->layout){
+    case RANGEND_ROWMAJOR:
+        for (size_t a=0; a < g->ndim; a++){
+            off = off * g->dims[a] + c[a];
+        }
+        break;
+    case RANGEND_TILED: {
+        const size_t mask = ((size_t)1 << g->shift) - 1;
+        size_t inner = 0;
+        for (size_t a=0; a < g->ndim; a++){
+            off = off * (g->dims[a] >> g->shift) + (c[a] >> g->shift);
+            inner = (inner << g->shift) | (c[a] & mask);
+        }
+        off = (off << (g->shift * g->ndim)) | inner;
+        break;
+    }
+    case RANGEND_MORTON: {
+        const size_t mask = ((size_t)1 << g->shift) - 1;
+        size_t inner = 0;
+        for (size_t a=0; a < g->ndim; a++){
+            off = off * (g->dims[a] >> g->shift) + (c[a] >> g->shift);
+            /* the first axis gets the most significant bit of the groups */
+            inner |= _rangend_spread(c[a] & mask, g->ndim) << (g->ndim - 1 - a);
+        }
+        off = (off << (g->shift * g->ndim)) | inner;
+        break;
+    }
+    }
+
+    assert(off < g->size);
+    return off;
+}
+
+/* rangend_at for 2 dimensions grids */
+static inline size_t rangend_at2(const RangeND *g, RangeType i, RangeType j)
+{
+    assert(g->ndim == 2);
+    RangeType idx[2] = {i, j};
+    return rangend_at(g, idx);
+}
+
+/* rangend_at for 3 dimensions grids */
+static inline size_t rangend_at3(const RangeND *g, RangeType i, RangeType j, RangeType k)
+{
+    assert(g->ndim == 3);
+    RangeType idx[3] = {i, j, k};
+    return rangend_at(g, idx);
+}
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_RANGEND_IMPL)
+#define _DS_RANGEND_IMPL
+
+/* Internal use.
+ * Smallest power of 2 not less than x, as exponent.
+ */
+static size_t _rangend_log2ceil(size_t x)
+{
+    size_t b = 0;
+    while (((size_t)1 << b) < x){
+        b++;
+    }
+    return b;
+}
+
+bool rangend_init(RangeND *g, size_t ndim, const Range *axes,
+                  RangeNDLayout layout, size_t tile)
+{
+    if (g == NULL || axes == NULL){
+        return false;
+    }
+    if (ndim == 0 || ndim > RANGEND_MAXDIM){
+        return false;
+    }
+
+    g->ndim = ndim;
+    g->layout = layout;
+    g->shift = 0;
+
+    size_t minbits = SIZE_MAX;
+    for (size_t a=0; a < ndim; a++){
+        if (axes[a].end < axes[a].start){
+            return false;
+        }
+        g->axis[a] = axes[a];
+        g->dims[a] = range_size(axes[a]);
+        size_t b = _rangend_log2ceil(g->dims[a]);
+        minbits = (b < minbits)?b:minbits;
+    }
+
+    switch (layout){
+    case RANGEND_ROWMAJOR:
+        break;
+    case RANGEND_TILED:
+        if (tile == 0){
+            tile = 8;
+        }
+        if ((tile & (tile - 1)) != 0){
+            return false;
+        }
+        g->shift = _rangend_log2ceil(tile);
+        /* pad to a multiple of the tile side */
+        for (size_t a=0; a < ndim; a++){
+            g->dims[a] = ((g->dims[a] + tile - 1) >> g->shift) << g->shift;
+        }
+        break;
+    case RANGEND_MORTON:
+        /* Z-order inside cubic blocks as big as the shortest axis, the
+         * blocks are row-major. The axes are padded to a power of 2.
+         */
+        if (minbits * ndim >= sizeof(size_t) * 8){
+            return false;
+        }
+        g->shift = minbits;
+        for (size_t a=0; a < ndim; a++){
+            g->dims[a] = (size_t)1 << _rangend_log2ceil(g->dims[a]);
+        }
+        break;
+    default:
+        return false;
+    }
+
+    g->size = 1;
+    for (size_t a=0; a < ndim; a++){
+        g->size *= g->dims[a];
+    }
+
+    return true;
+}
+
+#endif /* DS_IMPLEMENTATION */
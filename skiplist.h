@@ -0,0 +1,459 @@
+#ifndef _DS_SKIPLIST_H
+#define _DS_SKIPLIST_H
+
+/* Skip List (ordered index) on memory arena.
+ * Namespace: skiplist
+ *
+ * The values are kept sorted according to a user comparator, providing
+ * search, insert and delete in O(log n) expected time and ordered iteration
+ * from any position (range scans).
+ * The nodes are allocated from the arena and linked by indexes, as slist.h.
+ * Every node has a tower of random height (p = 1/4) drawn from a
+ * deterministic xorshift generator, so the same sequence of operations
+ * produces the same structure.
+ *
+ * The actual values must be stored outside the list and
+ * guaranteed to be in the same scope of the list.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define SKIPLIST_NIL SIZE_MAX
+/* enough levels for 4^32 nodes */
+#define SKIPLIST_MAXLEVEL 32
+/* The upper levels of the towers need n/3 links on average, n links are
+ * reserved. If they runout the new towers are lowered (never fails).
+ */
+#define SKIPLIST_SIZEOF(n) ( sizeof(SkipList) + \
+        ((sizeof(SkipListNode) + sizeof(size_t)) * (size_t)(n)) )
+
+typedef struct SkipList SkipList;
+typedef struct SkipListNode SkipListNode;
+typedef struct SkipListIter SkipListIter;
+
+/* Compare two values, as qsort does.
+ * Return <0, 0, >0 if a is less, equal or greater than b.
+ * The search procedures call it with the stored value as first argument and
+ * the searched key as second.
+ */
+typedef int (*SkipListCompare)(const void *a, const void *b);
+
+struct SkipListNode {
+    void *value;   /* pointer to the user object to store */
+    size_t next;   /* level 0 link: index of the next node */
+    size_t tower;  /* index in SkipList.links of the level 1 link */
+    size_t height; /* number of levels of the node, at least 1 */
+};
+
+struct SkipList {
+    size_t size;   /* capacity */
+    size_t len;    /* number of stored nodes */
+    size_t level;  /* number of levels in use */
+    size_t used;   /* nodes never allocated are in [used, size) */
+    size_t lused;  /* links never allocated are in [lused, size) */
+    uint64_t rng;  /* state of the random generator */
+    SkipListCompare cmp;
+    size_t head[SKIPLIST_MAXLEVEL]; /* first node of every level */
+    size_t free[SKIPLIST_MAXLEVEL]; /* released nodes by height - 1 */
+    SkipListNode *nodes; /* array of 'size' nodes */
+    size_t *links;       /* array of 'size' links for the upper levels */
+};
+
+/* SkipList iterator.
+ * It refers to nodes in ascending order until SKIPLIST_NIL
+ */
+struct SkipListIter {
+    size_t curr;     /* index of the current node */
+    SkipList *list;  /* the reference to the list under iteration */
+};
+
+/* Construct an empty skip list of indicated capacity into the memory arena.
+ * The arena must be at least SKIPLIST_SIZEOF(capacity) long
+ * otherwise the behavior is undefined.
+ * The seed initializes the tower heights generator (any value).
+ * No aditional memory is allocated.
+ * Time complexity: O(1)
+ * Returns the pointer to the list in the arena or NULL in case of errors
+ */
+SkipList * skiplist_init(void *arena, size_t capacity, SkipListCompare cmp,
+                         uint64_t seed);
+
+/* Number of values in the list.
+ * Time complexity: O(1)
+ */
+static inline size_t skiplist_len(const SkipList *sl)
+{
+    if (sl == NULL){
+        return 0;
+    }
+    return sl->len;
+} /* skiplist_len */
+
+/* same as
+ * skiplist_len(sl) == 0
+ */
+static inline bool skiplist_isempty(const SkipList *sl)
+{
+    if (sl == NULL){
+        return true;
+    }
+    return sl->len == 0;
+} /* skiplist_isempty */
+
+/* Return true if the list has reached its maximum capacity */
+static inline bool skiplist_isfull(const SkipList *sl)
+{
+    if (sl == NULL){
+        return true;
+    }
+    return sl->len == sl->size;
+} /* skiplist_isfull */
+
+/* Internal use.
+ * Pointer to the link of the node x at level lvl.
+ * x == SKIPLIST_NIL refers to the head of the list.
+ */
+static inline size_t * _skiplist_link(SkipList *sl, size_t x, size_t lvl)
+{
+    if (x == SKIPLIST_NIL){
+        return &sl->head[lvl];
+    }
+
+    assert(x < sl->size);
+    assert(lvl < sl->nodes[x].height);
+
+    if (lvl == 0){
+        return &sl->nodes[x].next;
+    }
+    return &sl->links[sl->nodes[x].tower + lvl - 1];
+} /* _skiplist_link */
+
+/* Internal use.
+ * Fill update with the last node of every level for which
+ * cmp(value, key) < 0 (or <= 0 if after is true).
+ * Return the node following update[0].
+ */
+static inline size_t _skiplist_search(SkipList *sl, const void *key, bool after,
+                                      size_t update[SKIPLIST_MAXLEVEL])
+{
+    size_t x = SKIPLIST_NIL; /* head */
+
+    for (size_t lvl = sl->level; lvl-- > 0;){
+        size_t nx = *_skiplist_link(sl, x, lvl);
+        while (nx != SKIPLIST_NIL){
+            int c = sl->cmp(sl->nodes[nx].value, key);
+            if (c > 0 || (c == 0 && !after)){
+                break;
+            }
+            x = nx;
+            nx = *_skiplist_link(sl, x, lvl);
+        }
+        update[lvl] = x;
+    }
+
+    return *_skiplist_link(sl, x, 0);
+} /* _skiplist_search */
+
+/* Insert the value in order, after the values equal to it.
+ * value can be NULL only if the comparator manages it.
+ * Time complexity: O(log n) expected
+ * Return true if the value is inserted, false if the list is full.
+ */
+bool skiplist_insert(SkipList *sl, void *value);
+
+/* Search the first value equal to key.
+ * Time complexity: O(log n) expected
+ * Return the value or NULL if not found.
+ */
+static inline void * skiplist_find(SkipList *sl, const void *key)
+{
+    if (sl == NULL){
+        return NULL;
+    }
+
+    size_t update[SKIPLIST_MAXLEVEL];
+    size_t x = _skiplist_search(sl, key, false, update);
+    if (x == SKIPLIST_NIL){
+        return NULL;
+    }
+    if (sl->cmp(sl->nodes[x].value, key) != 0){
+        return NULL;
+    }
+    return sl->nodes[x].value;
+} /* skiplist_find */
+
+/* Remove the first value equal to key.
+ * Time complexity: O(log n) expected
+ * Return the removed value or NULL if not found.
+ */
+void * skiplist_delete(SkipList *sl, const void *key);
+
+/* Return true if the iterator has reached the end of the list */
+static inline bool skiplist_exhausted(SkipListIter it)
+{
+    return it.curr == SKIPLIST_NIL;
+} /* skiplist_exhausted */
+
+/* Get the value pointed by the iterator.
+ * Return NULL if iterator is exhausted.
+ */
+static inline void * skiplist_value(SkipListIter it)
+{
+    if (it.curr == SKIPLIST_NIL){
+        return NULL;
+    }
+
+    assert(it.list != NULL);
+    assert(it.curr < it.list->size);
+
+    return it.list->nodes[it.curr].value;
+} /* skiplist_value */
+
+/* Start an iterator from the smallest value and return it.
+ * Return NULL if no values present in the list.
+ */
+static inline void * skiplist_iter(SkipListIter *it, SkipList *sl)
+{
+    if (sl == NULL || it == NULL){
+        return NULL;
+    }
+
+    it->curr = sl->head[0];
+    it->list = sl;
+
+    return skiplist_value(*it);
+} /* skiplist_iter */
+
+/* Start an iterator from the first value not less than key and return it.
+ * A range scan seeks the lower bound and moves next while the values are
+ * in the range.
+ * Time complexity: O(log n) expected
+ * Return NULL if all the values are less than key.
+ */
+static inline void * skiplist_seek(SkipListIter *it, SkipList *sl, const void *key)
+{
+    if (sl == NULL || it == NULL){
+        return NULL;
+    }
+
+    size_t update[SKIPLIST_MAXLEVEL];
+    it->curr = _skiplist_search(sl, key, false, update);
+    it->list = sl;
+
+    return skiplist_value(*it);
+} /* skiplist_seek */
+
+/* Move the iterator to the next value, if possible.
+ * Return if the operation succeeded.
+ */
+static inline bool skiplist_next(SkipListIter *it)
+{
+    if (it == NULL){
+        return false;
+    }
+    if (it->curr == SKIPLIST_NIL){
+        return false;
+    }
+
+    it->curr = it->list->nodes[it->curr].next;
+
+    assert(it->curr < it->list->size || it->curr == SKIPLIST_NIL);
+
+    return true;
+} /* skiplist_next */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_SKIPLIST_IMPL)
+#define _DS_SKIPLIST_IMPL
+
+SkipList * skiplist_init(void *arena, size_t capacity, SkipListCompare cmp,
+                         uint64_t seed)
+{
+    if ((arena == NULL) || (cmp == NULL)){
+        return NULL;
+    }
+    if ((capacity == 0) || (capacity == SKIPLIST_NIL)){
+        return NULL;
+    }
+
+    uint8_t *mem = (uint8_t*)arena;
+    SkipList *sl = (SkipList*)arena;
+
+    sl->size = capacity;
+    sl->len = 0;
+    sl->level = 1;
+    sl->used = 0;
+    sl->lused = 0;
+    /* xorshift does not work with a zero state */
+    sl->rng = (seed != 0)?seed:0x9E3779B97F4A7C15ULL;
+    sl->cmp = cmp;
+
+    for (size_t i=0; i < SKIPLIST_MAXLEVEL; i++){
+        sl->head[i] = SKIPLIST_NIL;
+        sl->free[i] = SKIPLIST_NIL;
+    }
+
+    mem = &mem[sizeof(SkipList)];
+    sl->nodes = (SkipListNode*)mem;
+    mem = &mem[sizeof(SkipListNode) * capacity];
+    sl->links = (size_t*)mem;
+
+    return sl;
+} /* skiplist_init */
+
+/* Internal use.
+ * Random height of a new tower, geometric distribution with p = 1/4.
+ */
+static size_t _skiplist_height(SkipList *sl)
+{
+    /* xorshift64* */
+    uint64_t x = sl->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    sl->rng = x;
+    x *= 0x2545F4914F6CDD1DULL;
+
+    size_t h = 1;
+    while (((x & 3) == 0) && (h < SKIPLIST_MAXLEVEL)){
+        h++;
+        x >>= 2;
+    }
+    return h;
+} /* _skiplist_height */
+
+/* Internal use.
+ * Provide a free node with a tower of about height levels.
+ * The tower can be lower or higher if the links runout.
+ * return the index or SKIPLIST_NIL
+ */
+static size_t _skiplist_alloc(SkipList *sl, size_t height)
+{
+    assert(height > 0 && height <= SKIPLIST_MAXLEVEL);
+
+    size_t ind = sl->free[height - 1];
+
+    if (ind != SKIPLIST_NIL){
+        /* released node with the same tower */
+        sl->free[height - 1] = sl->nodes[ind].next;
+    } else if (sl->used < sl->size){
+        /* new node, the tower is taken from the unused links */
+        size_t up = height - 1;
+        if (up > sl->size - sl->lused){
+            up = sl->size - sl->lused;
+        }
+        ind = sl->used;
+        sl->used++;
+        sl->nodes[ind].tower = sl->lused;
+        sl->nodes[ind].height = up + 1;
+        sl->lused += up;
+    } else {
+        /* reuse the released node with the nearest height */
+        for (size_t d=1; d < SKIPLIST_MAXLEVEL && ind == SKIPLIST_NIL; d++){
+            if (height > d && sl->free[height - d - 1] != SKIPLIST_NIL){
+                ind = sl->free[height - d - 1];
+            } else if (height + d <= SKIPLIST_MAXLEVEL &&
+                       sl->free[height + d - 1] != SKIPLIST_NIL){
+                ind = sl->free[height + d - 1];
+            }
+        }
+        if (ind == SKIPLIST_NIL){
+            return SKIPLIST_NIL;
+        }
+        sl->free[sl->nodes[ind].height - 1] = sl->nodes[ind].next;
+    }
+
+    sl->len++;
+
+    assert(ind < sl->size);
+    return ind;
+} /* _skiplist_alloc */
+
+/* Internal use.
+ * Prepend the node to the free list of its height.
+ */
+static void _skiplist_dealloc(SkipList *sl, size_t node)
+{
+    assert(node < sl->size);
+    assert(sl->len > 0);
+
+    size_t h = sl->nodes[node].height;
+    sl->nodes[node].next = sl->free[h - 1];
+    sl->free[h - 1] = node;
+    sl->len--;
+} /* _skiplist_dealloc */
+
+bool skiplist_insert(SkipList *sl, void *value)
+{
+    if (sl == NULL){
+        return false;
+    }
+    if (sl->len == sl->size){
+        return false;
+    }
+
+    size_t update[SKIPLIST_MAXLEVEL];
+    _skiplist_search(sl, value, true, update);
+
+    size_t x = _skiplist_alloc(sl, _skiplist_height(sl));
+    if (x == SKIPLIST_NIL){
+        return false;
+    }
+
+    size_t h = sl->nodes[x].height;
+    /* the new levels start from the head */
+    for (size_t lvl = sl->level; lvl < h; lvl++){
+        update[lvl] = SKIPLIST_NIL;
+    }
+    if (h > sl->level){
+        sl->level = h;
+    }
+
+    sl->nodes[x].value = value;
+    for (size_t lvl = 0; lvl < h; lvl++){
+        size_t *prev = _skiplist_link(sl, update[lvl], lvl);
+        *_skiplist_link(sl, x, lvl) = *prev;
+        *prev = x;
+    }
+
+    return true;
+} /* skiplist_insert */
+
+void * skiplist_delete(SkipList *sl, const void *key)
+{
+    if (sl == NULL){
+        return NULL;
+    }
+
+    size_t update[SKIPLIST_MAXLEVEL];
+    size_t x = _skiplist_search(sl, key, false, update);
+    if (x == SKIPLIST_NIL){
+        return NULL;
+    }
+    void *value = sl->nodes[x].value;
+    if (sl->cmp(value, key) != 0){
+        return NULL;
+    }
+
+    /* x is the first node >= key, so it follows update[] on its levels */
+    for (size_t lvl = 0; lvl < sl->nodes[x].height; lvl++){
+        size_t *prev = _skiplist_link(sl, update[lvl], lvl);
+        assert(*prev == x);
+        *prev = *_skiplist_link(sl, x, lvl);
+    }
+
+    while (sl->level > 1 && sl->head[sl->level - 1] == SKIPLIST_NIL){
+        sl->level--;
+    }
+
+    _skiplist_dealloc(sl, x);
+
+    return value;
+} /* skiplist_delete */
+
+#endif /* DS_IMPLEMENTATION */
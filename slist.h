@@ -12,15 +12,38 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <assert.h>
+#include "stats.h"
 
 /* the corresponding value for NULL in size_t indexes is SIZE_MAX */
 #define SLIST_NIL SIZE_MAX
-#define SLIST_SIZEOF(n) ( sizeof(SList) + (sizeof(SListItem) * (size_t)n) )
+#define SLIST_SIZEOF(n) ( sizeof(SList) + (sizeof(SListItem) * (size_t)(n)) )
+
+/* Number of items that the bulk traversals prefetch in advance */
+#ifndef SLIST_PREFETCH_DISTANCE
+#define SLIST_PREFETCH_DISTANCE 8
+#endif
+
+#if defined(__GNUC__)
+#define SLIST_PREFETCH(p) __builtin_prefetch((p))
+#else
+#define SLIST_PREFETCH(p) ((void)(p))
+#endif
 
 typedef struct SList SList;
 typedef struct SListItem SListItem;
 typedef struct SListIter SListIter;
 
+/* Compare two values stored in the list, as qsort does.
+ * Return <0, 0, >0 if a is less, equal or greater than b.
+ */
+typedef int (*SListCompare)(const void *a, const void *b);
+
+/* Visit a value during slist_foreach.
+ * ctx is the user pointer passed to slist_foreach.
+ * Return false to stop the visit.
+ */
+typedef bool (*SListVisit)(void *value, void *ctx);
+
 struct SListItem {
     size_t next;  /* index of the next element in SList.items */
     void *value;  /* pointer to the user object to store */
@@ -31,7 +54,10 @@ struct SList {
     size_t len;   /* number of stored items */
     size_t head;  /* index of the list head item */
     size_t free;  /* index of the free list head item */
+    size_t used;  /* items never allocated are in [used, size) */
     SListItem *items; /* array of 'size' items */
+    SList *owner; /* list that manages the arena (itself if not shared) */
+    DS_STATS_MEMBER /* see stats.h */
 };
 
 /* SList iterator.
@@ -50,35 +76,44 @@ struct SListIter {
  * Time complexity: O(1)
  * Returns the pointer to the list in the arena or NULL in case of errors
  */
-SList * slist_init(void *arena, size_t capacity)
-{
-    if ((arena == NULL) || (capacity == 0) || (capacity == SLIST_NIL)){
-        return NULL;
-    }
+SList * slist_init(void *arena, size_t capacity);
 
-    /* point to the end of the SList struct */
-    uint8_t *mem = (uint8_t*)arena;
-    mem = &mem[sizeof(SList)];
+/* Construct an empty list that shares the arena of owner.
+ * The items are allocated from the same arena and the lists can exchange
+ * their items with slist_merge and slist_splice in O(1) space.
+ * The shared list can be stored anywhere (e.g. on the stack) but it must not
+ * outlive the arena of the owner.
+ * Time complexity: O(1)
+ * Return false in case of NULL arguments.
+ */
+bool slist_share(SList *list, SList *owner);
 
-    /* set list values */
-    SList *list = (SList*)arena;
-    list->size = capacity;
-    list->len = 0;
-    list->head = SLIST_NIL;
-    list->items = (SListItem*)mem;
+/* Attach to a list built by slist_init in the arena in a previous run
+ * (e.g. a file mapped at another address, see persist.h): the pointers of
+ * the list are derived again from the arena, the indexes are kept.
+ * The values are not changed, they must be valid in the new run.
+ * Time complexity: O(1)
+ * Return the list or NULL if the arena does not contain a valid list.
+ */
+SList * slist_attach(void *arena);
 
-    /* initialize the free list head */
-    list->free = 0;
-    list->items[list->free].next = (list->size > 1)?1:SLIST_NIL;
-    /* the free list is not completely initialized to avoid an O(n) operation */
+/* Attach a list shared with owner (see slist_share) in a previous run,
+ * keeping its items. owner must be already attached.
+ * Time complexity: O(1)
+ * Return false in case of NULL arguments or invalid list.
+ */
+bool slist_attach_shared(SList *list, SList *owner);
 
-    return list;
-} /* slist_init */
+/* Clear the pointers of the list, valid only in this run, before storing
+ * its arena. The list can be used again after slist_attach.
+ * Time complexity: O(1)
+ */
+void slist_detach(SList *list);
 
 /* Number of items in the list.
  * Time complexity: O(1)
  */
-size_t slist_len(const SList *list)
+static inline size_t slist_len(const SList *list)
 {
     if (list == NULL){
         return 0;
@@ -89,7 +124,7 @@ size_t slist_len(const SList *list)
 /* same as
  * slist_len(list) == 0
  */
-bool slist_isempty(SList *list)
+static inline bool slist_isempty(SList *list)
 {
     if (list == NULL){
         return true;
@@ -98,18 +133,21 @@ bool slist_isempty(SList *list)
     return list->len == 0;
 } /* slist_isempty */
 
-/* Return true if the list has reached its maximum capacity */
-bool slist_isfull(SList *list)
+/* Return true if the arena has no more items for the list.
+ * For shared lists, all the lists sharing the arena become full together.
+ */
+static inline bool slist_isfull(SList *list)
 {
     if (list == NULL){
         return true;
     }
 
-    return list->len == list->size;
+    const SList *owner = list->owner;
+    return (owner->free == SLIST_NIL) && (owner->used == owner->size);
 } /* slist_isfull */
 
 /* Return true if the iterator has reached the end of the list */
-bool slist_exhausted(SListIter it)
+static inline bool slist_exhausted(SListIter it)
 {
     return it.curr == SLIST_NIL;
 } /* slist_exhausted */
@@ -117,7 +155,7 @@ bool slist_exhausted(SListIter it)
 /* Get the value pointed by the iterator.
  * Return NULL if iterator is exhausted.
  */
-void * slist_value(SListIter it)
+static inline void * slist_value(SListIter it)
 {
     if (it.curr == SLIST_NIL){
         return NULL;
@@ -132,7 +170,7 @@ void * slist_value(SListIter it)
 /* Start an iterator and returns the first value.
  * Return NULL if no items present in the list.
  */
-void * slist_iter(SListIter *it, SList *list)
+static inline void * slist_iter(SListIter *it, SList *list)
 {
     if (list == NULL || it == NULL){
         return NULL;
@@ -148,7 +186,7 @@ void * slist_iter(SListIter *it, SList *list)
 /* Move the iterator to the next element, if possible.
  * Return if the operation succeeded.
  */
-bool slist_next(SListIter *it)
+static inline bool slist_next(SListIter *it)
 {
     if (it == NULL){
         return false;
@@ -169,33 +207,31 @@ bool slist_next(SListIter *it)
  * Provide the next free item.
  * return the index or SLIST_NIL
  */
-size_t _slist_alloc(SList *list)
+static inline size_t _slist_alloc(SList *list)
 {
     assert(list != NULL);
 
-    if (list->free == SLIST_NIL){
+    /* the arena (and its free list) is managed by the owner */
+    SList *owner = list->owner;
+    size_t ind;
+
+    if (owner->free != SLIST_NIL){
+        assert(owner->free < owner->size);
+
+        /* alloc the head of free list */
+        ind = owner->free;
+        /* move the freelist head to the next free item */
+        owner->free = owner->items[ind].next;
+        assert(owner->free < owner->size || owner->free == SLIST_NIL);
+    } else if (owner->used < owner->size){
+        /* free list runout items, take one never used */
+        ind = owner->used;
+        owner->used++;
+    } else {
         return SLIST_NIL;
     }
 
-    assert(list->free < list->size);
-
-    /* alloc the head of free list */
-    size_t ind = list->free;
-    /* move the freelist head to the next free item */
-    list->free = list->items[list->free].next;
-    assert(list->free < list->size || list->free == SLIST_NIL);
-
     list->len++;
-    /* If the list is compact, all the items are allocated in [0, len) and
-     * the free head then points to items[len].
-     * If the list is fragmented, the list has been filled by slist_delete()
-     * so free cannot refers to items[len] because it will be the last element
-     * of the free list.
-     */
-    if (list->free == list->len){
-        /* freelist runout items */
-        list->items[list->free].next = (list->len+1 < list->size)?list->len+1:SLIST_NIL;
-    }
 
     assert(ind < list->size);
     return ind;
@@ -204,28 +240,32 @@ size_t _slist_alloc(SList *list)
 /* Internal use.
  * Prepend the item to the free list
  */
-void _slist_dealloc(SList *list, size_t item)
+static inline void _slist_dealloc(SList *list, size_t item)
 {
     assert(list != NULL);
     assert(item < list->size);
     assert(list->len > 0);
 
-    list->items[item].next = list->free;
-    list->free = item;
+    SList *owner = list->owner;
+    owner->items[item].next = owner->free;
+    owner->free = item;
     list->len--;
 
     assert(list->len < list->size);
-    assert(list->free < list->size);
+    assert(owner->free < owner->size);
 } /* _slist_dealloc */
 
 /* insert value before it, if there is space left.
  * value can be NULL.
  * Return true if value inserted.
  */
-bool slist_insert(SListIter *it, void *value)
+static inline bool slist_insert(SListIter *it, void *value)
 {
+    DS_HOOK_ENTER("slist_insert", it->list);
     size_t f = _slist_alloc(it->list);
     if (f == SLIST_NIL){
+        DS_STATS_OP(it->list->stats, false);
+        DS_HOOK_EXIT("slist_insert", it->list, false);
         return false;
     }
     /* store the value in the previous free head item */
@@ -244,23 +284,29 @@ bool slist_insert(SListIter *it, void *value)
     /* the new item is now preceding the current (untouched) */
     it->prev = f;
 
+    DS_STATS_OP(it->list->stats, true);
+    DS_STATS_LEN(it->list->stats, it->list->len);
+    DS_HOOK_EXIT("slist_insert", it->list, true);
     return true;
 } /* slist_insert */
 
 /* Remove the item refered by it.
  * Return true if the operation succeed.
  */
-bool slist_delete(SListIter *it)
+static inline bool slist_delete(SListIter *it)
 {
     if (it == NULL){
         return false;
     }
+    assert(it->list != NULL);
+
+    DS_HOOK_ENTER("slist_delete", it->list);
     if (it->curr == SLIST_NIL){
+        DS_STATS_OP(it->list->stats, false);
+        DS_HOOK_EXIT("slist_delete", it->list, false);
         return false;
     }
 
-    assert(it->list != NULL);
-
     size_t item = it->curr;
     if (it->curr == it->list->head){
         assert(it->prev == SLIST_NIL);
@@ -279,14 +325,20 @@ bool slist_delete(SListIter *it)
 
     _slist_dealloc(it->list, item);
 
+    DS_STATS_OP(it->list->stats, true);
+    DS_HOOK_EXIT("slist_delete", it->list, true);
     return true;
 } /* slist_delete */
 
 /* as stacks, prepend value to the head.
  * Return true if succeed.
  */
-bool slist_push(SList *list, void *value)
+static inline bool slist_push(SList *list, void *value)
 {
+    if (list == NULL){
+        return false;
+    }
+
     SListIter it;
     slist_iter(&it, list);
     return slist_insert(&it, value);
@@ -295,8 +347,12 @@ bool slist_push(SList *list, void *value)
 /* as stacks, delete the head
  * return the value of the delete head (or NULL if empty)
  */
-void * slist_pop(SList *list)
+static inline void * slist_pop(SList *list)
 {
+    if (list == NULL){
+        return NULL;
+    }
+
     SListIter it;
     slist_iter(&it, list);
     void *v = slist_value(it);
@@ -304,4 +360,418 @@ void * slist_pop(SList *list)
     return v;
 } /* slist_pop */
 
+/* Snapshot of the statistics (see stats.h), all zero without DS_STATS */
+static inline DSStats slist_stats(const SList *list)
+{
+    return DS_STATS_GET(list);
+} /* slist_stats */
+
+/* Reset the statistics, the high-water mark restarts from the length */
+static inline void slist_stats_reset(SList *list)
+{
+    if (list == NULL){
+        return;
+    }
+    DS_STATS_RESET(list->stats, list->len);
+} /* slist_stats_reset */
+
+/* Sort the list in ascending order according to cmp.
+ * The sort is stable: equal values keep their insertion order.
+ * The items are relinked in place (bottom-up merge sort), the values are
+ * not moved and no additional memory is used.
+ * Time complexity: O(n log n)
+ */
+void slist_sort(SList *list, SListCompare cmp);
+
+/* Merge the sorted list src into the sorted list dst.
+ * The lists must share the same arena (see slist_share).
+ * The result is sorted and stable: on equal values the items of dst come
+ * first. At the end src is empty.
+ * Time complexity: O(n + m)
+ * Return false if the lists do not share the arena.
+ */
+bool slist_merge(SList *dst, SList *src, SListCompare cmp);
+
+/* Move all the items of src before the item pointed by it,
+ * as a sequence of slist_insert. At the end src is empty.
+ * The lists must share the same arena (see slist_share).
+ * Time complexity: O(m) where m is the length of src
+ * Return false if the lists do not share the arena.
+ */
+bool slist_splice(SListIter *it, SList *src);
+
+/* Internal use.
+ * Prefetch the object of the item ahead, then move ahead to the next item
+ * and prefetch it. The next call finds the item already loaded.
+ */
+static inline void _slist_prefetch_ahead(const SListItem *items, size_t *ahead)
+{
+    if (*ahead == SLIST_NIL){
+        return;
+    }
+    SLIST_PREFETCH(items[*ahead].value);
+    *ahead = items[*ahead].next;
+    if (*ahead != SLIST_NIL){
+        SLIST_PREFETCH(&items[*ahead]);
+    }
+} /* _slist_prefetch_ahead */
+
+/* Call visit on every value from the head, until it returns false.
+ * The items and the objects pointed by the values are prefetched
+ * SLIST_PREFETCH_DISTANCE items in advance, and there are no per item
+ * checks: the list must not be modified during the visit.
+ * Time complexity: O(n)
+ * Return the number of visited values.
+ */
+static inline size_t slist_foreach(SList *list, SListVisit visit, void *ctx)
+{
+    if (list == NULL || visit == NULL){
+        return 0;
+    }
+
+    const SListItem *items = list->items;
+    size_t curr = list->head;
+    size_t ahead = curr;
+    size_t n = 0;
+
+    for (size_t d=0; d < SLIST_PREFETCH_DISTANCE; d++){
+        _slist_prefetch_ahead(items, &ahead);
+    }
+
+    while (curr != SLIST_NIL){
+        _slist_prefetch_ahead(items, &ahead);
+
+        size_t next = items[curr].next;
+        n++;
+        if (!visit(items[curr].value, ctx)){
+            break;
+        }
+        curr = next;
+    }
+
+    return n;
+} /* slist_foreach */
+
+/* Copy in values the next (at most) k values from the iterator and move
+ * the iterator after them, as k calls of slist_value and slist_next.
+ * The items and the objects pointed by the values are prefetched, so
+ * the objects are being loaded while the caller processes the batch.
+ * Time complexity: O(k)
+ * Return the number of copied values, 0 if the iterator is exhausted.
+ */
+static inline size_t slist_gather(SListIter *it, void **values, size_t k)
+{
+    if (it == NULL || values == NULL){
+        return 0;
+    }
+    if (it->curr == SLIST_NIL){
+        return 0;
+    }
+
+    assert(it->list != NULL);
+
+    const SListItem *items = it->list->items;
+    size_t prev = it->prev;
+    size_t curr = it->curr;
+    size_t ahead = curr;
+    size_t n = 0;
+
+    for (size_t d=0; d < SLIST_PREFETCH_DISTANCE && d < k; d++){
+        _slist_prefetch_ahead(items, &ahead);
+    }
+
+    while (n < k && curr != SLIST_NIL){
+        _slist_prefetch_ahead(items, &ahead);
+
+        values[n] = items[curr].value;
+        n++;
+        prev = curr;
+        curr = items[curr].next;
+    }
+
+    it->prev = prev;
+    it->curr = curr;
+
+    return n;
+} /* slist_gather */
+
 #endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_SLIST_IMPL)
+#define _DS_SLIST_IMPL
+
+SList * slist_init(void *arena, size_t capacity)
+{
+    if ((arena == NULL) || (capacity == 0) || (capacity == SLIST_NIL)){
+        return NULL;
+    }
+
+    /* point to the end of the SList struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(SList)];
+
+    /* set list values */
+    SList *list = (SList*)arena;
+    list->size = capacity;
+    list->len = 0;
+    list->head = SLIST_NIL;
+    list->items = (SListItem*)mem;
+    list->owner = list;
+
+    /* the free list contains only the released items, the items never
+     * allocated are taken from 'used' to avoid an O(n) initialization.
+     */
+    list->free = SLIST_NIL;
+    list->used = 0;
+    DS_STATS_RESET(list->stats, 0);
+
+    return list;
+} /* slist_init */
+
+bool slist_share(SList *list, SList *owner)
+{
+    if (list == NULL || owner == NULL){
+        return false;
+    }
+
+    list->size = owner->size;
+    list->len = 0;
+    list->head = SLIST_NIL;
+    list->free = SLIST_NIL; /* unused, the free list is in the owner */
+    list->used = 0;         /* unused */
+    list->items = owner->items;
+    list->owner = owner->owner;
+    DS_STATS_RESET(list->stats, 0);
+
+    return true;
+} /* slist_share */
+
+/* Internal use.
+ * Check the indexes of a list stored in a previous run.
+ */
+static bool _slist_valid(const SList *list, size_t size)
+{
+    if (list->size != size || size == 0 || size == SLIST_NIL){
+        return false;
+    }
+    if (list->len > size || list->used > size){
+        return false;
+    }
+    if (list->head != SLIST_NIL && list->head >= size){
+        return false;
+    }
+    return list->free == SLIST_NIL || list->free < size;
+} /* _slist_valid */
+
+SList * slist_attach(void *arena)
+{
+    if (arena == NULL){
+        return NULL;
+    }
+
+    SList *list = (SList*)arena;
+    if (!_slist_valid(list, list->size) || list->len > list->used){
+        return NULL;
+    }
+
+    /* point to the end of the SList struct */
+    uint8_t *mem = (uint8_t*)arena;
+    list->items = (SListItem*)&mem[sizeof(SList)];
+    list->owner = list;
+
+    return list;
+} /* slist_attach */
+
+bool slist_attach_shared(SList *list, SList *owner)
+{
+    if (list == NULL || owner == NULL || owner->owner != owner){
+        return false;
+    }
+    if (!_slist_valid(list, owner->size)){
+        return false;
+    }
+
+    list->items = owner->items;
+    list->owner = owner;
+
+    return true;
+} /* slist_attach_shared */
+
+void slist_detach(SList *list)
+{
+    if (list == NULL){
+        return;
+    }
+
+    list->items = NULL;
+    list->owner = NULL;
+} /* slist_detach */
+
+/* Internal use.
+ * Append the item e to the chain [*head, *tail] without terminating it.
+ */
+static void _slist_link(SListItem *items, size_t *head, size_t *tail, size_t e)
+{
+    if (*tail == SLIST_NIL){
+        *head = e;
+    } else {
+        items[*tail].next = e;
+    }
+    *tail = e;
+} /* _slist_link */
+
+void slist_sort(SList *list, SListCompare cmp)
+{
+    if (list == NULL || cmp == NULL){
+        return;
+    }
+    if (list->len < 2){
+        return;
+    }
+
+    SListItem *items = list->items;
+    size_t head = list->head;
+
+    /* merge adjacent runs of 'width' items until only one run is left */
+    for (size_t width = 1; ; width *= 2){
+        size_t p = head;
+        size_t tail = SLIST_NIL;
+        size_t merges = 0;
+
+        head = SLIST_NIL;
+
+        while (p != SLIST_NIL){
+            merges++;
+
+            /* q is the head of the second run, p of the first one */
+            size_t q = p;
+            size_t psize = 0;
+            while (psize < width && q != SLIST_NIL){
+                psize++;
+                q = items[q].next;
+            }
+            size_t qsize = width;
+
+            while (psize > 0 || (qsize > 0 && q != SLIST_NIL)){
+                size_t e;
+                /* take from the first run when equal, for stability */
+                if (psize == 0){
+                    e = q;
+                    q = items[q].next;
+                    qsize--;
+                } else if (qsize == 0 || q == SLIST_NIL){
+                    e = p;
+                    p = items[p].next;
+                    psize--;
+                } else if (cmp(items[q].value, items[p].value) < 0){
+                    e = q;
+                    q = items[q].next;
+                    qsize--;
+                } else {
+                    e = p;
+                    p = items[p].next;
+                    psize--;
+                }
+                _slist_link(items, &head, &tail, e);
+            }
+
+            p = q;
+        }
+
+        assert(tail != SLIST_NIL);
+        items[tail].next = SLIST_NIL;
+
+        if (merges <= 1){
+            break;
+        }
+    }
+
+    list->head = head;
+} /* slist_sort */
+
+bool slist_merge(SList *dst, SList *src, SListCompare cmp)
+{
+    if (dst == NULL || src == NULL || cmp == NULL){
+        return false;
+    }
+    if (dst == src || dst->owner != src->owner){
+        return false;
+    }
+
+    SListItem *items = dst->items;
+    size_t p = dst->head;
+    size_t q = src->head;
+    size_t head = SLIST_NIL;
+    size_t tail = SLIST_NIL;
+
+    while (p != SLIST_NIL && q != SLIST_NIL){
+        size_t e;
+        if (cmp(items[q].value, items[p].value) < 0){
+            e = q;
+            q = items[q].next;
+        } else {
+            e = p;
+            p = items[p].next;
+        }
+        _slist_link(items, &head, &tail, e);
+    }
+
+    /* attach the remaining run, already terminated */
+    size_t rest = (p != SLIST_NIL)?p:q;
+    if (tail == SLIST_NIL){
+        head = rest;
+    } else {
+        items[tail].next = rest;
+    }
+
+    dst->head = head;
+    dst->len += src->len;
+    DS_STATS_LEN(dst->stats, dst->len);
+    src->head = SLIST_NIL;
+    src->len = 0;
+
+    return true;
+} /* slist_merge */
+
+bool slist_splice(SListIter *it, SList *src)
+{
+    if (it == NULL || src == NULL){
+        return false;
+    }
+
+    SList *list = it->list;
+    if (list == NULL || list == src || list->owner != src->owner){
+        return false;
+    }
+    if (src->head == SLIST_NIL){
+        return true;
+    }
+
+    SListItem *items = list->items;
+
+    /* find the tail of src */
+    size_t last = src->head;
+    while (items[last].next != SLIST_NIL){
+        last = items[last].next;
+    }
+
+    items[last].next = it->curr;
+    if (it->prev == SLIST_NIL){
+        list->head = src->head;
+    } else {
+        assert(it->prev < list->size);
+        items[it->prev].next = src->head;
+    }
+
+    /* the spliced items are now preceding the current (untouched) */
+    it->prev = last;
+
+    list->len += src->len;
+    DS_STATS_LEN(list->stats, list->len);
+    src->head = SLIST_NIL;
+    src->len = 0;
+
+    return true;
+} /* slist_splice */
+
+#endif /* DS_IMPLEMENTATION */
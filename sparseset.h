@@ -0,0 +1,193 @@
+#ifndef _DS_SPARSESET_H
+#define _DS_SPARSESET_H
+
+/* Sparse Set on memory arena
+ * Namespace: sparseset
+ *
+ * Set of ids in [0, universe) (connection ids, entities, ...) with at most
+ * capacity members: the dense array has the members contiguous, the sparse
+ * array has the position in dense of every id.
+ * insert, remove, contains and clear are O(1), the iteration scans only the
+ * dense array (len ids), not the universe as a bitmap does.
+ * An id is a member only if the two arrays agree, so clear just resets the
+ * length. The remove moves the last member into the hole: the order of the
+ * members changes.
+ *
+ *  for (size_t i=0; i < sparseset_len(s); i++){
+ *      size_t id = sparseset_at(s, i);
+ *  }
+ *
+ * Iterating from the last member to the first, the current one can be
+ * removed.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define SPARSESET_NIL SIZE_MAX
+#define SPARSESET_SIZEOF(universe, capacity) ( sizeof(SparseSet) + \
+        (sizeof(size_t) * ((size_t)(universe) + (size_t)(capacity))) )
+
+typedef struct SparseSet SparseSet;
+
+struct SparseSet {
+    size_t universe; /* the ids are in [0, universe) */
+    size_t size;     /* capacity */
+    size_t len;      /* number of members */
+    size_t *dense;   /* array of 'size' ids, the members are in [0, len) */
+    size_t *sparse;  /* array of 'universe' positions in dense */
+};
+
+/* Construct an empty set of ids in [0, universe) with at most capacity
+ * members into the memory arena (capacity can be less than universe).
+ * The arena must be at least SPARSESET_SIZEOF(universe, capacity) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(universe)
+ * Returns the pointer to the set in the arena or NULL in case of errors
+ */
+SparseSet * sparseset_init(void *arena, size_t universe, size_t capacity);
+
+/* Number of members.
+ * Time complexity: O(1)
+ */
+static inline size_t sparseset_len(const SparseSet *s)
+{
+    if (s == NULL){
+        return 0;
+    }
+    return s->len;
+} /* sparseset_len */
+
+static inline bool sparseset_isempty(const SparseSet *s)
+{
+    return sparseset_len(s) == 0;
+} /* sparseset_isempty */
+
+/* Return true if no id can be inserted */
+static inline bool sparseset_isfull(const SparseSet *s)
+{
+    if (s == NULL){
+        return true;
+    }
+    return s->len == s->size;
+} /* sparseset_isfull */
+
+/* Return true if the id is a member.
+ * Time complexity: O(1)
+ */
+static inline bool sparseset_contains(const SparseSet *s, size_t id)
+{
+    if (s == NULL || id >= s->universe){
+        return false;
+    }
+    size_t i = s->sparse[id];
+    return i < s->len && s->dense[i] == id;
+} /* sparseset_contains */
+
+/* Member at position i of the dense array, in [0, len).
+ * Return SPARSESET_NIL if i is out of range.
+ */
+static inline size_t sparseset_at(const SparseSet *s, size_t i)
+{
+    if (s == NULL || i >= s->len){
+        return SPARSESET_NIL;
+    }
+    return s->dense[i];
+} /* sparseset_at */
+
+/* The dense array of the len members, valid up to the next change */
+static inline const size_t * sparseset_dense(const SparseSet *s)
+{
+    if (s == NULL){
+        return NULL;
+    }
+    return s->dense;
+} /* sparseset_dense */
+
+/* Add the id to the members.
+ * Time complexity: O(1)
+ * Return false if the id is out of range, already a member or the set is
+ * full.
+ */
+static inline bool sparseset_insert(SparseSet *s, size_t id)
+{
+    if (s == NULL || id >= s->universe || s->len == s->size){
+        return false;
+    }
+    if (sparseset_contains(s, id)){
+        return false;
+    }
+
+    s->dense[s->len] = id;
+    s->sparse[id] = s->len;
+    s->len++;
+    return true;
+} /* sparseset_insert */
+
+/* Remove the id from the members, the last member takes its position.
+ * Time complexity: O(1)
+ * Return false if the id is not a member.
+ */
+static inline bool sparseset_remove(SparseSet *s, size_t id)
+{
+    if (!sparseset_contains(s, id)){
+        return false;
+    }
+
+    size_t i = s->sparse[id];
+    size_t last = s->dense[s->len - 1];
+    s->dense[i] = last;
+    s->sparse[last] = i;
+    s->len--;
+    return true;
+} /* sparseset_remove */
+
+/* Remove all the members.
+ * Time complexity: O(1)
+ */
+static inline void sparseset_clear(SparseSet *s)
+{
+    if (s == NULL){
+        return;
+    }
+    s->len = 0;
+} /* sparseset_clear */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_SPARSESET_IMPL)
+#define _DS_SPARSESET_IMPL
+
+SparseSet * sparseset_init(void *arena, size_t universe, size_t capacity)
+{
+    if (arena == NULL || universe == 0 || capacity == 0){
+        return NULL;
+    }
+    if (universe == SPARSESET_NIL || capacity > universe){
+        return NULL;
+    }
+
+    /* point to the end of the SparseSet struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(SparseSet)];
+
+    SparseSet *s = (SparseSet*)arena;
+    s->universe = universe;
+    s->size = capacity;
+    s->len = 0;
+    s->dense = (size_t*)mem;
+    s->sparse = &s->dense[capacity];
+
+    /* any position would do (contains checks dense), but it is read */
+    for (size_t id=0; id < universe; id++){
+        s->sparse[id] = SPARSESET_NIL;
+    }
+
+    return s;
+} /* sparseset_init */
+
+#endif /* DS_IMPLEMENTATION */
@@ -9,27 +9,31 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
+#include "stats.h"
 
 /* Do not use top directly, use the methods */
 struct StackIndex {
     size_t size; /* size included as index */
     size_t top; /* 0: underflow, valid between [1,size] */
+    DS_STATS_MEMBER /* see stats.h */
 };
 
 typedef struct StackIndex StackIndex;
 
-int stack_init(StackIndex *s, const size_t size)
+static inline int stack_init(StackIndex *s, const size_t size)
 {
     if (s == NULL){
         return -1;
     }
     s->size = size;
     s->top = 0;
+    DS_STATS_RESET(s->stats, 0);
 
     return 0;
 }
 
-bool stack_isempty(const StackIndex *s)
+static inline bool stack_isempty(const StackIndex *s)
 {
     if (s == NULL){
         return false;
@@ -37,7 +41,7 @@ bool stack_isempty(const StackIndex *s)
     return s->top == 0;
 }
 
-bool stack_isfull(const StackIndex *s)
+static inline bool stack_isfull(const StackIndex *s)
 {
     if (s == NULL){
         return false;
@@ -48,35 +52,156 @@ bool stack_isfull(const StackIndex *s)
 /* return the index for setting the value in the support array.
  * -1 in case of overflow
  */
-long stack_push(StackIndex *s)
+static inline long stack_push(StackIndex *s)
 {
     if (s == NULL){
         return -1;
     }
 
+    DS_HOOK_ENTER("stack_push", s);
     if (stack_isfull(s)){
+        DS_STATS_OP(s->stats, false);
+        DS_HOOK_EXIT("stack_push", s, false);
         return -1;
     }
 
     s->top++;
+    DS_STATS_OP(s->stats, true);
+    DS_STATS_LEN(s->stats, s->top);
+    DS_HOOK_EXIT("stack_push", s, true);
     return (long)s->top-1;
 }
 
 /* return the index for getting the value in the support array.
  * -1 in case of underflow
  */
-long stack_pop(StackIndex *s)
+static inline long stack_pop(StackIndex *s)
 {
     if (s == NULL){
         return -1;
     }
 
+    DS_HOOK_ENTER("stack_pop", s);
     if (stack_isempty(s)){
+        DS_STATS_OP(s->stats, false);
+        DS_HOOK_EXIT("stack_pop", s, false);
         return -1;
     }
 
     long i = (long)s->top - 1;
     s->top--;
+    DS_STATS_OP(s->stats, true);
+    DS_HOOK_EXIT("stack_pop", s, true);
     return i;
 }
+
+/* Snapshot of the statistics (see stats.h), all zero without DS_STATS */
+static inline DSStats stack_stats(const StackIndex *s)
+{
+    return DS_STATS_GET(s);
+}
+
+/* Reset the statistics, the high-water mark restarts from the length */
+static inline void stack_stats_reset(StackIndex *s)
+{
+    if (s == NULL){
+        return;
+    }
+    DS_STATS_RESET(s->stats, s->top);
+}
+
+/* Define a typed stack of values on a caller array, as static inline
+ * procedures without the index casts of StackIndex:
+ *
+ *  DS_DEFINE_STACK(IntStack, int)
+ *
+ *  int buf[64];
+ *  IntStack s;
+ *  IntStack_init(&s, buf, 64);
+ *  IntStack_push(&s, 42);
+ *
+ * It generates the struct id and the procedures
+ * id_init(s, data, size): false if data is NULL or size is 0;
+ * id_len(s), id_isempty(s), id_isfull(s);
+ * id_push(s, v): false if full;
+ * id_pop(s, &v): false if empty, v untouched;
+ * id_top(s): pointer to the top value, NULL if empty;
+ * id_push_n(s, src, n): copy the values as n push, return how many fit;
+ * id_pop_n(s, dst, n): remove the top min(n, len) values and copy them in
+ *   dst in the order they were pushed (the former top is the last one),
+ *   return how many are removed.
+ * The array is not owned by the stack. Use it at file scope.
+ */
+#define DS_DEFINE_STACK(id, type) \
+typedef struct id id; \
+struct id { \
+    type *data;  /* support array */ \
+    size_t size; /* capacity */ \
+    size_t top;  /* number of values, the next free slot */ \
+}; \
+static inline bool id##_init(id *s, type *data, size_t size) \
+{ \
+    if (s == NULL || data == NULL || size == 0){ \
+        return false; \
+    } \
+    s->data = data; \
+    s->size = size; \
+    s->top = 0; \
+    return true; \
+} \
+static inline size_t id##_len(const id *s) \
+{ \
+    return s->top; \
+} \
+static inline bool id##_isempty(const id *s) \
+{ \
+    return s->top == 0; \
+} \
+static inline bool id##_isfull(const id *s) \
+{ \
+    return s->top == s->size; \
+} \
+static inline bool id##_push(id *s, type v) \
+{ \
+    if (s->top == s->size){ \
+        return false; \
+    } \
+    s->data[s->top++] = v; \
+    return true; \
+} \
+static inline bool id##_pop(id *s, type *v) \
+{ \
+    if (s->top == 0){ \
+        return false; \
+    } \
+    *v = s->data[--s->top]; \
+    return true; \
+} \
+static inline type * id##_top(id *s) \
+{ \
+    if (s->top == 0){ \
+        return NULL; \
+    } \
+    return &s->data[s->top - 1]; \
+} \
+static inline size_t id##_push_n(id *s, const type *src, size_t n) \
+{ \
+    size_t room = s->size - s->top; \
+    n = (n < room)?n:room; \
+    if (n > 0){ \
+        memcpy(&s->data[s->top], src, n * sizeof(type)); \
+    } \
+    s->top += n; \
+    return n; \
+} \
+static inline size_t id##_pop_n(id *s, type *dst, size_t n) \
+{ \
+    n = (n < s->top)?n:s->top; \
+    s->top -= n; \
+    if (n > 0){ \
+        memcpy(dst, &s->data[s->top], n * sizeof(type)); \
+    } \
+    return n; \
+}
+
 #endif
@@ -0,0 +1,91 @@
+#ifndef _DS_STATS_H
+#define _DS_STATS_H
+
+/* Statistics and Hooks
+ * Namespace: ds_stats
+ *
+ * Compile time instrumentation of objpool.h, queue.h, stack.h, slist.h and
+ * range.h, disabled by default and compiled to nothing.
+ *
+ * Statistics: define DS_STATS (for the whole program, it changes the size
+ * of the structures) to keep a DSStats in every instance:
+ * - ops: calls of the operations that change the length (or convert an
+ *   index, for Range);
+ * - fails: the operations failed for full/empty structure (or indexes out
+ *   of range, for Range);
+ * - hwm: the highest length reached (high-water mark);
+ * - clbks: callback invocations (Range only).
+ * Every structure has the *_stats() snapshot (a copy of the counters, all
+ * zero if DS_STATS is not defined) and *_stats_reset(). A Range is passed by
+ * value, so it refers to a DSStats owned by the user (range_set_stats).
+ * The counters are not atomic, as the structures.
+ *
+ * Hooks: define DS_HOOK_ENTER(op, obj) and DS_HOOK_EXIT(op, obj, ok) before
+ * including the headers to trace the operations. op is the name of the
+ * procedure (string literal), obj the instance and ok the outcome.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct DSStats DSStats;
+
+struct DSStats {
+    size_t ops;    /* operations */
+    size_t fails;  /* failed operations */
+    size_t hwm;    /* high-water mark of the length */
+    size_t clbks;  /* callback invocations */
+};
+
+#ifdef DS_STATS
+
+/* the member to add to the instrumented structures */
+#define DS_STATS_MEMBER DSStats stats;
+
+#define DS_STATS_RESET(s, len) \
+    ((s).ops = 0, (s).fails = 0, (s).hwm = (len), (s).clbks = 0)
+
+/* count an operation and its outcome */
+#define DS_STATS_OP(s, ok) ((s).ops++, (s).fails += !(ok))
+
+/* update the high-water mark with the current length */
+#define DS_STATS_LEN(s, len) \
+    ((s).hwm = ((len) > (s).hwm)?(len):(s).hwm)
+
+/* add n operations, bad of them failed */
+#define DS_STATS_OPS(s, n, bad) ((s).ops += (n), (s).fails += (bad))
+
+
+/* the snapshot of the member of instance p (can be NULL) */
+#define DS_STATS_GET(p) ds_stats_copy(((p) == NULL)?NULL:&(p)->stats)
+
+#else
+
+#define DS_STATS_MEMBER
+#define DS_STATS_RESET(s, len) ((void)0)
+#define DS_STATS_OP(s, ok) ((void)0)
+#define DS_STATS_LEN(s, len) ((void)0)
+#define DS_STATS_OPS(s, n, bad) ((void)0)
+#define DS_STATS_GET(p) ((void)(p), ds_stats_copy(NULL))
+
+#endif /* DS_STATS */
+
+#ifndef DS_HOOK_ENTER
+#define DS_HOOK_ENTER(op, obj) ((void)0)
+#endif
+
+#ifndef DS_HOOK_EXIT
+#define DS_HOOK_EXIT(op, obj, ok) ((void)0)
+#endif
+
+/* Copy of the counters, all zero if s is NULL */
+static inline DSStats ds_stats_copy(const DSStats *s)
+{
+    DSStats c = {0, 0, 0, 0};
+    if (s != NULL){
+        c = *s;
+    }
+    return c;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/* Implementation unit of test_multitu.
+ * It provides the DS_IMPLEMENTATION definitions and uses the same static
+ * inline procedures of the other unit.
+ */
+
+#define DS_IMPLEMENTATION
+#include "vmem.h" /* vmem.h and persist.h before the system headers */
+#include "persist.h"
+#include "range.h"
+#include "stack.h"
+#include "queue.h"
+#include "objpool.h"
+#include "slist.h"
+#include "dlist.h"
+#include "skiplist.h"
+#include "ilist.h"
+#include "cslist.h"
+#include "rangend.h"
+#include "hashidx.h"
+#include "arena.h"
+#include "bitpool.h"
+#include "heap.h"
+#include "timerwheel.h"
+#include "lru.h"
+#include "ebr.h"
+#include "sparseset.h"
+
+/* push the n values on the list, return the number of pushed */
+size_t multitu_fill(SList *list, int *values, size_t n)
+{
+    size_t cnt = 0;
+    for (size_t i=0; i < n; i++){
+        cnt += slist_push(list, &values[i]);
+    }
+    return cnt;
+}
@@ -0,0 +1,149 @@
+/* Test Linear Arena allocator */
+
+#define DS_IMPLEMENTATION
+#include "arena.h"
+#include "slist.h"
+#include "objpool.h"
+#include "hashidx.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 16
+
+typedef struct {
+    int key;
+    double value;
+} Obj;
+
+static void test_init()
+{
+    puts("arena/test_init");
+
+    uint8_t mem[64];
+    Arena a;
+
+    assert_false(arena_init(NULL, mem, sizeof(mem)), "init not arena");
+    assert_false(arena_init(&a, NULL, sizeof(mem)), "init not mem");
+    assert_true(arena_init(&a, mem, sizeof(mem)), "init");
+    assert_true(arena_avail(&a) == sizeof(mem), "avail");
+    assert_true(arena_mark(&a) == 0, "mark");
+
+    assert_true(arena_alloc(NULL, 1, 1) == NULL, "alloc null");
+    assert_true(arena_alloc(&a, 1, 0) == NULL, "align 0");
+    assert_true(arena_alloc(&a, 1, 3) == NULL, "align not power of 2");
+    assert_true(arena_avail(NULL) == 0, "avail null");
+    assert_false(arena_rewind(NULL, 0), "rewind null");
+    arena_reset(NULL);
+}
+
+static void test_alloc()
+{
+    puts("arena/test_alloc");
+
+    static uint8_t mem[256];
+    Arena a;
+    arena_init(&a, mem, sizeof(mem));
+
+    uint8_t *p1 = arena_alloc(&a, 1, 1);
+    assert_true(p1 == mem, "first");
+    uint8_t *p2 = arena_alloc(&a, 8, 8);
+    assert_true(p2 != NULL && (uintptr_t)p2 % 8 == 0, "aligned 8");
+    assert_true(p2 > p1, "after");
+    uint8_t *p3 = arena_alloc(&a, 3, 64);
+    assert_true(p3 != NULL && (uintptr_t)p3 % 64 == 0, "aligned 64");
+    void *p4 = arena_push(&a, sizeof(Obj));
+    assert_true(p4 != NULL && (uintptr_t)p4 % ARENA_ALIGN == 0, "push");
+
+    /* exhaustion */
+    size_t avail = arena_avail(&a);
+    assert_true(arena_alloc(&a, avail + 1, 1) == NULL, "no room");
+    assert_true(arena_alloc(&a, SIZE_MAX, 1) == NULL, "no overflow");
+    assert_true(arena_avail(&a) == avail, "unchanged on fail");
+    assert_true(arena_alloc(&a, avail, 1) != NULL, "all the rest");
+    assert_true(arena_avail(&a) == 0, "empty");
+    assert_true(arena_alloc(&a, 0, 1) != NULL, "zero bytes");
+    assert_true(arena_alloc(&a, 1, 1) == NULL, "full");
+    assert_true(a.hwm == sizeof(mem), "hwm");
+
+    arena_reset(&a);
+    assert_true(arena_avail(&a) == sizeof(mem), "reset");
+    assert_true(arena_alloc(&a, 1, 1) == mem, "reuse");
+    assert_true(a.hwm == sizeof(mem), "hwm after reset");
+}
+
+static void test_mark()
+{
+    puts("arena/test_mark");
+
+    static uint8_t mem[256];
+    Arena a;
+    arena_init(&a, mem, sizeof(mem));
+
+    arena_push(&a, 10);
+    ArenaMark m1 = arena_mark(&a);
+    void *p1 = arena_push(&a, 20);
+    ArenaMark m2 = arena_mark(&a);
+    arena_push(&a, 30);
+
+    assert_true(arena_rewind(&a, m2), "rewind m2");
+    assert_true(arena_mark(&a) == m2, "at m2");
+    assert_true(arena_rewind(&a, m1), "rewind m1");
+    assert_false(arena_rewind(&a, m2), "m2 beyond");
+    assert_true(arena_push(&a, 20) == p1, "same address");
+}
+
+static void test_compose()
+{
+    puts("arena/test_compose");
+
+    /* a list, a pool and an index on a single region */
+    const size_t slots = hashidx_slots(N);
+    size_t size = ARENA_SIZEOF(SLIST_SIZEOF(N)) +
+                  ARENA_SIZEOF(OBJPOOL_SIZEOF(N, sizeof(Obj))) +
+                  ARENA_SIZEOF(HASHIDX_SIZEOF(slots));
+    /* the worst case: the region is not aligned */
+    uint8_t *mem = malloc(size + 1);
+    Arena a;
+    assert_true(arena_init(&a, &mem[1], size), "init");
+
+    for (int round=0; round < 3; round++){
+        ArenaMark m = arena_mark(&a);
+        SList *list = slist_init(arena_push(&a, SLIST_SIZEOF(N)), N);
+        assert_true(list != NULL, "slist");
+        ObjPool pool;
+        assert_true(objpool_init(&pool,
+                                 arena_push(&a, OBJPOOL_SIZEOF(N, sizeof(Obj))),
+                                 N, sizeof(Obj)), "objpool");
+        HashIdx *h = hashidx_init(arena_push(&a, HASHIDX_SIZEOF(slots)), slots);
+        assert_true(h != NULL, "hashidx");
+
+        for (int i=0; i < N; i++){
+            Obj *obj = objpool_acquire(&pool);
+            obj->key = i + round;
+            assert_true(slist_push(list, obj), "push");
+            assert_true(hashidx_insert(h, (uint64_t)i,
+                                       objpool_index(&pool, obj)), "insert");
+        }
+        assert_true(slist_isfull(list), "full");
+        assert_true(objpool_acquire(&pool) == NULL, "pool empty");
+
+        assert_true(arena_rewind(&a, m), "rewind");
+    }
+    assert_true(a.hwm <= a.size, "hwm fits");
+
+    free(mem);
+}
+
+int main()
+{
+    test_init();
+    test_alloc();
+    test_mark();
+    test_compose();
+
+    puts("OK");
+    return 0;
+}
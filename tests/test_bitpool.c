@@ -0,0 +1,175 @@
+/* Test Bitmap slot allocator */
+
+#define DS_IMPLEMENTATION
+#include "bitpool.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+static BitPool * setup(size_t n)
+{
+    return bitpool_init(malloc(BITPOOL_SIZEOF(n)), n);
+}
+
+static void test_init()
+{
+    puts("bitpool/test_init");
+
+    void *arena = malloc(BITPOOL_SIZEOF(64));
+    assert_true(bitpool_init(NULL, 64) == NULL, "arena null");
+    assert_true(bitpool_init(arena, 0) == NULL, "size 0");
+
+    BitPool *b = bitpool_init(arena, 64);
+    assert_true(b != NULL, "init");
+    assert_true(b->levels == 1, "one level");
+    assert_true(bitpool_len(b) == 0, "empty");
+    assert_false(bitpool_isfull(b), "not full");
+    assert_true(bitpool_isfree(b, 63), "free");
+    assert_false(bitpool_isfree(b, 64), "out of range");
+    free(arena);
+
+    b = setup(64 * 64 + 1);
+    assert_true(b->levels == 3, "three levels");
+    free(b);
+
+    assert_true(bitpool_len(NULL) == 0, "len null");
+    assert_true(bitpool_isfull(NULL), "isfull null");
+    assert_true(bitpool_alloc(NULL) == BITPOOL_NIL, "alloc null");
+    assert_false(bitpool_free(NULL, 0), "free null");
+    assert_true(bitpool_alloc_run(NULL, 2) == BITPOOL_NIL, "run null");
+}
+
+static void test_alloc()
+{
+    puts("bitpool/test_alloc");
+
+    /* three levels, the last word in part */
+    const size_t n = 64 * 64 * 2 + 77;
+    BitPool *b = setup(n);
+
+    for (size_t i=0; i < n; i++){
+        assert_true(bitpool_alloc(b) == i, "alloc in order");
+    }
+    assert_true(bitpool_isfull(b), "full");
+    assert_true(bitpool_alloc(b) == BITPOOL_NIL, "alloc full");
+    assert_true(bitpool_next_free(b, 0) == BITPOOL_NIL, "no next");
+
+    /* the lowest free slot comes first */
+    const size_t freed[] = {n - 1, 5000, 4095, 64, 3};
+    for (size_t i=0; i < 5; i++){
+        assert_true(bitpool_free(b, freed[i]), "free");
+        assert_false(bitpool_free(b, freed[i]), "double free");
+    }
+    assert_false(bitpool_free(b, n), "free out of range");
+    assert_true(bitpool_len(b) == n - 5, "len");
+    assert_true(bitpool_next_free(b, 65) == 4095, "next");
+    assert_true(bitpool_next_free(b, 5001) == n - 1, "next last");
+
+    const size_t order[] = {3, 64, 4095, 5000, n - 1};
+    for (size_t i=0; i < 5; i++){
+        assert_true(bitpool_alloc(b) == order[i], "alloc lowest");
+    }
+    assert_true(bitpool_isfull(b), "full again");
+
+    free(b);
+}
+
+static void test_run()
+{
+    puts("bitpool/test_run");
+
+    const size_t n = 1000;
+    BitPool *b = setup(n);
+
+    assert_true(bitpool_alloc_run(b, 0) == BITPOOL_NIL, "run 0");
+    assert_true(bitpool_alloc_run(b, n + 1) == BITPOOL_NIL, "run too long");
+    assert_true(bitpool_alloc_run(b, 10) == 0, "run 10");
+    assert_true(bitpool_alloc_run(b, 100) == 10, "run 100");
+    assert_true(bitpool_alloc(b) == 110, "alloc after runs");
+    assert_true(bitpool_len(b) == 111, "len");
+
+    /* a hole of 5 at 20 is skipped by a run of 6 */
+    assert_true(bitpool_free_run(b, 20, 5), "free run");
+    assert_false(bitpool_free_run(b, 22, 5), "free run with free slots");
+    assert_false(bitpool_free_run(b, 990, 11), "free run out of range");
+    assert_true(bitpool_alloc_run(b, 6) == 111, "skip the hole");
+    assert_true(bitpool_alloc_run(b, 5) == 20, "fill the hole");
+
+    /* runs across words and the AVX2 scan */
+    assert_true(bitpool_alloc_run(b, 500) == 117, "long run");
+    assert_true(bitpool_alloc_run(b, 383) == 617, "to the end");
+    assert_true(bitpool_isfull(b), "full");
+
+    assert_true(bitpool_free_run(b, 200, 300), "free middle");
+    assert_true(bitpool_free(b, 350) == false, "already free");
+    assert_true(bitpool_alloc(b) == 200, "alloc in middle");
+    assert_true(bitpool_alloc_run(b, 300) == BITPOOL_NIL, "no run");
+    assert_true(bitpool_alloc_run(b, 299) == 201, "run of the rest");
+    assert_true(bitpool_isfull(b), "full again");
+
+    free(b);
+}
+
+static void test_random()
+{
+    puts("bitpool/test_random");
+
+    /* compare with a plain array */
+    const size_t n = 5000;
+    BitPool *b = setup(n);
+    bool *used = calloc(n, sizeof(bool));
+    uint64_t x = 88172645463325252ULL;
+
+    for (size_t step=0; step < 20000; step++){
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        size_t k = 1 + (size_t)(x % 70);
+        size_t s = (size_t)((x >> 20) % n);
+
+        if (x & (1u << 8)){
+            size_t r = bitpool_alloc_run(b, k);
+            /* the first run of k free slots */
+            size_t expect = BITPOOL_NIL;
+            for (size_t i=0, cnt=0; i < n; i++){
+                cnt = used[i]?0:cnt + 1;
+                if (cnt == k){
+                    expect = i + 1 - k;
+                    break;
+                }
+            }
+            assert_true(r == expect, "alloc run as array");
+            for (size_t i=0; r != BITPOOL_NIL && i < k; i++){
+                used[r + i] = true;
+            }
+        } else {
+            bool all = (s + k <= n);
+            for (size_t i=0; all && i < k; i++){
+                all = used[s + i];
+            }
+            assert_true(bitpool_free_run(b, s, k) == all, "free run as array");
+            for (size_t i=0; all && i < k; i++){
+                used[s + i] = false;
+            }
+        }
+    }
+    for (size_t i=0; i < n; i++){
+        assert_true(bitpool_isfree(b, i) == !used[i], "same state");
+    }
+
+    free(used);
+    free(b);
+}
+
+int main()
+{
+    test_init();
+    test_alloc();
+    test_run();
+    test_random();
+
+    puts("OK");
+    return 0;
+}
@@ -0,0 +1,281 @@
+/* Test Concurrent Single Linked List */
+
+#define _POSIX_C_SOURCE 200809L
+
+#define DS_IMPLEMENTATION
+#include "cslist.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define MAGIC 0x5ca1ab1e
+#define WRITERS 2
+#define READERS 2
+#define VALUES 64      /* values per writer */
+#define ITERATIONS 20000
+
+typedef struct {
+    int magic;
+    int writer;
+} Value;
+
+static
+void test_init()
+{
+    puts("cslist/test_init");
+    const size_t N = 5;
+    uint8_t *arena = (uint8_t*)malloc(CSLIST_SIZEOF(N, 1));
+    CSList *list;
+
+    list = cslist_init(NULL, N, 1);
+    assert_true(list == NULL, "arena null");
+    list = cslist_init(arena, 0, 1);
+    assert_true(list == NULL, "size zero");
+    list = cslist_init(arena, N, 0);
+    assert_true(list == NULL, "threads zero");
+
+    list = cslist_init(arena, N, 1);
+    assert_true(list != NULL, "init");
+    assert_true(cslist_len(list) == 0, "init len");
+    assert_true(cslist_thread(list, 1) == NULL, "thread out of range");
+    assert_true(cslist_thread(list, 0) != NULL, "thread");
+    free(arena);
+
+    /* every record on its own cache lines */
+    arena = (uint8_t*)malloc(CSLIST_SIZEOF(N, 3));
+    list = cslist_init(arena, N, 3);
+    for (size_t i=0; i < 3; i++){
+        assert_true(((uintptr_t)cslist_thread(list, i) - (uintptr_t)arena)
+                    % CSLIST_CACHELINE == 0, "record offset");
+    }
+
+    free(arena);
+}
+
+static
+void test_single()
+{
+    puts("cslist/test_single");
+    const size_t N = 5;
+    uint8_t *arena = (uint8_t*)malloc(CSLIST_SIZEOF(N, 1));
+    CSList *list = cslist_init(arena, N, 1);
+    CSListThread *t = cslist_thread(list, 0);
+    CSListIter it;
+    int v[5];
+
+    for (size_t i=0; i < N; i++){
+        assert_true(cslist_insert(t, &v[i]), "insert");
+    }
+    assert_false(cslist_insert(t, &v[0]), "insert full");
+    assert_true(cslist_len(list) == N, "len");
+
+    /* prepended: reversed order */
+    cslist_enter(t);
+    int i = (int)N - 1;
+    for (int *x = cslist_iter(&it, list); x != NULL; x = cslist_value(it)){
+        assert_true(x == &v[i], "iter order");
+        i--;
+        cslist_next(&it);
+    }
+    assert_true(i == -1, "iter count");
+    cslist_leave(t);
+
+    /* delete head, middle and tail */
+    assert_true(cslist_delete(t, &v[4]), "delete head");
+    assert_true(cslist_delete(t, &v[2]), "delete middle");
+    assert_true(cslist_delete(t, &v[0]), "delete tail");
+    assert_false(cslist_delete(t, &v[0]), "delete missing");
+    assert_true(cslist_len(list) == 2, "len after delete");
+    assert_true(cslist_contains(t, &v[1]), "contains");
+    assert_false(cslist_contains(t, &v[2]), "not contains");
+
+    /* the deleted items come back after the grace period */
+    bool reused = false;
+    for (int k=0; k < 10 && !reused; k++){
+        cslist_enter(t);
+        cslist_leave(t);
+        reused = cslist_insert(t, &v[2]);
+    }
+    assert_true(reused, "reuse");
+
+    /* nested critical sections: insert and delete during a traversal */
+    cslist_enter(t);
+    cslist_iter(&it, list);
+    assert_true(cslist_delete(t, &v[3]), "delete in traversal");
+    assert_true(cslist_value(it) == &v[2], "iterator after delete");
+    assert_true(cslist_next(&it), "next after delete");
+    assert_true(cslist_value(it) == &v[1], "skip deleted");
+    cslist_leave(t);
+
+    free(arena);
+}
+
+static
+void test_full()
+{
+    puts("cslist/test_full");
+    const size_t N = 4;
+    uint8_t *arena = (uint8_t*)malloc(CSLIST_SIZEOF(N, 1));
+    CSList *list = cslist_init(arena, N, 1);
+    CSListThread *t = cslist_thread(list, 0);
+    int v[5];
+
+    for (size_t i=0; i < N; i++){
+        assert_true(cslist_insert(t, &v[i]), "insert");
+    }
+    for (int k=0; k < 1000; k++){
+        assert_false(cslist_insert(t, &v[4]), "insert full");
+    }
+    assert_true(list->used == N, "used stops at the capacity");
+
+    /* the deleted item comes back, then the list is full again */
+    assert_true(cslist_delete(t, &v[1]), "delete");
+    bool reused = false;
+    for (int k=0; k < 10 && !reused; k++){
+        cslist_enter(t);
+        cslist_leave(t);
+        reused = cslist_insert(t, &v[4]);
+    }
+    assert_true(reused, "reuse");
+    assert_true(cslist_contains(t, &v[4]), "contains");
+    assert_false(cslist_insert(t, &v[1]), "full again");
+    assert_true(cslist_len(list) == N, "len");
+    assert_true(list->used == N, "used");
+
+    free(arena);
+}
+
+struct Shared {
+    CSList *list;
+    Value values[WRITERS][VALUES];
+    bool done;
+};
+
+struct Worker {
+    struct Shared *shared;
+    size_t id;      /* thread record */
+    int writer;     /* index of the values, -1 for readers */
+    bool live[VALUES];
+};
+
+static
+void * writer_main(void *arg)
+{
+    struct Worker *w = arg;
+    CSListThread *t = cslist_thread(w->shared->list, w->id);
+    unsigned seed = (unsigned)w->id;
+
+    for (int i=0; i < ITERATIONS; i++){
+        int k = rand_r(&seed) % VALUES;
+        Value *v = &w->shared->values[w->writer][k];
+
+        if (w->live[k]){
+            assert_true(cslist_delete(t, v), "stress delete");
+            w->live[k] = false;
+        } else {
+            /* the retired items are back after the readers move on */
+            while (!cslist_insert(t, v)){
+                sched_yield();
+            }
+            w->live[k] = true;
+        }
+    }
+
+    return NULL;
+}
+
+static
+void * reader_main(void *arg)
+{
+    struct Worker *w = arg;
+    struct Shared *s = w->shared;
+    CSListThread *t = cslist_thread(s->list, w->id);
+
+    while (!__atomic_load_n(&s->done, __ATOMIC_ACQUIRE)){
+        CSListIter it;
+        cslist_enter(t);
+        for (Value *v = cslist_iter(&it, s->list); v != NULL; v = cslist_value(it)){
+            /* a reused item would still point to a value, check the range */
+            assert_true(v >= &s->values[0][0], "stress value range");
+            assert_true(v <= &s->values[WRITERS-1][VALUES-1], "stress value range");
+            assert_true(v->magic == MAGIC, "stress value magic");
+            cslist_next(&it);
+        }
+        cslist_leave(t);
+    }
+
+    return NULL;
+}
+
+static
+void test_stress()
+{
+    puts("cslist/test_stress");
+    const size_t N = WRITERS * VALUES * 4;
+    const size_t T = WRITERS + READERS;
+    uint8_t *arena = (uint8_t*)malloc(CSLIST_SIZEOF(N, T));
+    struct Shared *s = (struct Shared*)calloc(1, sizeof(struct Shared));
+    struct Worker workers[WRITERS + READERS];
+    pthread_t threads[WRITERS + READERS];
+
+    s->list = cslist_init(arena, N, T);
+    for (int i=0; i < WRITERS; i++){
+        for (int k=0; k < VALUES; k++){
+            s->values[i][k].magic = MAGIC;
+            s->values[i][k].writer = i;
+        }
+    }
+
+    for (size_t i=0; i < T; i++){
+        workers[i].shared = s;
+        workers[i].id = i;
+        workers[i].writer = (i < WRITERS)?(int)i:-1;
+        for (int k=0; k < VALUES; k++){
+            workers[i].live[k] = false;
+        }
+    }
+
+    for (size_t i=0; i < T; i++){
+        void *(*fn)(void*) = (i < WRITERS)?writer_main:reader_main;
+        int rc = pthread_create(&threads[i], NULL, fn, &workers[i]);
+        assert_true(rc == 0, "thread create");
+    }
+    for (size_t i=0; i < WRITERS; i++){
+        pthread_join(threads[i], NULL);
+    }
+    __atomic_store_n(&s->done, true, __ATOMIC_RELEASE);
+    for (size_t i=WRITERS; i < T; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    /* the list content matches what the writers think */
+    CSListThread *t = cslist_thread(s->list, 0);
+    size_t live = 0;
+    for (int i=0; i < WRITERS; i++){
+        for (int k=0; k < VALUES; k++){
+            bool in = cslist_contains(t, &s->values[i][k]);
+            assert_true(in == workers[i].live[k], "stress content");
+            live += in?1:0;
+        }
+    }
+    assert_true(cslist_len(s->list) == live, "stress len");
+
+    free(s);
+    free(arena);
+}
+
+int main()
+{
+    test_init();
+    test_single();
+    test_full();
+    test_stress();
+
+    puts("OK");
+
+    return 0;
+}
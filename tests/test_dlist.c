@@ -0,0 +1,206 @@
+/* Test Doubly Linked List */
+
+#define DS_IMPLEMENTATION
+#include "dlist.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 5
+
+static
+DList * setup()
+{
+    uint8_t *arena = (uint8_t*)malloc(DLIST_SIZEOF(N));
+    DList *list = dlist_init(arena, N);
+    return list;
+}
+
+static
+void teardown(DList *list)
+{
+    free(list);
+}
+
+/* check the list content in both directions */
+static
+void assert_content(DList *list, int *v, const int *expected, size_t len)
+{
+    assert_true(dlist_len(list) == len, "content len");
+
+    size_t item = dlist_first(list);
+    for (size_t i=0; i < len; i++){
+        assert_true(dlist_value(list, item) == &v[expected[i]], "forward");
+        item = dlist_next(list, item);
+    }
+    assert_true(item == DLIST_NIL, "forward end");
+
+    item = dlist_last(list);
+    for (size_t i=len; i > 0; i--){
+        assert_true(dlist_value(list, item) == &v[expected[i-1]], "backward");
+        item = dlist_prev(list, item);
+    }
+    assert_true(item == DLIST_NIL, "backward end");
+}
+
+static
+void test_init()
+{
+    puts("dlist/test_init");
+    uint8_t *arena = (uint8_t*)malloc(DLIST_SIZEOF(N));
+    DList *list;
+
+    list = dlist_init(NULL, N);
+    assert_true(list == NULL, "arena null");
+
+    list = dlist_init(arena, 0);
+    assert_true(list == NULL, "size zero");
+
+    list = dlist_init(arena, N);
+    assert_true(list != NULL, "dlist init");
+    assert_true(dlist_isempty(list), "dlist init empty");
+    assert_false(dlist_isfull(list), "dlist init full");
+    assert_true(dlist_first(list) == DLIST_NIL, "dlist init first");
+    assert_true(dlist_last(list) == DLIST_NIL, "dlist init last");
+    assert_true(dlist_pop_front(list) == NULL, "dlist init pop");
+
+    free(arena);
+}
+
+static
+void test_push_pop()
+{
+    puts("dlist/test_push_pop");
+    DList *list = setup();
+    int v[N];
+
+    /* [2,1,0,3,4] */
+    assert_true(dlist_push_back(list, &v[0]) != DLIST_NIL, "push back");
+    assert_true(dlist_push_front(list, &v[1]) != DLIST_NIL, "push front");
+    assert_true(dlist_push_front(list, &v[2]) != DLIST_NIL, "push front");
+    assert_true(dlist_push_back(list, &v[3]) != DLIST_NIL, "push back");
+    assert_true(dlist_push_back(list, &v[4]) != DLIST_NIL, "push back");
+    assert_true(dlist_isfull(list), "full");
+    assert_true(dlist_push_back(list, &v[0]) == DLIST_NIL, "push full");
+
+    const int e[] = {2, 1, 0, 3, 4};
+    assert_content(list, v, e, N);
+
+    assert_true(dlist_pop_front(list) == &v[2], "pop front");
+    assert_true(dlist_pop_back(list) == &v[4], "pop back");
+    assert_true(dlist_pop_back(list) == &v[3], "pop back");
+    assert_true(dlist_pop_front(list) == &v[1], "pop front");
+    assert_true(dlist_pop_front(list) == &v[0], "pop front");
+    assert_true(dlist_isempty(list), "empty");
+    assert_true(dlist_first(list) == DLIST_NIL, "empty first");
+    assert_true(dlist_last(list) == DLIST_NIL, "empty last");
+
+    teardown(list);
+}
+
+static
+void test_handle()
+{
+    puts("dlist/test_handle");
+    DList *list = setup();
+    int v[N];
+    size_t h[N];
+
+    for (size_t i=0; i < N; i++){
+        h[i] = dlist_push_back(list, &v[i]);
+    }
+
+    /* remove by handle, middle, head and tail */
+    assert_true(dlist_remove(list, h[2]) == &v[2], "remove middle");
+    const int e1[] = {0, 1, 3, 4};
+    assert_content(list, v, e1, 4);
+
+    assert_true(dlist_remove(list, h[0]) == &v[0], "remove head");
+    assert_true(dlist_remove(list, h[4]) == &v[4], "remove tail");
+    const int e2[] = {1, 3};
+    assert_content(list, v, e2, 2);
+
+    /* the released items are reused */
+    h[0] = dlist_insert(list, h[3], &v[0]);
+    assert_true(h[0] != DLIST_NIL, "insert before");
+    h[2] = dlist_insert(list, h[3], &v[2]);
+    h[4] = dlist_push_back(list, &v[4]);
+    assert_true(dlist_isfull(list), "full again");
+    const int e3[] = {1, 0, 2, 3, 4};
+    assert_content(list, v, e3, N);
+
+    /* move to front and back */
+    dlist_move_front(list, h[3]);
+    const int e4[] = {3, 1, 0, 2, 4};
+    assert_content(list, v, e4, N);
+
+    dlist_move_front(list, h[3]);
+    dlist_move_front(list, h[4]);
+    const int e5[] = {4, 3, 1, 0, 2};
+    assert_content(list, v, e5, N);
+
+    dlist_move_back(list, h[4]);
+    dlist_move_back(list, h[1]);
+    dlist_move_back(list, h[1]);
+    const int e6[] = {3, 0, 2, 4, 1};
+    assert_content(list, v, e6, N);
+
+    teardown(list);
+}
+
+static
+void test_random()
+{
+    puts("dlist/test_random");
+    const size_t M = 1024;
+    uint8_t *arena = (uint8_t*)malloc(DLIST_SIZEOF(M));
+    size_t *handles = (size_t*)calloc(M, sizeof(size_t));
+    DList *list = dlist_init(arena, M);
+    int v = 0;
+    size_t n = 0;
+
+    for (int i=0; i < 100 * (int)M; i++){
+        int op = rand() % 4;
+        if (op == 0 && n < M){
+            handles[n] = dlist_push_back(list, &v);
+            assert_true(handles[n] != DLIST_NIL, "random push");
+            n++;
+        } else if (op == 1 && n > 0){
+            size_t k = (size_t)rand() % n;
+            assert_true(dlist_remove(list, handles[k]) == &v, "random remove");
+            handles[k] = handles[--n];
+        } else if (n > 0){
+            dlist_move_front(list, handles[(size_t)rand() % n]);
+        }
+        assert_true(dlist_len(list) == n, "random len");
+    }
+
+    /* count in both directions */
+    size_t c = 0;
+    for (size_t i=dlist_first(list); i != DLIST_NIL; i=dlist_next(list, i)){
+        c++;
+    }
+    assert_true(c == n, "random forward");
+    c = 0;
+    for (size_t i=dlist_last(list); i != DLIST_NIL; i=dlist_prev(list, i)){
+        c++;
+    }
+    assert_true(c == n, "random backward");
+
+    free(handles);
+    free(arena);
+}
+
+int main()
+{
+    test_init();
+    test_push_pop();
+    test_handle();
+    test_random();
+
+    puts("OK");
+
+    return 0;
+}
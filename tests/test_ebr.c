@@ -0,0 +1,301 @@
+/* Test Epoch Based Reclamation */
+
+#define _POSIX_C_SOURCE 200809L
+
+#define DS_IMPLEMENTATION
+#include "ebr.h"
+#include "objpool.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define MAGIC 0x5ca1ab1e
+#define WRITERS 2
+#define READERS 2
+#define SLOTS 16       /* shared pointers */
+#define ITERATIONS 20000
+#define LIMBO 64
+
+/* released items of the single thread tests */
+typedef struct {
+    size_t calls;
+    size_t items[64];
+    size_t n;
+} Released;
+
+static
+void record(const size_t *items, size_t n, void *ctx)
+{
+    Released *r = ctx;
+    r->calls++;
+    for (size_t i=0; i < n; i++){
+        r->items[r->n++] = items[i];
+    }
+}
+
+static
+void test_init()
+{
+    puts("ebr/test_init");
+    Released r = {0};
+    uint8_t *arena = (uint8_t*)malloc(EBR_SIZEOF(2, 4));
+
+    assert_true(ebr_init(NULL, 2, 4, record, &r) == NULL, "arena null");
+    assert_true(ebr_init(arena, 0, 4, record, &r) == NULL, "threads zero");
+    assert_true(ebr_init(arena, 2, 0, record, &r) == NULL, "limbo zero");
+    assert_true(ebr_init(arena, 2, 4, NULL, &r) == NULL, "release null");
+
+    EBR *ebr = ebr_init(arena, 2, 4, record, &r);
+    assert_true(ebr != NULL, "init");
+    assert_true(ebr_thread(ebr, 2) == NULL, "thread out of range");
+    assert_true(ebr_thread(ebr, 1) != NULL, "thread");
+    assert_true(ebr_pending(ebr_thread(ebr, 0)) == 0, "nothing pending");
+    assert_true(((uintptr_t)ebr_thread(ebr, 1) - (uintptr_t)ebr_thread(ebr, 0))
+                % EBR_CACHELINE == 0, "record size");
+    assert_true(((uintptr_t)ebr_thread(ebr, 0) - (uintptr_t)ebr)
+                % EBR_CACHELINE == 0, "record offset");
+
+    free(arena);
+}
+
+static
+void test_single()
+{
+    puts("ebr/test_single");
+    Released r = {0};
+    uint8_t *arena = (uint8_t*)malloc(EBR_SIZEOF(2, 4));
+    EBR *ebr = ebr_init(arena, 2, 4, record, &r);
+    EBRThread *t = ebr_thread(ebr, 0);
+    EBRThread *o = ebr_thread(ebr, 1);
+
+    ebr_enter(t);
+    assert_true(ebr_retire(t, 7), "retire");
+    assert_true(ebr_retire(t, 8), "retire");
+    ebr_leave(t);
+    assert_true(ebr_pending(t) == 2, "pending");
+
+    /* the other thread in a critical section blocks the epoch */
+    ebr_enter(o);
+    ebr_advance(ebr);
+    ebr_enter(o);    /* nested */
+    ebr_leave(o);
+    for (int k=0; k < 5; k++){
+        ebr_advance(ebr);
+        ebr_enter(t);
+        ebr_leave(t);
+    }
+    assert_true(ebr->epoch == 1, "blocked");
+    assert_true(r.n == 0, "not released");
+    ebr_leave(o);
+
+    /* released in one batch three epochs after the retire (epoch 0) */
+    ebr_advance(ebr);
+    ebr_enter(t);
+    ebr_leave(t);
+    assert_true(ebr->epoch == 2 && r.n == 0, "not yet");
+    ebr_advance(ebr);
+    ebr_enter(t);
+    ebr_leave(t);
+    assert_true(r.calls == 1 && r.n == 2, "released");
+    assert_true(r.items[0] == 7 && r.items[1] == 8, "items");
+    assert_true(ebr_pending(t) == 0 && t->released == 2, "counters");
+
+    /* the bucket is full */
+    ebr_enter(t);
+    for (size_t i=0; i < 4; i++){
+        assert_true(ebr_retire(t, i), "fill");
+    }
+    assert_false(ebr_retire(t, 4), "full");
+    ebr_leave(t);
+
+    /* a long absence releases all the buckets */
+    ebr_enter(t);
+    ebr_advance(ebr);
+    ebr_leave(t);
+    ebr_enter(t);
+    assert_true(ebr_retire(t, 4), "next epoch");
+    ebr_leave(t);
+    for (int k=0; k < 4; k++){
+        ebr_advance(ebr);
+    }
+    ebr_enter(t);
+    ebr_leave(t);
+    assert_true(r.n == 7 && ebr_pending(t) == 0, "all released");
+
+    /* drain at the shutdown */
+    ebr_enter(o);
+    assert_true(ebr_retire(o, 9), "retire other");
+    ebr_leave(o);
+    ebr_drain(ebr);
+    assert_true(r.n == 8 && r.items[7] == 9, "drained");
+
+    free(arena);
+}
+
+typedef struct {
+    int magic;
+    int writer;
+} Obj;
+
+struct Shared {
+    EBR *ebr;
+    ObjPool pool;
+    pthread_mutex_t lock; /* the pool is not thread safe */
+    Obj *slots[SLOTS];
+    bool done;
+};
+
+struct Worker {
+    struct Shared *shared;
+    size_t id;      /* thread record */
+    int writer;     /* -1 for readers */
+};
+
+/* return the batch to the pool, poisoned */
+static
+void release_objs(const size_t *items, size_t n, void *ctx)
+{
+    struct Shared *s = ctx;
+
+    pthread_mutex_lock(&s->lock);
+    for (size_t i=0; i < n; i++){
+        Obj *o = objpool_at(&s->pool, items[i]);
+        o->magic = 0;
+        objpool_release(&s->pool, o);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+static
+Obj * acquire_obj(struct Shared *s, int writer)
+{
+    pthread_mutex_lock(&s->lock);
+    Obj *o = objpool_acquire(&s->pool);
+    pthread_mutex_unlock(&s->lock);
+    if (o != NULL){
+        o->magic = MAGIC;
+        o->writer = writer;
+    }
+    return o;
+}
+
+static
+void * writer_main(void *arg)
+{
+    struct Worker *w = arg;
+    struct Shared *s = w->shared;
+    EBRThread *t = ebr_thread(s->ebr, w->id);
+    unsigned seed = (unsigned)w->id;
+
+    for (int i=0; i < ITERATIONS; i++){
+        Obj *o;
+        /* the retired objects are back after the readers move on */
+        while ((o = acquire_obj(s, w->writer)) == NULL){
+            ebr_enter(t);
+            ebr_advance(s->ebr);
+            ebr_leave(t);
+            sched_yield();
+        }
+
+        int k = rand_r(&seed) % SLOTS;
+        ebr_enter(t);
+        Obj *old = __atomic_exchange_n(&s->slots[k], o, __ATOMIC_ACQ_REL);
+        while (!ebr_retire(t, objpool_index(&s->pool, old))){
+            ebr_leave(t);
+            sched_yield();
+            ebr_enter(t);
+        }
+        ebr_leave(t);
+    }
+
+    return NULL;
+}
+
+static
+void * reader_main(void *arg)
+{
+    struct Worker *w = arg;
+    struct Shared *s = w->shared;
+    EBRThread *t = ebr_thread(s->ebr, w->id);
+
+    while (!__atomic_load_n(&s->done, __ATOMIC_ACQUIRE)){
+        ebr_enter(t);
+        for (int k=0; k < SLOTS; k++){
+            Obj *o = __atomic_load_n(&s->slots[k], __ATOMIC_ACQUIRE);
+            assert_true(o->magic == MAGIC, "stress magic");
+            sched_yield();
+            assert_true(o->magic == MAGIC, "stress magic after yield");
+        }
+        ebr_leave(t);
+    }
+
+    return NULL;
+}
+
+static
+void test_stress()
+{
+    puts("ebr/test_stress");
+    const size_t T = WRITERS + READERS;
+    const size_t N = SLOTS + T * EBR_BUCKETS * LIMBO;
+    uint8_t *arena = (uint8_t*)malloc(EBR_SIZEOF(T, LIMBO));
+    uint8_t *objs = (uint8_t*)malloc(OBJPOOL_SIZEOF(N, sizeof(Obj)));
+    struct Shared *s = (struct Shared*)calloc(1, sizeof(struct Shared));
+    struct Worker workers[WRITERS + READERS];
+    pthread_t threads[WRITERS + READERS];
+
+    s->ebr = ebr_init(arena, T, LIMBO, release_objs, s);
+    objpool_init(&s->pool, objs, N, sizeof(Obj));
+    pthread_mutex_init(&s->lock, NULL);
+    for (int k=0; k < SLOTS; k++){
+        s->slots[k] = acquire_obj(s, -1);
+    }
+
+    for (size_t i=0; i < T; i++){
+        workers[i].shared = s;
+        workers[i].id = i;
+        workers[i].writer = (i < WRITERS)?(int)i:-1;
+    }
+
+    for (size_t i=0; i < T; i++){
+        void *(*fn)(void*) = (i < WRITERS)?writer_main:reader_main;
+        int rc = pthread_create(&threads[i], NULL, fn, &workers[i]);
+        assert_true(rc == 0, "thread create");
+    }
+    for (size_t i=0; i < WRITERS; i++){
+        pthread_join(threads[i], NULL);
+    }
+    __atomic_store_n(&s->done, true, __ATOMIC_RELEASE);
+    for (size_t i=WRITERS; i < T; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    /* every replaced object is back in the pool */
+    size_t released = 0;
+    for (size_t i=0; i < T; i++){
+        released += ebr_thread(s->ebr, i)->released;
+    }
+    assert_true(released > 0, "released during the run");
+    ebr_drain(s->ebr);
+    assert_true(s->pool.len == SLOTS, "pool len");
+
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+    free(objs);
+    free(arena);
+}
+
+int main()
+{
+    test_init();
+    test_single();
+    test_stress();
+
+    puts("OK");
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/* Test Hash Index */
+
+#define DS_IMPLEMENTATION
+#include "hashidx.h"
+#include "objpool.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 1000
+
+typedef struct {
+    uint64_t key;
+    uint64_t payload;
+} Obj;
+
+/* the value is the index of the object in the pool */
+static bool match_obj(size_t value, const void *key, void *ctx)
+{
+    Obj *obj = objpool_at((ObjPool*)ctx, value);
+    return obj->key == *(const uint64_t*)key;
+}
+
+/* the value is the key itself */
+static bool match_value(size_t value, const void *key, void *ctx)
+{
+    (void)ctx;
+    return value == *(const size_t*)key;
+}
+
+static void test_init()
+{
+    puts("hashidx/test_init");
+
+    assert_true(hashidx_slots(0) == HASHIDX_GROUP, "slots min");
+    assert_true(hashidx_slots(14) == HASHIDX_GROUP, "slots 14");
+    assert_true(hashidx_slots(15) == 2 * HASHIDX_GROUP, "slots 15");
+    assert_true(hashidx_slots(N) == 2048, "slots N");
+    assert_true(hashidx_slots(SIZE_MAX / 2) == 0, "slots too big");
+
+    void *arena = malloc(HASHIDX_SIZEOF(64));
+    assert_true(hashidx_init(NULL, 64) == NULL, "arena null");
+    assert_true(hashidx_init(arena, 8) == NULL, "less than a group");
+    assert_true(hashidx_init(arena, 48) == NULL, "not a power of 2");
+
+    HashIdx *h = hashidx_init(arena, 64);
+    assert_true(h != NULL, "init");
+    assert_true(hashidx_len(h) == 0, "empty");
+    assert_false(hashidx_isfull(h), "not full");
+
+    size_t key = 1;
+    assert_true(hashidx_find(h, 1, &key, match_value, NULL) == HASHIDX_NIL,
+                "find in empty");
+    assert_false(hashidx_insert(h, 1, HASHIDX_NIL), "insert nil");
+
+    assert_true(hashidx_len(NULL) == 0, "len null");
+    assert_true(hashidx_isfull(NULL), "isfull null");
+    assert_false(hashidx_insert(NULL, 1, 1), "insert null");
+    assert_true(hashidx_find(NULL, 1, &key, match_value, NULL) == HASHIDX_NIL,
+                "find null");
+
+    free(arena);
+}
+
+static void test_objpool()
+{
+    puts("hashidx/test_objpool");
+
+    ObjPool pool;
+    objpool_init(&pool, malloc(OBJPOOL_SIZEOF(N, sizeof(Obj))), N,
+                 sizeof(Obj));
+    size_t slots = hashidx_slots(N);
+    HashIdx *h = hashidx_init(malloc(HASHIDX_SIZEOF(slots)), slots);
+
+    for (uint64_t k=0; k < N; k++){
+        Obj *obj = objpool_acquire(&pool);
+        obj->key = k * 7919;
+        obj->payload = k;
+        assert_true(hashidx_insert(h, hashidx_mix64(obj->key),
+                                   objpool_index(&pool, obj)), "insert");
+    }
+    assert_true(hashidx_len(h) == N, "len");
+
+    for (uint64_t k=0; k < N; k++){
+        uint64_t key = k * 7919;
+        size_t i = hashidx_find(h, hashidx_mix64(key), &key, match_obj, &pool);
+        assert_true(i != HASHIDX_NIL, "find");
+        assert_true(((Obj*)objpool_at(&pool, i))->payload == k, "payload");
+    }
+    uint64_t missing = 1;
+    assert_true(hashidx_find(h, hashidx_mix64(missing), &missing, match_obj,
+                             &pool) == HASHIDX_NIL, "find missing");
+
+    /* delete the even keys and release their objects */
+    for (uint64_t k=0; k < N; k += 2){
+        uint64_t key = k * 7919;
+        size_t i = hashidx_delete(h, hashidx_mix64(key), &key, match_obj,
+                                  &pool);
+        assert_true(i != HASHIDX_NIL, "delete");
+        objpool_release(&pool, objpool_at(&pool, i));
+        assert_true(hashidx_delete(h, hashidx_mix64(key), &key, match_obj,
+                                   &pool) == HASHIDX_NIL, "delete twice");
+    }
+    assert_true(hashidx_len(h) == N / 2, "len after delete");
+
+    for (uint64_t k=0; k < N; k++){
+        uint64_t key = k * 7919;
+        size_t i = hashidx_find(h, hashidx_mix64(key), &key, match_obj, &pool);
+        assert_true((i == HASHIDX_NIL) == (k % 2 == 0), "find after delete");
+    }
+
+    /* iterate the odd keys */
+    size_t pos = 0;
+    size_t cnt = 0;
+    for (size_t i = hashidx_next(h, &pos); i != HASHIDX_NIL;
+         i = hashidx_next(h, &pos)){
+        assert_true(((Obj*)objpool_at(&pool, i))->payload % 2 == 1, "next");
+        cnt++;
+    }
+    assert_true(cnt == N / 2, "next count");
+
+    free(h);
+    free(pool.blocks);
+}
+
+static void test_collisions()
+{
+    puts("hashidx/test_collisions");
+
+    /* same hash for every value: the probe crosses all the groups */
+    const size_t slots = 64;
+    HashIdx *h = hashidx_init(malloc(HASHIDX_SIZEOF(slots)), slots);
+    size_t max = slots - slots / 8;
+
+    for (size_t v=0; v < max; v++){
+        assert_true(hashidx_insert(h, 42, v), "insert");
+    }
+    assert_true(hashidx_isfull(h), "full");
+    assert_false(hashidx_insert(h, 42, max), "insert in full");
+
+    for (size_t v=0; v < max; v++){
+        assert_true(hashidx_find(h, 42, &v, match_value, NULL) == v, "find");
+    }
+
+    /* the first groups have been full: their slots become tombstones */
+    for (size_t v=0; v < HASHIDX_GROUP; v++){
+        assert_true(hashidx_delete(h, 42, &v, match_value, NULL) == v,
+                    "delete");
+    }
+    assert_true(h->tombs == HASHIDX_GROUP, "tombstones");
+    assert_true(hashidx_isfull(h), "tombstones count in load");
+
+    /* the probe goes beyond the tombstones */
+    for (size_t v=HASHIDX_GROUP; v < max; v++){
+        assert_true(hashidx_find(h, 42, &v, match_value, NULL) == v,
+                    "find beyond tombstones");
+    }
+
+    /* the last group has never been full: the slot is empty again */
+    size_t last = max - 1;
+    assert_true(hashidx_delete(h, 42, &last, match_value, NULL) == last,
+                "delete last");
+    assert_true(h->tombs == HASHIDX_GROUP, "no tombstone");
+
+    /* insert reuses the tombstones */
+    assert_true(hashidx_insert(h, 42, 1000), "insert in tombstone");
+    assert_true(h->tombs == HASHIDX_GROUP - 1, "tombstone reused");
+    size_t key = 1000;
+    assert_true(hashidx_find(h, 42, &key, match_value, NULL) == key,
+                "find reused");
+
+    hashidx_clear(h);
+    assert_true(hashidx_len(h) == 0 && h->tombs == 0, "clear");
+    assert_true(hashidx_find(h, 42, &key, match_value, NULL) == HASHIDX_NIL,
+                "find after clear");
+
+    free(h);
+}
+
+static void test_fingerprints()
+{
+    puts("hashidx/test_fingerprints");
+
+    /* same fingerprint, different hashes */
+    const size_t slots = 32;
+    HashIdx *h = hashidx_init(malloc(HASHIDX_SIZEOF(slots)), slots);
+
+    for (size_t v=0; v < 20; v++){
+        assert_true(hashidx_insert(h, (v << 7) | 5, v), "insert");
+    }
+    for (size_t v=0; v < 20; v++){
+        assert_true(hashidx_find(h, (v << 7) | 5, &v, match_value, NULL) == v,
+                    "find");
+        size_t other = v + 100;
+        assert_true(hashidx_find(h, (v << 7) | 5, &other, match_value,
+                                 NULL) == HASHIDX_NIL, "match rejects");
+    }
+
+    free(h);
+}
+
+int main()
+{
+    test_init();
+    test_objpool();
+    test_collisions();
+    test_fingerprints();
+
+    puts("OK");
+    return 0;
+}
@@ -0,0 +1,196 @@
+/* Test Heap index */
+
+#define DS_IMPLEMENTATION
+#include "heap.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 1000
+
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/* pop all, the keys must come in ascending order */
+static void check_sorted(HeapIndex *h, const int *keys, size_t n)
+{
+    int prev = 0;
+    for (size_t i=0; i < n; i++){
+        size_t id = heap_pop(h);
+        assert_true(id != HEAP_NIL, "pop");
+        assert_false(heap_contains(h, id), "popped");
+        assert_true(i == 0 || keys[id] >= prev, "ascending");
+        prev = keys[id];
+    }
+    assert_true(heap_isempty(h), "empty");
+    assert_true(heap_pop(h) == HEAP_NIL, "pop empty");
+}
+
+static void test_init()
+{
+    puts("heap/test_init");
+
+    int keys[4] = {0};
+    void *arena = malloc(HEAP_SIZEOF(4));
+
+    assert_true(heap_init(NULL, 4, keys, sizeof(int), cmp_int) == NULL,
+                "arena null");
+    assert_true(heap_init(arena, 0, keys, sizeof(int), cmp_int) == NULL,
+                "capacity 0");
+    assert_true(heap_init(arena, 4, NULL, sizeof(int), cmp_int) == NULL,
+                "keys null");
+    assert_true(heap_init(arena, 4, keys, 0, cmp_int) == NULL, "keysize 0");
+    assert_true(heap_init(arena, 4, keys, sizeof(int), NULL) == NULL,
+                "cmp null");
+
+    HeapIndex *h = heap_init(arena, 4, keys, sizeof(int), cmp_int);
+    assert_true(h != NULL, "init");
+    assert_true(heap_isempty(h), "empty");
+    assert_true(heap_top(h) == HEAP_NIL, "top empty");
+    assert_false(heap_push(h, 4), "push out of range");
+    assert_true(heap_push(h, 1), "push");
+    assert_false(heap_push(h, 1), "push twice");
+    assert_false(heap_remove(h, 2), "remove absent");
+    assert_false(heap_update(h, 2), "update absent");
+    assert_true(heap_top(h) == 1, "top");
+
+    assert_true(heap_len(NULL) == 0, "len null");
+    assert_false(heap_push(NULL, 0), "push null");
+    assert_true(heap_pop(NULL) == HEAP_NIL, "pop null");
+    assert_false(heap_heapify(h, 5), "heapify too many");
+
+    free(arena);
+}
+
+static void test_push_pop()
+{
+    puts("heap/test_push_pop");
+
+    static int keys[N];
+    HeapIndex *h = heap_init(malloc(HEAP_SIZEOF(N)), N, keys, sizeof(int),
+                             cmp_int);
+    srand(7);
+    for (size_t i=0; i < N; i++){
+        keys[i] = rand() % 500; /* with duplicates */
+        assert_true(heap_push(h, i), "push");
+    }
+    assert_true(heap_len(h) == N, "len");
+    check_sorted(h, keys, N);
+
+    free(h);
+}
+
+static void test_update()
+{
+    puts("heap/test_update");
+
+    static int keys[N];
+    HeapIndex *h = heap_init(malloc(HEAP_SIZEOF(N)), N, keys, sizeof(int),
+                             cmp_int);
+    for (size_t i=0; i < N; i++){
+        keys[i] = (int)(i * 7919 % N) + 10;
+    }
+    assert_true(heap_heapify(h, N), "heapify");
+    assert_true(heap_len(h) == N, "len");
+    assert_true(keys[heap_top(h)] == 10, "top after heapify");
+
+    /* decrease-key to the top */
+    keys[500] = 0;
+    assert_true(heap_update(h, 500), "decrease");
+    assert_true(heap_top(h) == 500, "decreased on top");
+
+    /* increase-key of the top */
+    keys[500] = 5000;
+    assert_true(heap_update(h, 500), "increase");
+    assert_true(heap_top(h) != 500, "increased down");
+
+    /* remove from the middle */
+    for (size_t i=0; i < N; i += 3){
+        assert_true(heap_remove(h, i), "remove");
+        assert_false(heap_contains(h, i), "removed");
+    }
+    assert_true(heap_len(h) == N - (N + 2) / 3, "len after remove");
+
+    size_t n = heap_len(h);
+    size_t last = HEAP_NIL;
+    for (size_t i=0; i < n; i++){
+        last = heap_pop(h);
+        assert_true(last % 3 != 0, "not removed");
+    }
+    assert_true(last == 500, "increased last");
+
+    /* heapify replaces the content */
+    heap_push(h, 3);
+    assert_true(heap_heapify(h, 10), "heapify again");
+    assert_false(heap_contains(h, 500), "replaced");
+    check_sorted(h, keys, 10);
+
+    free(h);
+}
+
+static void test_random()
+{
+    puts("heap/test_random");
+
+    /* mixed operations against a linear scan */
+    static int keys[N];
+    static bool in[N];
+    HeapIndex *h = heap_init(malloc(HEAP_SIZEOF(N)), N, keys, sizeof(int),
+                             cmp_int);
+    srand(11);
+    for (size_t step=0; step < 20000; step++){
+        size_t id = (size_t)rand() % N;
+        switch (rand() % 4){
+        case 0:
+            if (!in[id]){
+                keys[id] = rand() % 10000;
+            }
+            assert_true(heap_push(h, id) == !in[id], "push");
+            in[id] = true;
+            break;
+        case 1:
+            keys[id] = rand() % 10000;
+            assert_true(heap_update(h, id) == in[id], "update");
+            break;
+        case 2:
+            assert_true(heap_remove(h, id) == in[id], "remove");
+            in[id] = false;
+            break;
+        default: {
+            int least = 0;
+            bool any = false;
+            for (size_t i=0; i < N; i++){
+                if (in[i] && (!any || keys[i] < least)){
+                    least = keys[i];
+                    any = true;
+                }
+            }
+            size_t top = heap_pop(h);
+            assert_true(any == (top != HEAP_NIL), "pop empty");
+            if (any){
+                assert_true(keys[top] == least, "pop least");
+                in[top] = false;
+            }
+        }
+        }
+    }
+
+    free(h);
+}
+
+int main()
+{
+    test_init();
+    test_push_pop();
+    test_update();
+    test_random();
+
+    puts("OK");
+    return 0;
+}
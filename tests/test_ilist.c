@@ -0,0 +1,140 @@
+/* Test Intrusive Single Linked List */
+
+#define DS_IMPLEMENTATION
+#include "ilist.h"
+#include "objpool.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define N 5
+
+typedef struct {
+    int id;
+    IListLink link;
+    IListLink ready; /* the same object in a second list */
+} Job;
+
+static
+void test_init()
+{
+    puts("ilist/test_init");
+    Job jobs[N];
+    IList list;
+
+    assert_false(ilist_init(NULL, jobs, sizeof(Job), 0), "list null");
+    assert_false(ilist_init(&list, NULL, sizeof(Job), 0), "base null");
+    assert_false(ilist_init(&list, jobs, 0, 0), "stride zero");
+    assert_false(ilist_init(&list, jobs, sizeof(Job), sizeof(Job)), "offset");
+
+    assert_true(ILIST_INIT(&list, jobs, Job, link), "init");
+    assert_true(ilist_isempty(&list), "init empty");
+    assert_true(ilist_pop(&list) == NULL, "pop empty");
+
+    /* index and object conversion */
+    assert_true(ilist_object(&list, 3) == &jobs[3], "object");
+    assert_true(ilist_index(&list, &jobs[3]) == 3, "index");
+    assert_true(ilist_object(&list, ILIST_NIL) == NULL, "object nil");
+}
+
+static
+void test_list()
+{
+    puts("ilist/test_list");
+    Job jobs[N];
+    IList list, ready;
+    IListIter it;
+
+    ILIST_INIT(&list, jobs, Job, link);
+    ILIST_INIT(&ready, jobs, Job, ready);
+
+    /* append [0,1,2,3,4] */
+    ilist_iter(&it, &list);
+    for (int i=0; i < N; i++){
+        jobs[i].id = i;
+        assert_true(ilist_insert(&it, &jobs[i]), "insert");
+    }
+    assert_true(ilist_len(&list) == N, "len");
+
+    /* the even ones also in the second list, reversed */
+    for (int i=0; i < N; i += 2){
+        ilist_push(&ready, &jobs[i]);
+    }
+
+    int i = 0;
+    for (Job *j = ilist_iter(&it, &list); j != NULL; j = ilist_value(it)){
+        assert_true(j->id == i, "walk");
+        i++;
+        ilist_next(&it);
+    }
+    assert_true(i == N, "walk len");
+
+    /* delete the odd ones: [0,2,4] */
+    ilist_iter(&it, &list);
+    while (!ilist_exhausted(it)){
+        Job *j = ilist_value(it);
+        if (j->id % 2){
+            assert_true(ilist_delete(&it), "delete");
+        } else {
+            ilist_next(&it);
+        }
+    }
+    assert_true(ilist_len(&list) == 3, "delete len");
+
+    /* both lists have the same objects */
+    assert_true(ilist_pop(&ready) == &jobs[4], "pop ready");
+    assert_true(ilist_pop(&list) == &jobs[0], "pop");
+    assert_true(ilist_pop(&list) == &jobs[2], "pop");
+    assert_true(ilist_pop(&ready) == &jobs[2], "pop ready");
+    assert_true(ilist_pop(&list) == &jobs[4], "pop");
+    assert_true(ilist_pop(&ready) == &jobs[0], "pop ready");
+    assert_true(ilist_isempty(&list), "empty");
+    assert_true(ilist_isempty(&ready), "empty ready");
+    assert_false(ilist_delete(&it), "delete exhausted");
+}
+
+static
+void test_objpool()
+{
+    puts("ilist/test_objpool");
+    void *arena = malloc(OBJPOOL_SIZEOF(N, sizeof(Job)));
+    ObjPool pool;
+    IList list;
+
+    objpool_init(&pool, arena, N, sizeof(Job));
+    assert_true(ilist_init(&list, objpool_at(&pool, 0), pool.blksize,
+                           offsetof(Job, link)), "init on pool");
+
+    for (int i=0; i < N; i++){
+        Job *j = objpool_acquire(&pool);
+        j->id = i;
+        ilist_push(&list, j);
+        /* the list and the pool agree on the index */
+        assert_true(ilist_index(&list, j) == objpool_index(&pool, j), "index");
+    }
+
+    /* release everything going through the list */
+    int i = N - 1;
+    while (!ilist_isempty(&list)){
+        Job *j = ilist_pop(&list);
+        assert_true(j->id == i, "pop from pool");
+        objpool_release(&pool, j);
+        i--;
+    }
+    assert_true(pool.len == 0, "all released");
+
+    free(arena);
+}
+
+int main()
+{
+    test_init();
+    test_list();
+    test_objpool();
+
+    puts("OK");
+
+    return 0;
+}
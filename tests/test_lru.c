@@ -0,0 +1,297 @@
+/* Test LRU Cache */
+
+#define DS_IMPLEMENTATION
+#include "lru.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t key;
+    int value;
+} Entry;
+
+static bool entry_match(const void *obj, const void *key)
+{
+    return ((const Entry*)obj)->key == *(const uint64_t*)key;
+}
+
+/* put the key with its value, return the entry */
+static Entry * put(LRUCache *c, uint64_t key, int value)
+{
+    bool found;
+    Entry *e = lru_put(c, hashidx_mix64(key), &key, &found);
+    assert_true(e != NULL, "put");
+    if (!found){
+        e->key = key;
+    }
+    e->value = value;
+    return e;
+}
+
+static Entry * get(LRUCache *c, uint64_t key)
+{
+    return lru_get(c, hashidx_mix64(key), &key);
+}
+
+static void test_init()
+{
+    puts("lru/test_init");
+
+    void *arena = malloc(LRU_SIZEOF(4, sizeof(Entry)));
+    assert_true(lru_init(NULL, 4, sizeof(Entry), entry_match, LRU_STRICT)
+                == NULL, "arena null");
+    assert_true(lru_init(arena, 0, sizeof(Entry), entry_match, LRU_STRICT)
+                == NULL, "capacity 0");
+    assert_true(lru_init(arena, 4, 0, entry_match, LRU_STRICT) == NULL,
+                "objsize 0");
+    assert_true(lru_init(arena, 4, sizeof(Entry), NULL, LRU_STRICT) == NULL,
+                "match null");
+    assert_true(lru_init(arena, 4, sizeof(Entry), entry_match, 7) == NULL,
+                "mode");
+
+    LRUCache *c = lru_init(arena, 4, sizeof(Entry), entry_match, LRU_STRICT);
+    assert_true(c != NULL, "init");
+    assert_true(lru_len(c) == 0, "empty");
+    assert_false(lru_isfull(c), "not full");
+    assert_true(lru_evict(c) == NULL, "evict empty");
+    assert_true(get(c, 1) == NULL, "get empty");
+
+    assert_true(lru_len(NULL) == 0, "len null");
+    assert_true(lru_get(NULL, 0, NULL) == NULL, "get null");
+    assert_true(lru_put(NULL, 0, NULL, NULL) == NULL, "put null");
+    assert_false(lru_delete(NULL, 0, NULL), "delete null");
+    assert_true(lru_evict(NULL) == NULL, "evict null");
+
+    free(arena);
+}
+
+static void test_strict()
+{
+    puts("lru/test_strict");
+
+    LRUCache *c = lru_init(malloc(LRU_SIZEOF(3, sizeof(Entry))), 3,
+                           sizeof(Entry), entry_match, LRU_STRICT);
+    put(c, 1, 10);
+    put(c, 2, 20);
+    put(c, 3, 30);
+    assert_true(lru_isfull(c), "full");
+
+    /* 1 becomes the most recent, 2 the victim */
+    assert_true(get(c, 1)->value == 10, "get 1");
+    put(c, 4, 40);
+    assert_true(lru_len(c) == 3, "len");
+    assert_true(get(c, 2) == NULL, "2 evicted");
+
+    /* the order from the most recent: 4 1 3 */
+    uint64_t order[] = {4, 1, 3};
+    size_t pos = LRU_NIL;
+    size_t k = 0;
+    for (Entry *e = lru_next(c, &pos); e != NULL; e = lru_next(c, &pos)){
+        assert_true(e->key == order[k++], "order");
+    }
+    assert_true(k == 3, "iterated");
+
+    /* peek does not change the order, update does */
+    uint64_t key = 3;
+    assert_true(((Entry*)lru_peek(c, hashidx_mix64(key), &key))->value == 30,
+                "peek");
+    put(c, 1, 11);
+    Entry *e = lru_evict(c);
+    assert_true(e != NULL && e->key == 3, "evict 3");
+    assert_true(get(c, 1)->value == 11, "updated");
+
+    assert_true(lru_delete(c, hashidx_mix64(key), &key) == false,
+                "delete evicted");
+    key = 4;
+    assert_true(lru_delete(c, hashidx_mix64(key), &key), "delete 4");
+    assert_true(lru_len(c) == 1, "one left");
+
+    lru_clear(c);
+    assert_true(lru_len(c) == 0 && get(c, 1) == NULL, "clear");
+    put(c, 5, 50);
+    assert_true(get(c, 5)->value == 50, "after clear");
+
+    free(c);
+}
+
+static void test_clock()
+{
+    puts("lru/test_clock");
+
+    LRUCache *c = lru_init(malloc(LRU_SIZEOF(3, sizeof(Entry))), 3,
+                           sizeof(Entry), entry_match, LRU_CLOCK);
+    put(c, 1, 10);
+    put(c, 2, 20);
+    put(c, 3, 30);
+
+    /* the hit does not move 1, it gets a second chance */
+    size_t head = c->head;
+    assert_true(get(c, 1)->value == 10, "get 1");
+    assert_true(c->head == head, "no relink on hit");
+
+    put(c, 4, 40);
+    assert_true(get(c, 2) == NULL, "2 evicted");
+    assert_true(get(c, 1) != NULL, "1 kept");
+
+    /* all referenced: the tail one (3) after a full round */
+    get(c, 3);
+    get(c, 4);
+    Entry *e = lru_evict(c);
+    assert_true(e != NULL && e->key == 3, "round");
+
+    free(c);
+}
+
+#define CAP 16
+#define KEYS 64
+
+static void test_random()
+{
+    puts("lru/test_random");
+
+    /* reference: the last use of every key, 0 if not cached */
+    uint64_t used[KEYS] = {0};
+    uint64_t clock = 0;
+    LRUCache *c = lru_init(malloc(LRU_SIZEOF(CAP, sizeof(Entry))), CAP,
+                           sizeof(Entry), entry_match, LRU_STRICT);
+
+    srand(5);
+    for (size_t op=0; op < 100000; op++){
+        uint64_t key = (uint64_t)rand() % KEYS;
+        int r = rand() % 8;
+        clock++;
+
+        if (r == 0){
+            bool ok = lru_delete(c, hashidx_mix64(key), &key);
+            assert_true(ok == (used[key] != 0), "delete");
+            used[key] = 0;
+        } else if (r < 4){
+            Entry *e = get(c, key);
+            assert_true((e != NULL) == (used[key] != 0), "get");
+            if (e != NULL){
+                assert_true(e->value == (int)key, "value");
+                used[key] = clock;
+            }
+        } else {
+            size_t victim = KEYS;
+            size_t len = 0;
+            for (size_t k=0; k < KEYS; k++){
+                if (used[k] == 0){
+                    continue;
+                }
+                len++;
+                if (victim == KEYS || used[k] < used[victim]){
+                    victim = k;
+                }
+            }
+            if (used[key] == 0 && len == CAP){
+                used[victim] = 0;
+            }
+            put(c, key, (int)key);
+            used[key] = clock;
+        }
+
+        size_t len = 0;
+        for (size_t k=0; k < KEYS; k++){
+            len += (used[k] != 0);
+        }
+        assert_true(lru_len(c) == len, "len");
+    }
+
+    free(c);
+}
+
+static void test_collide()
+{
+    puts("lru/test_collide");
+
+    /* the same hash for all the keys: the deletes in the full groups leave
+     * tombstones and the index is rebuilt
+     */
+    const uint64_t h = 42;
+    LRUCache *c = lru_init(malloc(LRU_SIZEOF(CAP, sizeof(Entry))), CAP,
+                           sizeof(Entry), entry_match, LRU_STRICT);
+
+    for (uint64_t key=0; key < 10000; key++){
+        bool found;
+        Entry *e = lru_put(c, h, &key, &found);
+        assert_false(found, "new key");
+        e->key = key;
+        e->value = (int)key;
+        if (key % 3 == 0){
+            assert_true(lru_delete(c, h, &key), "delete");
+        }
+        assert_true(c->index->len == lru_len(c), "index len");
+    }
+
+    /* the last CAP keys not deleted are cached, but 9999 is deleted */
+    size_t n = 0;
+    for (uint64_t key=0; key < 10000; key++){
+        Entry *e = lru_peek(c, h, &key);
+        if (e != NULL){
+            assert_true(e->key == key && key % 3 != 0, "cached");
+            n++;
+        }
+    }
+    assert_true(n == CAP - 1 && n == lru_len(c), "all found");
+
+    free(c);
+}
+
+static void test_rehash()
+{
+    puts("lru/test_rehash");
+
+    LRUCache *c = lru_init(malloc(LRU_SIZEOF(CAP, sizeof(Entry))), CAP,
+                           sizeof(Entry), entry_match, LRU_STRICT);
+    const size_t groups = c->index->size / HASHIDX_GROUP;
+    size_t tombs = 0;
+    size_t rebuilds = 0;
+
+    /* every block of CAP keys fills a group of the index, deleting them
+     * leaves CAP tombstones: the index is rebuilt when they are too many
+     */
+    for (uint64_t key=0; key < CAP * 2 * groups; key++){
+        uint64_t block = key / CAP;
+        uint64_t h = ((block % groups) * HASHIDX_GROUP) << 7 | (key & 0x7F);
+        bool found;
+        Entry *e = lru_put(c, h, &key, &found);
+        assert_false(found, "new key");
+        e->key = key;
+        e->value = (int)key;
+
+        if (key % CAP != CAP - 1){
+            continue;
+        }
+        /* the tombstones of the previous blocks are gone */
+        if (c->index->tombs < tombs){
+            rebuilds++;
+        }
+        for (uint64_t k = key + 1 - CAP; k <= key; k++){
+            h = ((block % groups) * HASHIDX_GROUP) << 7 | (k & 0x7F);
+            assert_true(lru_peek(c, h, &k) != NULL, "found");
+            assert_true(lru_delete(c, h, &k), "delete");
+        }
+        assert_true(lru_len(c) == 0, "empty");
+        tombs = c->index->tombs;
+    }
+    assert_true(rebuilds == 2, "rebuilt");
+
+    free(c);
+}
+
+int main()
+{
+    test_init();
+    test_strict();
+    test_clock();
+    test_random();
+    test_collide();
+    test_rehash();
+
+    puts("OK");
+    return 0;
+}
@@ -0,0 +1,206 @@
+/* Test the headers included by more translation units
+ *
+ * This unit includes every header without DS_IMPLEMENTATION, the
+ * definitions come from multitu_impl.c: the link must not fail with
+ * duplicate symbols.
+ */
+
+#include "vmem.h" /* vmem.h and persist.h before the system headers */
+#include "persist.h"
+#include "range.h"
+#include "stack.h"
+#include "queue.h"
+#include "objpool.h"
+#include "slist.h"
+#include "dlist.h"
+#include "skiplist.h"
+#include "ilist.h"
+#include "cslist.h"
+#include "rangend.h"
+#include "hashidx.h"
+#include "arena.h"
+#include "bitpool.h"
+#include "heap.h"
+#include "timerwheel.h"
+#include "lru.h"
+#include "ebr.h"
+#include "sparseset.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define N 8
+
+size_t multitu_fill(SList *list, int *values, size_t n);
+
+static int cmp_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static bool match_size(const void *obj, const void *key)
+{
+    return *(const size_t *)obj == *(const size_t *)key;
+}
+
+static void count_released(const size_t *items, size_t n, void *ctx)
+{
+    (void)items;
+    *(size_t *)ctx += n;
+}
+
+static void test_slist()
+{
+    puts("multitu/test_slist");
+
+    int values[N] = {5, 3, 7, 1, 0, 6, 2, 4};
+    SList *list = slist_init(malloc(SLIST_SIZEOF(N)), N);
+    assert_true(list != NULL, "init");
+
+    assert_true(multitu_fill(list, values, N) == N, "fill");
+    assert_true(slist_isfull(list), "full");
+
+    slist_sort(list, cmp_int);
+    for (int i=0; i < N; i++){
+        int *v = slist_pop(list);
+        assert_true(v != NULL && *v == i, "pop sorted");
+    }
+
+    free(list);
+}
+
+static void test_skiplist()
+{
+    puts("multitu/test_skiplist");
+
+    int values[N] = {5, 3, 7, 1, 0, 6, 2, 4};
+    SkipList *sl = skiplist_init(malloc(SKIPLIST_SIZEOF(N)), N, cmp_int, 1);
+    assert_true(sl != NULL, "init");
+
+    for (int i=0; i < N; i++){
+        assert_true(skiplist_insert(sl, &values[i]), "insert");
+    }
+    int key = 6;
+    int *v = skiplist_find(sl, &key);
+    assert_true(v != NULL && *v == key, "find");
+    assert_true(skiplist_delete(sl, &key) == v, "delete");
+    assert_true(skiplist_len(sl) == N - 1, "len");
+
+    free(sl);
+}
+
+static void test_others()
+{
+    puts("multitu/test_others");
+
+    Range r = range_init("Test", -2, 2, NULL);
+    RangeType in[4] = {-2, 0, 2, 3};
+    size_t out[4];
+    assert_true(range_at_n(r, in, out, 4) == 1, "range_at_n");
+
+    int objs[N];
+    ObjPool pool;
+    assert_true(objpool_init(&pool, malloc(OBJPOOL_SIZEOF(N, sizeof(size_t))),
+                             N, sizeof(size_t)), "objpool_init");
+    assert_true(objpool_acquire(&pool) != NULL, "objpool_acquire");
+    free(pool.blocks);
+
+    DList *dl = dlist_init(malloc(DLIST_SIZEOF(N)), N);
+    assert_true(dlist_push_back(dl, &objs[0]) != DLIST_NIL, "dlist_push_back");
+    free(dl);
+
+    CSList *cl = cslist_init(malloc(CSLIST_SIZEOF(N, 1)), N, 1);
+    CSListThread *t = cslist_thread(cl, 0);
+    assert_true(cslist_insert(t, &objs[1]), "cslist_insert");
+    assert_true(cslist_delete(t, &objs[1]), "cslist_delete");
+    free(cl);
+
+    Range axes[2] = {range_init("I", 0, 3, NULL), range_init("J", 0, 3, NULL)};
+    RangeND g;
+    assert_true(rangend_init(&g, 2, axes, RANGEND_MORTON, 0), "rangend_init");
+    assert_true(rangend_at2(&g, 3, 3) == 15, "rangend_at2");
+
+    HashIdx *h = hashidx_init(malloc(HASHIDX_SIZEOF(16)), 16);
+    assert_true(hashidx_insert(h, hashidx_mix64(7), 7), "hashidx_insert");
+    assert_true(hashidx_len(h) == 1, "hashidx_len");
+    free(h);
+
+    uint8_t mem[ARENA_SIZEOF(SLIST_SIZEOF(N))];
+    Arena a;
+    assert_true(arena_init(&a, mem, sizeof(mem)), "arena_init");
+    assert_true(slist_init(arena_push(&a, SLIST_SIZEOF(N)), N) != NULL,
+                "arena_push");
+
+    VMem m;
+    assert_true(vmem_map(&m, SLIST_SIZEOF(N), 0), "vmem_map");
+    assert_true(vmem_prefault(&m, 1) == m.size / m.page, "vmem_prefault");
+    vmem_unmap(&m);
+
+    int copy[N] = {5, 3, 7, 1, 0, 6, 2, 4};
+    assert_true(persist_checksum(copy, sizeof(copy)) !=
+                persist_checksum(copy, sizeof(copy) - 1), "persist_checksum");
+
+    BitPool *bp = bitpool_init(malloc(BITPOOL_SIZEOF(100)), 100);
+    assert_true(bitpool_alloc(bp) == 0, "bitpool_alloc");
+    assert_true(bitpool_alloc_run(bp, 4) == 1, "bitpool_alloc_run");
+    assert_true(bitpool_free_run(bp, 1, 4), "bitpool_free_run");
+    assert_true(bitpool_len(bp) == 1, "bitpool_len");
+    free(bp);
+
+    HeapIndex *hp = heap_init(malloc(HEAP_SIZEOF(N)), N, copy, sizeof(int),
+                              cmp_int);
+    assert_true(heap_heapify(hp, N), "heap_heapify");
+    assert_true(heap_pop(hp) == 4, "heap_pop");
+    assert_true(heap_top(hp) == 3, "heap_top");
+    free(hp);
+
+    TimerWheel *tw = timerwheel_init(malloc(TIMERWHEEL_SIZEOF(N)), N, 0);
+    size_t th = timerwheel_schedule(tw, 10);
+    assert_true(timerwheel_schedule(tw, 20) != TIMERWHEEL_NIL,
+                "timerwheel_schedule");
+    assert_true(timerwheel_cancel(tw, th), "timerwheel_cancel");
+    assert_true(timerwheel_advance(tw, 20, NULL, NULL) == 1,
+                "timerwheel_advance");
+    free(tw);
+
+    LRUCache *lru = lru_init(malloc(LRU_SIZEOF(2, sizeof(size_t))), 2,
+                             sizeof(size_t), match_size, LRU_STRICT);
+    for (size_t i=0; i < 3; i++){
+        size_t *o = lru_put(lru, hashidx_mix64(i), &i, NULL);
+        assert_true(o != NULL, "lru_put");
+        *o = i;
+    }
+    size_t key = 0;
+    assert_true(lru_get(lru, hashidx_mix64(0), &key) == NULL, "lru_get");
+    assert_true(lru_len(lru) == 2, "lru_len");
+    free(lru);
+
+    size_t released = 0;
+    EBR *ebr = ebr_init(malloc(EBR_SIZEOF(1, 4)), 1, 4, count_released,
+                        &released);
+    EBRThread *et = ebr_thread(ebr, 0);
+    ebr_enter(et);
+    assert_true(ebr_retire(et, 7), "ebr_retire");
+    ebr_leave(et);
+    ebr_drain(ebr);
+    assert_true(released == 1, "ebr_drain");
+    free(ebr);
+
+    SparseSet *ss = sparseset_init(malloc(SPARSESET_SIZEOF(100, N)), 100, N);
+    assert_true(sparseset_insert(ss, 42), "sparseset_insert");
+    assert_true(sparseset_contains(ss, 42), "sparseset_contains");
+    assert_true(sparseset_remove(ss, 42), "sparseset_remove");
+    assert_true(sparseset_isempty(ss), "sparseset_isempty");
+    free(ss);
+}
+
+int main()
+{
+    test_slist();
+    test_skiplist();
+    test_others();
+
+    puts("OK");
+    return 0;
+}
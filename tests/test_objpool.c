@@ -1,3 +1,4 @@
+#define DS_IMPLEMENTATION
 #include "objpool.h"
 #include "asserts.h"
 #include <stdlib.h>
@@ -11,8 +12,53 @@ typedef struct {
 
 #define MYSTRUCT_MAX 5
 
+DS_DEFINE_POOL(StructPool, MyStruct)
+
+static void test_define()
+{
+    puts("objpool/test_define");
+
+    StructPoolSlot slots[MYSTRUCT_MAX];
+    StructPool pool;
+    MyStruct *objs[MYSTRUCT_MAX + 1];
+
+    assert_false(StructPool_init(&pool, NULL, MYSTRUCT_MAX), "init NULL");
+    assert_false(StructPool_init(&pool, slots, 0), "init 0");
+    assert_true(StructPool_init(&pool, slots, MYSTRUCT_MAX), "init");
+    assert_true(StructPool_isempty(&pool), "empty");
+
+    MyStruct v = {.a = 7, .s = "x"};
+    size_t i = StructPool_put(&pool, v);
+    assert_true(i == 0, "put index");
+    assert_true(StructPool_at(&pool, i)->a == 7, "put value");
+    assert_true(StructPool_at(&pool, MYSTRUCT_MAX) == NULL, "at out of pool");
+
+    assert_true(StructPool_acquire_n(&pool, objs, MYSTRUCT_MAX + 1) ==
+                MYSTRUCT_MAX - 1, "acquire_n");
+    assert_true(StructPool_isfull(&pool), "full");
+    assert_true(StructPool_acquire(&pool) == NULL, "acquire full");
+    assert_true(StructPool_put(&pool, v) == OBJPOOL_NIL, "put full");
+    for (int k=0; k < MYSTRUCT_MAX - 1; k++){
+        size_t j = StructPool_index(&pool, objs[k]);
+        assert_true(j == (size_t)k + 1, "acquire_n index");
+    }
+
+    StructPool_release_n(&pool, objs, 2);
+    StructPool_release(&pool, NULL);
+    assert_true(StructPool_len(&pool) == MYSTRUCT_MAX - 2, "release_n");
+
+    /* the released are reused before */
+    assert_true(StructPool_acquire_n(&pool, objs, 3) == 2, "acquire_n again");
+    assert_true(StructPool_index(&pool, objs[0]) == 2, "reuse last released");
+    assert_true(StructPool_index(&pool, objs[1]) == 1, "reuse first released");
+    assert_true(StructPool_index(&pool, &v) == OBJPOOL_NIL, "index out of pool");
+}
+
+
 int main()
 {
+    test_define();
+
     /* allocate enough bytes for MYSTRUCT_MAX MyStruct instances */
     void *arena = malloc(OBJPOOL_SIZEOF(MYSTRUCT_MAX, sizeof(MyStruct)));
     ObjPool pool;
@@ -68,6 +114,17 @@ int main()
         assert_true(tmp[i]->s[0] >= 'a', "acquire again checks");
         assert_true(tmp[i]->s[0] < 'a' + MYSTRUCT_MAX, "acquire again checks");
     }
+    /* objects by index */
+    for (int i=0; i < MYSTRUCT_MAX; i++){
+        size_t k = objpool_index(&pool, tmp[i]);
+        assert_true(k < MYSTRUCT_MAX, "index");
+        assert_true(objpool_at(&pool, k) == tmp[i], "at index");
+    }
+    assert_true(objpool_at(&pool, MYSTRUCT_MAX) == NULL, "at out of pool");
+    assert_true(objpool_index(&pool, NULL) == OBJPOOL_NIL, "index NULL");
+    assert_true(objpool_index(&pool, &tmp[0]->s[1]) == OBJPOOL_NIL, "index inside");
+    assert_true(objpool_index(&pool, &pool) == OBJPOOL_NIL, "index out of pool");
+
     /* release all in reverse order */
     for (int i=MYSTRUCT_MAX -1 ; i >= 0; i--){
         objpool_release(&pool, tmp[i]);
@@ -0,0 +1,194 @@
+/* Test Persistent arenas */
+
+#define DS_IMPLEMENTATION
+#include "persist.h"
+#include "arena.h"
+#include "slist.h"
+#include "objpool.h"
+#include "queue.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define N 64
+#define KIND 42
+
+typedef struct {
+    size_t key;
+    size_t value;
+} Obj;
+
+/* the structures in the arena, allocated in the same order at every run */
+typedef struct {
+    SList *list;
+    ObjPool *pool;
+    QueueIndex *queue;
+    size_t *data;
+} Store;
+
+static const size_t SIZE = ARENA_SIZEOF(SLIST_SIZEOF(N)) +
+                           ARENA_SIZEOF(sizeof(ObjPool)) +
+                           ARENA_SIZEOF(OBJPOOL_SIZEOF(N, sizeof(Obj))) +
+                           ARENA_SIZEOF(sizeof(QueueIndex)) +
+                           ARENA_SIZEOF(N * sizeof(size_t));
+
+static char path[] = "/tmp/test_persist_XXXXXX";
+
+static bool layout(Store *s, Persist *p, bool created)
+{
+    Arena a;
+    arena_init(&a, p->arena, p->size);
+
+    void *list = arena_push(&a, SLIST_SIZEOF(N));
+    s->pool = arena_push(&a, sizeof(ObjPool));
+    void *blocks = arena_push(&a, OBJPOOL_SIZEOF(N, sizeof(Obj)));
+    s->queue = arena_push(&a, sizeof(QueueIndex));
+    s->data = arena_push(&a, N * sizeof(size_t));
+
+    if (created){
+        s->list = slist_init(list, N);
+        return s->list != NULL &&
+               objpool_init(s->pool, blocks, N, sizeof(Obj)) &&
+               queue_init(s->queue, N) == 0;
+    }
+    s->list = slist_attach(list);
+    return s->list != NULL && objpool_attach(s->pool, blocks);
+}
+
+static void test_create()
+{
+    puts("persist/test_create");
+
+    Persist p;
+    Store s;
+    assert_true(persist_open(NULL, path, SIZE, KIND) == -1, "open null");
+    assert_true(persist_open(&p, path, 0, KIND) == -1, "open empty");
+    assert_true(persist_open(&p, path, SIZE, KIND) == PERSIST_CREATED,
+                "created");
+    assert_true(layout(&s, &p, true), "layout");
+
+    /* the list values are the indexes of the objects, valid in every run */
+    for (size_t i=0; i < N / 2; i++){
+        Obj *obj = objpool_acquire(s.pool);
+        obj->key = i;
+        obj->value = i * i;
+        size_t k = objpool_index(s.pool, obj);
+        assert_true(slist_push(s.list, (void*)(uintptr_t)(k + 1)), "push");
+
+        long q = queue_enqueue(s.queue);
+        assert_true(q >= 0, "enqueue");
+        s.data[q] = i;
+    }
+
+    assert_true(persist_checkpoint(&p), "checkpoint");
+    assert_true(persist_verify(&p), "verify");
+    assert_true(p.header->epoch == 1, "epoch");
+    assert_true(p.header->state == PERSIST_DIRTY, "dirty after checkpoint");
+
+    /* changes after the checkpoint, saved by the close */
+    assert_true(queue_dequeue(s.queue) >= 0, "dequeue");
+    assert_true(persist_close(&p), "close");
+    assert_false(persist_close(&p), "close twice");
+}
+
+static void test_attach()
+{
+    puts("persist/test_attach");
+
+    Persist p;
+    Store s;
+    assert_true(persist_open(&p, path, SIZE + 1, KIND) == -1, "other size");
+    assert_true(persist_open(&p, path, SIZE, KIND + 1) == -1, "other kind");
+    assert_true(persist_open(&p, path, SIZE, KIND) == PERSIST_ATTACHED,
+                "attached");
+    assert_true(p.header->epoch == 2, "epoch");
+    assert_true(layout(&s, &p, false), "layout");
+
+    assert_true(slist_len(s.list) == N / 2, "list len");
+    assert_true(s.pool->len == N / 2, "pool len");
+    for (size_t i=N/2; i > 0; i--){
+        size_t k = (size_t)(uintptr_t)slist_pop(s.list) - 1;
+        Obj *obj = objpool_at(s.pool, k);
+        assert_true(obj != NULL && obj->key == i - 1, "key");
+        assert_true(obj->value == (i - 1) * (i - 1), "value");
+        objpool_release(s.pool, obj);
+    }
+    assert_true(queue_length(s.queue) == N / 2 - 1, "queue len");
+    long q = queue_dequeue(s.queue);
+    assert_true(q >= 0 && s.data[q] == 1, "queue data");
+
+    /* the free lists work after the attach */
+    for (size_t i=0; i < N; i++){
+        assert_true(objpool_acquire(s.pool) != NULL, "acquire all");
+        assert_true(slist_push(s.list, NULL), "push all");
+    }
+    assert_true(objpool_acquire(s.pool) == NULL, "pool full");
+    assert_true(slist_isfull(s.list), "list full");
+
+    /* pointers into the arena of the previous run */
+    void *prev = (void*)(p.prev + 8);
+    assert_true(persist_rebase(&p, prev) == (uint8_t*)p.arena + 8, "rebase");
+    assert_true(persist_rebase(&p, &p) == &p, "rebase outside");
+
+    slist_detach(s.list);
+    objpool_detach(s.pool);
+    assert_true(s.list->items == NULL && s.pool->blocks == NULL, "detach");
+    assert_true(persist_close(&p), "close");
+}
+
+static void test_crash()
+{
+    puts("persist/test_crash");
+
+    Persist p;
+    Store s;
+
+    /* crash without changes after the checkpoint: accepted */
+    assert_true(persist_open(&p, path, SIZE, KIND) == PERSIST_ATTACHED,
+                "attached");
+    munmap(p.header, PERSIST_SIZEOF(p.size));
+    close(p.fd);
+    assert_true(persist_open(&p, path, SIZE, KIND) == PERSIST_ATTACHED,
+                "unchanged");
+    assert_true(layout(&s, &p, false), "layout");
+
+    /* crash after a change: rejected */
+    slist_pop(s.list);
+    munmap(p.header, PERSIST_SIZEOF(p.size));
+    close(p.fd);
+    assert_true(persist_open(&p, path, SIZE, KIND) == -1, "changed");
+
+    /* corrupted magic */
+    FILE *f = fopen(path, "r+b");
+    assert_true(f != NULL, "fopen");
+    fputc(0, f);
+    fclose(f);
+    assert_true(persist_open(&p, path, SIZE, KIND) == -1, "magic");
+
+    /* not a valid list */
+    uint8_t arena[SLIST_SIZEOF(N)] = {0};
+    assert_true(slist_attach(NULL) == NULL, "attach null");
+    assert_true(slist_attach(arena) == NULL, "attach zero");
+    ObjPool pool;
+    memset(&pool, 0, sizeof(pool));
+    assert_false(objpool_attach(&pool, arena), "attach pool zero");
+    assert_false(objpool_attach(NULL, arena), "attach pool null");
+}
+
+int main()
+{
+    int fd = mkstemp(path);
+    assert_true(fd >= 0, "mkstemp");
+    close(fd);
+
+    test_create();
+    test_attach();
+    test_crash();
+
+    unlink(path);
+    puts("OK");
+    return 0;
+}
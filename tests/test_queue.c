@@ -1,3 +1,4 @@
+#define DS_IMPLEMENTATION
 #include "queue.h"
 #include "asserts.h"
 #include <stdlib.h>
@@ -43,8 +44,56 @@ bool queuei_dequeue(QueueInt *s, int *x)
     return true;
 }
 
+DS_DEFINE_QUEUE(IntQueue, int)
+
+static void test_define()
+{
+    puts("queue/test_define");
+
+    int buf[4];
+    IntQueue q;
+    int x = -1;
+
+    assert_false(IntQueue_init(&q, NULL, 4), "init NULL");
+    assert_false(IntQueue_init(&q, buf, 0), "init 0");
+    assert_true(IntQueue_init(&q, buf, 4), "init");
+    assert_true(IntQueue_isempty(&q), "empty");
+    assert_true(IntQueue_front(&q) == NULL, "front empty");
+    assert_false(IntQueue_pop(&q, &x), "pop empty");
+    assert_true(x == -1, "untouched x");
+
+    for (int i=0; i < 100; i++){
+        assert_true(IntQueue_push(&q, i), "push in loop");
+        assert_true(*IntQueue_front(&q) == i, "front in loop");
+        assert_true(IntQueue_pop(&q, &x) && x == i, "pop in loop");
+    }
+
+    /* batch across the end of the array: head is 100 % 4 = 0, move it */
+    assert_true(IntQueue_push(&q, 0), "push");
+    assert_true(IntQueue_push(&q, 1), "push");
+    assert_true(IntQueue_push(&q, 2), "push");
+    assert_true(IntQueue_pop(&q, &x) && x == 0, "pop");
+    assert_true(IntQueue_pop(&q, &x) && x == 1, "pop");
+
+    int src[5] = {3, 4, 5, 6, 7};
+    assert_true(IntQueue_push_n(&q, src, 5) == 3, "push_n wrap");
+    assert_true(IntQueue_isfull(&q), "full");
+    assert_false(IntQueue_push(&q, 8), "push full");
+
+    int dst[5];
+    assert_true(IntQueue_pop_n(&q, dst, 5) == 4, "pop_n wrap");
+    for (int i=0; i < 4; i++){
+        assert_true(dst[i] == i + 2, "pop_n order");
+    }
+    assert_true(IntQueue_isempty(&q), "empty again");
+    assert_true(IntQueue_pop_n(&q, dst, 5) == 0, "pop_n empty");
+}
+
+
 int main()
 {
+    test_define();
+
     QueueInt queue;
     queuei_init(&queue, 3);
     assert_true(queue_isempty(&queue.index), "init empty");
@@ -1,3 +1,4 @@
+#define DS_IMPLEMENTATION
 #include "range.h"
 #include "asserts.h"
 
@@ -7,6 +8,7 @@
 #include <string.h>
 
 RangeType test_range_i = 0;
+int test_range_calls = 0;
 
 RangeType test_range_callback(Range r, RangeType i)
 {
@@ -14,6 +16,7 @@ RangeType test_range_callback(Range r, RangeType i)
     assert_true(r.start == -5, "wrong start in callback");
     assert_true(r.end == 5, "wrong end in callback");
     test_range_i = i;
+    test_range_calls++;
 
     /* in real scenaio here that can be an abort */
 
@@ -21,6 +24,10 @@ RangeType test_range_callback(Range r, RangeType i)
     return r.start;
 }
 
+/* the same range of the tests, with constant bounds */
+RANGE_DEFINE(Test, -5, 5, test_range_callback)
+RANGE_DEFINE(Plain, 1, 10, NULL)
+
 int main()
 {
     int std[RANGE_SIZE(-5, 5)];
@@ -74,6 +81,60 @@ int main()
     assert_true(range_at(r, 6) == 0, "at 6");
     assert_true(test_range_i == 6, "callback not called");
 
+    /* bulk conversion, odd length for the scalar tail */
+    enum { BULK = 1003 };
+    RangeType idx[BULK];
+    size_t out[BULK];
+    uint8_t mask[BULK];
+    size_t bad = 0;
+
+    for (int k=0; k < BULK; k++){
+        idx[k] = (rand() % 21) - 10; /* [-10, 10] */
+        bad += range_in(r, idx[k])?0:1;
+    }
+    assert_true(range_in_n(r, idx, NULL, BULK) == bad, "in_n count");
+    assert_true(range_in_n(r, idx, mask, BULK) == bad, "in_n mask count");
+    for (int k=0; k < BULK; k++){
+        assert_true(mask[k] == (range_in(r, idx[k])?0:1), "in_n mask");
+    }
+
+    test_range_calls = 0;
+    assert_true(range_at_n(r, idx, out, BULK) == bad, "at_n count");
+    assert_true(test_range_calls == (int)bad, "at_n callback only out of range");
+    for (int k=0; k < BULK; k++){
+        assert_true(out[k] == range_at(r, idx[k]), "at_n value");
+    }
+
+    /* without callback the out of range are converted anyway */
+    Range q = range_init("NoCallback", -5, 5, NULL);
+    assert_true(range_at_n(q, idx, out, BULK) == bad, "at_n no callback");
+    for (int k=0; k < BULK; k++){
+        assert_true(out[k] == range_at(q, idx[k]), "at_n no callback value");
+    }
+    assert_true(range_in_n(q, idx, mask, 0) == 0, "in_n empty");
+
+    /* compile time ranges behave as the runtime ones */
+    assert_true(Test_size() == range_size(r), "define size");
+    assert_true(strcmp(Test_range().name, "Test") == 0, "define name");
+    for (RangeType i=-5; Test_in(i); i++){
+        assert_true(Test_at(i) == range_at(r, i), "define at");
+        assert_true(Test_of(Test_at(i)) == i, "define of");
+    }
+    test_range_calls = 0;
+    assert_true(Test_at(-6) == 0, "define at -6");
+    assert_true(test_range_i == -6, "define callback");
+    assert_true(Test_at(6) == 0, "define at 6");
+    assert_true(test_range_i == 6, "define callback");
+    assert_true(Test_of(11) == -5, "define of 11");
+    assert_true(test_range_i == 6, "define callback of");
+    assert_true(test_range_calls == 3, "define callback calls");
+
+    assert_true(Plain_at(1) == 0, "plain at");
+    assert_true(Plain_at(10) == 9, "plain at end");
+    assert_false(Plain_in(0), "plain in");
+    assert_true(Plain_of(9) == 10, "plain of");
+    assert_true(Plain_size() == 10, "plain size");
+
     puts("OK");
 
     return 0;
@@ -0,0 +1,182 @@
+/* Test N-dimensional Range */
+
+#define DS_IMPLEMENTATION
+#include "rangend.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+int test_calls = 0;
+
+RangeType test_callback(Range r, RangeType i)
+{
+    (void)i;
+    test_calls++;
+    return r.start;
+}
+
+/* every cell has a distinct offset in [0, size) */
+static
+void assert_bijective(const RangeND *g)
+{
+    uint8_t *seen = (uint8_t*)calloc(rangend_size(g), 1);
+    RangeType idx[RANGEND_MAXDIM] = {0};
+    size_t cells = 1;
+
+    for (size_t a=0; a < g->ndim; a++){
+        idx[a] = g->axis[a].start;
+        cells *= range_size(g->axis[a]);
+    }
+
+    for (size_t n=0; n < cells; n++){
+        size_t off = rangend_at(g, idx);
+        assert_true(off < rangend_size(g), "offset out of size");
+        assert_false(seen[off], "offset not unique");
+        seen[off] = 1;
+
+        /* next coordinates, last axis first */
+        for (size_t a=g->ndim; a-- > 0;){
+            if (idx[a] < g->axis[a].end){
+                idx[a]++;
+                break;
+            }
+            idx[a] = g->axis[a].start;
+        }
+    }
+
+    free(seen);
+}
+
+static
+void test_init()
+{
+    puts("rangend/test_init");
+    Range axes[2] = {
+        range_init("Lat", -90, 90, NULL),
+        range_init("Lon", -180, 180, NULL)
+    };
+    RangeND g;
+
+    assert_false(rangend_init(NULL, 2, axes, RANGEND_ROWMAJOR, 0), "null");
+    assert_false(rangend_init(&g, 0, axes, RANGEND_ROWMAJOR, 0), "ndim 0");
+    assert_false(rangend_init(&g, RANGEND_MAXDIM + 1, axes, RANGEND_ROWMAJOR, 0), "ndim max");
+    assert_false(rangend_init(&g, 2, axes, RANGEND_TILED, 6), "tile not pow2");
+
+    assert_true(rangend_init(&g, 2, axes, RANGEND_ROWMAJOR, 0), "rowmajor");
+    assert_true(rangend_size(&g) == 181 * 361, "rowmajor size");
+
+    assert_true(rangend_init(&g, 2, axes, RANGEND_TILED, 16), "tiled");
+    assert_true(rangend_size(&g) == 192 * 368, "tiled size");
+
+    assert_true(rangend_init(&g, 2, axes, RANGEND_MORTON, 0), "morton");
+    assert_true(rangend_size(&g) == 256 * 512, "morton size");
+}
+
+static
+void test_rowmajor()
+{
+    puts("rangend/test_rowmajor");
+    Range axes[3] = {
+        range_init("X", -2, 3, test_callback),
+        range_init("Y", 10, 14, test_callback),
+        range_init("Z", -7, -1, test_callback)
+    };
+    RangeND g;
+
+    rangend_init(&g, 3, axes, RANGEND_ROWMAJOR, 0);
+    assert_true(rangend_at3(&g, -2, 10, -7) == 0, "first");
+    assert_true(rangend_at3(&g, 3, 14, -1) == rangend_size(&g) - 1, "last");
+    assert_true(rangend_at3(&g, 0, 11, -5) == (2 * 5 + 1) * 7 + 2, "middle");
+    assert_bijective(&g);
+
+    /* the axis callback is called for the coordinate out of range */
+    test_calls = 0;
+    assert_true(rangend_at3(&g, 0, 15, -5) == rangend_at3(&g, 0, 10, -5), "callback");
+    assert_true(test_calls == 1, "callback calls");
+}
+
+static
+void test_tiled()
+{
+    puts("rangend/test_tiled");
+    Range axes[2] = {
+        range_init("Lat", -90, 90, test_callback),
+        range_init("Lon", -180, 180, test_callback)
+    };
+    RangeND g;
+
+    rangend_init(&g, 2, axes, RANGEND_TILED, 8);
+    assert_bijective(&g);
+
+    /* a tile is contiguous */
+    size_t base = rangend_at2(&g, -90, -180);
+    for (RangeType i=-90; i < -82; i++){
+        for (RangeType j=-180; j < -172; j++){
+            assert_true(rangend_at2(&g, i, j) - base < 64, "tile contiguous");
+        }
+    }
+    assert_true(rangend_at2(&g, -90, -172) == base + 64, "next tile");
+
+    Range cube[3] = {
+        range_init("X", -5, 5, NULL),
+        range_init("Y", -5, 5, NULL),
+        range_init("Z", 0, 2, NULL)
+    };
+    rangend_init(&g, 3, cube, RANGEND_TILED, 4);
+    assert_bijective(&g);
+}
+
+static
+void test_morton()
+{
+    puts("rangend/test_morton");
+    Range axes[2] = {
+        range_init("Lat", -90, 90, test_callback),
+        range_init("Lon", -180, 180, test_callback)
+    };
+    RangeND g;
+
+    rangend_init(&g, 2, axes, RANGEND_MORTON, 0);
+    assert_bijective(&g);
+
+    /* Z-order in the first block: (0,0) (0,1) (1,0) (1,1) (0,2) ... */
+    assert_true(rangend_at2(&g, -90, -180) == 0, "z 0");
+    assert_true(rangend_at2(&g, -90, -179) == 1, "z 1");
+    assert_true(rangend_at2(&g, -89, -180) == 2, "z 2");
+    assert_true(rangend_at2(&g, -89, -179) == 3, "z 3");
+    assert_true(rangend_at2(&g, -90, -178) == 4, "z 4");
+
+    /* the second block of the longitude follows the first */
+    assert_true(rangend_at2(&g, -90, 76) == 256 * 256, "second block");
+
+    Range cube[3] = {
+        range_init("X", -3, 4, NULL),
+        range_init("Y", 0, 8, NULL),
+        range_init("Z", 1, 5, NULL)
+    };
+    rangend_init(&g, 3, cube, RANGEND_MORTON, 0);
+    assert_bijective(&g);
+
+    Range hyper[4] = {
+        range_init("A", 0, 3, NULL),
+        range_init("B", 0, 3, NULL),
+        range_init("C", 0, 7, NULL),
+        range_init("D", -1, 1, NULL)
+    };
+    rangend_init(&g, 4, hyper, RANGEND_MORTON, 0);
+    assert_bijective(&g);
+}
+
+int main()
+{
+    test_init();
+    test_rowmajor();
+    test_tiled();
+    test_morton();
+
+    puts("OK");
+
+    return 0;
+}
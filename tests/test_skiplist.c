@@ -0,0 +1,227 @@
+/* Test Skip List */
+
+#define DS_IMPLEMENTATION
+#include "skiplist.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    int key;
+    int order; /* insertion order, to check the duplicates */
+} Item;
+
+static
+int item_cmp(const void *a, const void *b)
+{
+    const Item *x = a;
+    const Item *y = b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+/* check order and length walking the iterator */
+static
+void assert_sorted(SkipList *sl)
+{
+    SkipListIter it;
+    const Item *last = skiplist_iter(&it, sl);
+    size_t n = 0;
+
+    while (!skiplist_exhausted(it)){
+        const Item *v = skiplist_value(it);
+        assert_true(last->key <= v->key, "not sorted");
+        if (last->key == v->key){
+            assert_true(last->order <= v->order, "duplicates order");
+        }
+        last = v;
+        n++;
+        skiplist_next(&it);
+    }
+    assert_true(n == skiplist_len(sl), "sorted len");
+}
+
+static
+void test_init()
+{
+    puts("skiplist/test_init");
+    const size_t N = 5;
+    uint8_t *arena = (uint8_t*)malloc(SKIPLIST_SIZEOF(N));
+    SkipList *sl;
+
+    sl = skiplist_init(NULL, N, item_cmp, 1);
+    assert_true(sl == NULL, "arena null");
+
+    sl = skiplist_init(arena, 0, item_cmp, 1);
+    assert_true(sl == NULL, "size zero");
+
+    sl = skiplist_init(arena, N, NULL, 1);
+    assert_true(sl == NULL, "cmp null");
+
+    sl = skiplist_init(arena, N, item_cmp, 0);
+    assert_true(sl != NULL, "skiplist init");
+    assert_true(skiplist_isempty(sl), "init empty");
+    assert_false(skiplist_isfull(sl), "init full");
+
+    Item k = {.key = 1};
+    SkipListIter it;
+    assert_true(skiplist_find(sl, &k) == NULL, "find empty");
+    assert_true(skiplist_delete(sl, &k) == NULL, "delete empty");
+    assert_true(skiplist_iter(&it, sl) == NULL, "iter empty");
+    assert_true(skiplist_exhausted(it), "iter empty exhausted");
+
+    free(arena);
+}
+
+static
+void test_insert()
+{
+    puts("skiplist/test_insert");
+    const size_t N = 8;
+    uint8_t *arena = (uint8_t*)malloc(SKIPLIST_SIZEOF(N));
+    SkipList *sl = skiplist_init(arena, N, item_cmp, 42);
+    Item v[8] = {
+        {5, 0}, {1, 1}, {3, 2}, {3, 3}, {9, 4}, {1, 5}, {7, 6}, {3, 7}
+    };
+
+    for (size_t i=0; i < N; i++){
+        assert_true(skiplist_insert(sl, &v[i]), "insert");
+    }
+    assert_true(skiplist_isfull(sl), "full");
+    assert_false(skiplist_insert(sl, &v[0]), "insert full");
+    assert_sorted(sl);
+
+    /* find returns the first of the duplicates */
+    Item k = {.key = 3};
+    assert_true(skiplist_find(sl, &k) == &v[2], "find first duplicate");
+    k.key = 4;
+    assert_true(skiplist_find(sl, &k) == NULL, "find missing");
+
+    /* delete the duplicates in insertion order */
+    k.key = 3;
+    assert_true(skiplist_delete(sl, &k) == &v[2], "delete duplicate");
+    assert_true(skiplist_delete(sl, &k) == &v[3], "delete duplicate");
+    assert_true(skiplist_find(sl, &k) == &v[7], "find last duplicate");
+    assert_true(skiplist_delete(sl, &k) == &v[7], "delete duplicate");
+    assert_true(skiplist_delete(sl, &k) == NULL, "delete missing");
+    assert_true(skiplist_len(sl) == N - 3, "len after delete");
+    assert_sorted(sl);
+
+    /* released nodes are reused */
+    assert_true(skiplist_insert(sl, &v[2]), "reinsert");
+    assert_true(skiplist_insert(sl, &v[3]), "reinsert");
+    assert_true(skiplist_insert(sl, &v[7]), "reinsert");
+    assert_true(skiplist_isfull(sl), "full again");
+    assert_sorted(sl);
+
+    free(arena);
+}
+
+static
+void test_seek()
+{
+    puts("skiplist/test_seek");
+    const int N = 100;
+    uint8_t *arena = (uint8_t*)malloc(SKIPLIST_SIZEOF(N));
+    Item *v = (Item*)calloc(N, sizeof(Item));
+    SkipList *sl = skiplist_init(arena, N, item_cmp, 7);
+    SkipListIter it;
+
+    /* even keys from 0 to 198, inserted in reverse order */
+    for (int i=N-1; i >= 0; i--){
+        v[i].key = 2 * i;
+        skiplist_insert(sl, &v[i]);
+    }
+
+    /* range [21, 40]: 22, 24, ... 40 */
+    Item lo = {.key = 21};
+    Item hi = {.key = 40};
+    int n = 0;
+    for (Item *x = skiplist_seek(&it, sl, &lo);
+         x != NULL && item_cmp(x, &hi) <= 0;
+         skiplist_next(&it), x = skiplist_value(it)){
+        assert_true(x->key == 22 + 2 * n, "range value");
+        n++;
+    }
+    assert_true(n == 10, "range count");
+
+    /* lower bound on an existing key */
+    lo.key = 50;
+    assert_true(skiplist_seek(&it, sl, &lo) == &v[25], "seek existing");
+
+    /* seek before the first and after the last */
+    lo.key = -1;
+    assert_true(skiplist_seek(&it, sl, &lo) == &v[0], "seek before");
+    lo.key = 199;
+    assert_true(skiplist_seek(&it, sl, &lo) == NULL, "seek after");
+    assert_true(skiplist_exhausted(it), "seek after exhausted");
+    assert_false(skiplist_next(&it), "next exhausted");
+
+    free(v);
+    free(arena);
+}
+
+static
+void test_random()
+{
+    puts("skiplist/test_random");
+    const int M = 4096;
+    const int K = 512; /* keys domain, many duplicates */
+    uint8_t *arena = (uint8_t*)malloc(SKIPLIST_SIZEOF(M));
+    Item *v = (Item*)calloc(M, sizeof(Item));
+    int *count = (int*)calloc(K, sizeof(int));
+    SkipList *sl = skiplist_init(arena, M, item_cmp, 12345);
+    int order = 0;
+
+    for (int i=0; i < M; i++){
+        v[i].key = -1; /* not in the list */
+    }
+
+    for (int i=0; i < 50 * M; i++){
+        int j = rand() % M;
+        if (v[j].key < 0){
+            v[j].key = rand() % K;
+            v[j].order = order++;
+            assert_true(skiplist_insert(sl, &v[j]), "random insert");
+            count[v[j].key]++;
+        } else {
+            Item *d = skiplist_delete(sl, &v[j]);
+            assert_true(d != NULL, "random delete");
+            assert_true(d->key == v[j].key, "random delete key");
+            count[d->key]--;
+            d->key = -1;
+        }
+    }
+    assert_sorted(sl);
+
+    /* count the duplicates with a range scan for every key */
+    for (int k=0; k < K; k++){
+        Item key = {.key = k};
+        SkipListIter it;
+        int n = 0;
+        for (Item *x = skiplist_seek(&it, sl, &key);
+             x != NULL && x->key == k;
+             skiplist_next(&it), x = skiplist_value(it)){
+            n++;
+        }
+        assert_true(n == count[k], "random count");
+        assert_true((skiplist_find(sl, &key) != NULL) == (n > 0), "random find");
+    }
+
+    free(count);
+    free(v);
+    free(arena);
+}
+
+int main()
+{
+    test_init();
+    test_insert();
+    test_seek();
+    test_random();
+
+    puts("OK");
+
+    return 0;
+}
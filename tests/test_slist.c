@@ -1,5 +1,6 @@
 /* Test Single Linked List */
 
+#define DS_IMPLEMENTATION
 #include "slist.h"
 #include "asserts.h"
 #include <stdlib.h>
@@ -268,6 +269,323 @@ void test_random()
     free(arena);
 }
 
+typedef struct {
+    int key;
+    int order; /* insertion order, to check the stability */
+} SortItem;
+
+static
+int sort_cmp(const void *a, const void *b)
+{
+    const SortItem *x = a;
+    const SortItem *y = b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static
+void assert_sorted(SList *list, size_t len)
+{
+    SListIter it;
+    const SortItem *last = slist_iter(&it, list);
+    size_t n = 0;
+
+    while (!slist_exhausted(it)){
+        const SortItem *v = slist_value(it);
+        assert_true(sort_cmp(last, v) <= 0, "not sorted");
+        if (last->key == v->key){
+            assert_true(last->order <= v->order, "not stable");
+        }
+        last = v;
+        n++;
+        slist_next(&it);
+    }
+    assert_true(n == len, "sorted len");
+    assert_true(slist_len(list) == len, "sorted list len");
+}
+
+static
+void test_freelist()
+{
+    puts("slist/test_freelist");
+    SList *list = setup();
+    SListIter it;
+    int v[N];
+
+    /* [0,1,2,3,4] */
+    slist_iter(&it, list);
+    for (size_t i=0; i < N; i++){
+        v[i] = (int)i;
+        slist_insert(&it, &v[i]);
+    }
+    assert_true(slist_isfull(list), "full");
+
+    /* delete 2, 3, 0 in this order: [1,4] */
+    slist_iter(&it, list);
+    slist_next(&it);
+    slist_next(&it);
+    slist_delete(&it);
+    slist_delete(&it);
+    slist_iter(&it, list);
+    slist_delete(&it);
+    assert_true(slist_len(list) == 2, "len after delete");
+
+    /* the released items must be reused without touching the others */
+    slist_iter(&it, list);
+    for (size_t i=0; i < 3; i++){
+        assert_true(slist_insert(&it, &v[0]), "insert released");
+    }
+    assert_true(slist_isfull(list), "full again");
+    assert_false(slist_insert(&it, &v[0]), "insert full");
+
+    slist_iter(&it, list);
+    for (size_t i=0; i < 3; i++){
+        assert_true(slist_value(it) == &v[0], "reused value");
+        slist_next(&it);
+    }
+    assert_true(slist_value(it) == &v[1], "untouched value");
+    slist_next(&it);
+    assert_true(slist_value(it) == &v[4], "untouched value");
+    slist_next(&it);
+    assert_true(slist_exhausted(it), "reuse exhausted");
+
+    teardown(list);
+}
+
+static
+void test_sort()
+{
+    puts("slist/test_sort");
+    const int M = 1000;
+    SortItem *values = (SortItem*)calloc(M, sizeof(SortItem));
+    uint8_t *arena = (uint8_t*)malloc(SLIST_SIZEOF(M));
+    SList *list = slist_init(arena, M);
+    SListIter it;
+
+    /* empty and single item lists are untouched */
+    slist_sort(list, sort_cmp);
+    assert_true(slist_isempty(list), "sort empty");
+    values[0].key = 1;
+    slist_push(list, &values[0]);
+    slist_sort(list, sort_cmp);
+    assert_true(slist_pop(list) == &values[0], "sort single");
+
+    /* append with many duplicated keys */
+    slist_iter(&it, list);
+    for (int i=0; i < M; i++){
+        values[i].key = rand() % 50;
+        values[i].order = i;
+        assert_true(slist_insert(&it, &values[i]), "sort insert");
+    }
+
+    slist_sort(list, sort_cmp);
+    assert_sorted(list, M);
+
+    /* already sorted */
+    slist_sort(list, sort_cmp);
+    assert_sorted(list, M);
+
+    /* the list still works after the relink */
+    for (int i=0; i < M; i++){
+        assert_true(slist_pop(list) != NULL, "pop sorted");
+    }
+    assert_true(slist_isempty(list), "sorted empty");
+    assert_true(slist_push(list, &values[0]), "push after sort");
+
+    free(arena);
+    free(values);
+}
+
+static
+void test_merge()
+{
+    puts("slist/test_merge");
+    const int M = 100;
+    SortItem *values = (SortItem*)calloc(M, sizeof(SortItem));
+    uint8_t *arena = (uint8_t*)malloc(SLIST_SIZEOF(M));
+    uint8_t *other = (uint8_t*)malloc(SLIST_SIZEOF(M));
+    SList *list = slist_init(arena, M);
+    SList *alien = slist_init(other, M);
+    SList odd;
+    SListIter it, jt;
+
+    assert_false(slist_share(NULL, list), "share NULL");
+    assert_true(slist_share(&odd, list), "share");
+    assert_true(slist_isempty(&odd), "share empty");
+
+    /* even keys in list, odd keys in the shared one */
+    slist_iter(&it, list);
+    slist_iter(&jt, &odd);
+    for (int i=0; i < M; i++){
+        values[i].key = i / 2;
+        values[i].order = i;
+        if (i % 2 == 0){
+            assert_true(slist_insert(&it, &values[i]), "insert even");
+        } else {
+            assert_true(slist_insert(&jt, &values[i]), "insert odd");
+        }
+    }
+    assert_true(slist_isfull(list), "shared arena full");
+    assert_true(slist_isfull(&odd), "shared arena full");
+
+    assert_false(slist_merge(list, alien, sort_cmp), "merge other arena");
+    assert_false(slist_merge(list, list, sort_cmp), "merge itself");
+
+    assert_true(slist_merge(list, &odd, sort_cmp), "merge");
+    assert_true(slist_isempty(&odd), "merge source empty");
+    assert_sorted(list, M);
+
+    /* merge into an empty list */
+    assert_true(slist_merge(&odd, list, sort_cmp), "merge into empty");
+    assert_sorted(&odd, M);
+    assert_true(slist_isempty(list), "merge source empty");
+
+    /* items released by a list are available to the other */
+    assert_true(slist_pop(&odd) == &values[0], "pop shared");
+    assert_true(slist_push(list, &values[0]), "push released");
+
+    free(other);
+    free(arena);
+    free(values);
+}
+
+static
+void test_splice()
+{
+    puts("slist/test_splice");
+    SList *list = setup();
+    SList other;
+    SListIter it, jt;
+    int v[N];
+
+    slist_share(&other, list);
+
+    /* [0,3,4] and [1,2] */
+    slist_iter(&it, list);
+    slist_insert(&it, &v[0]);
+    slist_insert(&it, &v[3]);
+    slist_insert(&it, &v[4]);
+    slist_iter(&jt, &other);
+    slist_insert(&jt, &v[1]);
+    slist_insert(&jt, &v[2]);
+
+    assert_false(slist_splice(&it, list), "splice itself");
+
+    /* before v[3]: [0,1,2,3,4] */
+    slist_iter(&it, list);
+    slist_next(&it);
+    assert_true(slist_splice(&it, &other), "splice");
+    assert_true(slist_value(it) == &v[3], "splice iterator");
+    assert_true(slist_isempty(&other), "splice source empty");
+    assert_true(slist_len(list) == N, "splice len");
+
+    /* splice an empty list */
+    assert_true(slist_splice(&it, &other), "splice empty");
+
+    slist_iter(&it, list);
+    for (size_t i=0; i < N; i++){
+        assert_true(slist_value(it) == &v[i], "splice order");
+        slist_next(&it);
+    }
+    assert_true(slist_exhausted(it), "splice exhausted");
+
+    /* move everything at the head of the empty list */
+    slist_iter(&jt, &other);
+    assert_true(slist_splice(&jt, list), "splice head");
+    assert_true(slist_len(&other) == N, "splice head len");
+    assert_true(slist_pop(&other) == &v[0], "splice head value");
+
+    teardown(list);
+}
+
+
+static
+bool visit_sum(void *value, void *ctx)
+{
+    int *sum = ctx;
+    int v = *(int*)value;
+    if (v < 0){
+        return false; /* stop */
+    }
+    *sum += v;
+    return true;
+}
+
+static
+void test_foreach()
+{
+    puts("slist/test_foreach");
+    const int M = 100;
+    int *values = (int*)calloc(M, sizeof(int));
+    uint8_t *arena = (uint8_t*)malloc(SLIST_SIZEOF(M));
+    SList *list = slist_init(arena, M);
+    int sum = 0;
+
+    assert_true(slist_foreach(list, visit_sum, &sum) == 0, "foreach empty");
+    assert_true(slist_foreach(NULL, visit_sum, &sum) == 0, "foreach null");
+
+    for (int i=0; i < M; i++){
+        values[i] = i;
+        slist_push(list, &values[i]);
+    }
+
+    assert_true(slist_foreach(list, visit_sum, &sum) == (size_t)M, "foreach");
+    assert_true(sum == M * (M - 1) / 2, "foreach sum");
+
+    /* stop in the middle: the list is reversed, 49 is visited last */
+    values[49] = -1;
+    sum = 0;
+    assert_true(slist_foreach(list, visit_sum, &sum) == 51, "foreach stop");
+
+    free(arena);
+    free(values);
+}
+
+static
+void test_gather()
+{
+    puts("slist/test_gather");
+    const int M = 100;
+    const size_t K = 16;
+    int *values = (int*)calloc(M, sizeof(int));
+    uint8_t *arena = (uint8_t*)malloc(SLIST_SIZEOF(M + 1));
+    SList *list = slist_init(arena, M + 1);
+    SListIter it;
+    void *batch[16];
+
+    slist_iter(&it, list);
+    assert_true(slist_gather(&it, batch, K) == 0, "gather empty");
+
+    slist_iter(&it, list);
+    for (int i=0; i < M; i++){
+        values[i] = i;
+        slist_insert(&it, &values[i]);
+    }
+
+    /* batches in list order, the last one is partial */
+    int i = 0;
+    size_t n;
+    slist_iter(&it, list);
+    while ((n = slist_gather(&it, batch, K)) > 0){
+        for (size_t j=0; j < n; j++){
+            assert_true(*(int*)batch[j] == i, "gather value");
+            i++;
+        }
+    }
+    assert_true(i == M, "gather count");
+    assert_true(slist_exhausted(it), "gather exhausted");
+
+    /* the iterator can be used after the gather: insert the 5th */
+    slist_iter(&it, list);
+    assert_true(slist_gather(&it, batch, 4) == 4, "gather 4");
+    assert_true(slist_value(it) == &values[4], "gather iterator");
+    assert_true(slist_insert(&it, &values[0]), "insert after gather");
+    slist_iter(&it, list);
+    slist_gather(&it, batch, 5);
+    assert_true(batch[4] == &values[0], "insert after gather");
+
+    free(arena);
+    free(values);
+}
 
 int main()
 {
@@ -277,6 +595,12 @@ int main()
     test_append();
     test_mix();
     test_random();
+    test_freelist();
+    test_sort();
+    test_merge();
+    test_splice();
+    test_foreach();
+    test_gather();
 
     puts("OK");
 
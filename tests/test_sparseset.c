@@ -0,0 +1,139 @@
+/* Test Sparse Set */
+
+#define DS_IMPLEMENTATION
+#include "sparseset.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UNIVERSE 1000
+#define CAPACITY 100
+
+static void test_init()
+{
+    puts("sparseset/test_init");
+
+    void *arena = malloc(SPARSESET_SIZEOF(UNIVERSE, CAPACITY));
+    assert_true(sparseset_init(NULL, UNIVERSE, CAPACITY) == NULL, "null");
+    assert_true(sparseset_init(arena, 0, CAPACITY) == NULL, "universe 0");
+    assert_true(sparseset_init(arena, UNIVERSE, 0) == NULL, "capacity 0");
+    assert_true(sparseset_init(arena, 10, 11) == NULL, "capacity > universe");
+
+    SparseSet *s = sparseset_init(arena, UNIVERSE, CAPACITY);
+    assert_true(s != NULL, "init");
+    assert_true(sparseset_isempty(s), "empty");
+    assert_false(sparseset_contains(s, 0), "contains empty");
+    assert_true(sparseset_at(s, 0) == SPARSESET_NIL, "at empty");
+
+    assert_true(sparseset_len(NULL) == 0, "len null");
+    assert_false(sparseset_insert(NULL, 0), "insert null");
+    assert_false(sparseset_remove(NULL, 0), "remove null");
+    assert_false(sparseset_contains(NULL, 0), "contains null");
+
+    free(arena);
+}
+
+static void test_ops()
+{
+    puts("sparseset/test_ops");
+
+    SparseSet *s = sparseset_init(malloc(SPARSESET_SIZEOF(UNIVERSE, 4)),
+                                  UNIVERSE, 4);
+    assert_true(sparseset_insert(s, 7), "insert 7");
+    assert_true(sparseset_insert(s, 999), "insert 999");
+    assert_true(sparseset_insert(s, 0), "insert 0");
+    assert_false(sparseset_insert(s, 7), "insert twice");
+    assert_false(sparseset_insert(s, UNIVERSE), "out of range");
+    assert_true(sparseset_insert(s, 3), "insert 3");
+    assert_true(sparseset_isfull(s), "full");
+    assert_false(sparseset_insert(s, 4), "insert full");
+
+    /* dense in insertion order, the last one fills the hole */
+    const size_t *d = sparseset_dense(s);
+    assert_true(d[0] == 7 && d[1] == 999 && d[2] == 0 && d[3] == 3, "dense");
+    assert_true(sparseset_remove(s, 999), "remove 999");
+    assert_false(sparseset_remove(s, 999), "remove twice");
+    assert_false(sparseset_contains(s, 999), "removed");
+    assert_true(sparseset_at(s, 1) == 3 && sparseset_len(s) == 3, "moved");
+    assert_true(sparseset_remove(s, 3), "remove last");
+    assert_true(sparseset_contains(s, 7) && sparseset_contains(s, 0), "left");
+
+    /* remove while iterating from the last */
+    for (size_t i = sparseset_len(s); i > 0; i--){
+        assert_true(sparseset_remove(s, sparseset_at(s, i - 1)), "remove it");
+    }
+    assert_true(sparseset_isempty(s), "empty");
+
+    /* the stale positions after clear are not members */
+    sparseset_insert(s, 5);
+    sparseset_insert(s, 6);
+    sparseset_clear(s);
+    assert_true(sparseset_len(s) == 0, "clear");
+    assert_false(sparseset_contains(s, 5), "cleared 5");
+    assert_true(sparseset_insert(s, 6), "insert after clear");
+    assert_false(sparseset_contains(s, 5), "stale 5");
+    assert_true(sparseset_remove(s, 6), "remove 6");
+
+    free(s);
+}
+
+static void test_random()
+{
+    puts("sparseset/test_random");
+
+    bool ref[UNIVERSE] = {false};
+    size_t len = 0;
+    SparseSet *s = sparseset_init(malloc(SPARSESET_SIZEOF(UNIVERSE, CAPACITY)),
+                                  UNIVERSE, CAPACITY);
+
+    srand(7);
+    for (int op=0; op < 100000; op++){
+        size_t id = (size_t)rand() % UNIVERSE;
+        int r = rand() % 1000;
+        if (r == 0){
+            sparseset_clear(s);
+            for (size_t k=0; k < UNIVERSE; k++){
+                ref[k] = false;
+            }
+            len = 0;
+        } else if (r < 500){
+            bool ok = sparseset_insert(s, id);
+            assert_true(ok == (!ref[id] && len < CAPACITY), "insert");
+            if (ok){
+                ref[id] = true;
+                len++;
+            }
+        } else {
+            bool ok = sparseset_remove(s, id);
+            assert_true(ok == ref[id], "remove");
+            if (ok){
+                ref[id] = false;
+                len--;
+            }
+        }
+        assert_true(sparseset_len(s) == len, "len");
+        assert_true(sparseset_contains(s, id) == ref[id], "contains");
+    }
+
+    /* the dense array has exactly the members */
+    size_t n = 0;
+    for (size_t i=0; i < sparseset_len(s); i++){
+        assert_true(ref[sparseset_at(s, i)], "member");
+        n++;
+    }
+    assert_true(n == len, "count");
+
+    free(s);
+}
+
+int main()
+{
+    test_init();
+    test_ops();
+    test_random();
+
+    puts("OK");
+    return 0;
+}
@@ -1,3 +1,4 @@
+#define DS_IMPLEMENTATION
 #include "stack.h"
 #include "asserts.h"
 #include <stdlib.h>
@@ -43,8 +44,49 @@ bool stacki_pop(StackInt *s, int *x)
     return true;
 }
 
+DS_DEFINE_STACK(IntStack, int)
+
+static void test_define()
+{
+    puts("stack/test_define");
+
+    int buf[4];
+    IntStack s;
+    int x = -1;
+
+    assert_false(IntStack_init(&s, NULL, 4), "init NULL");
+    assert_false(IntStack_init(&s, buf, 0), "init 0");
+    assert_true(IntStack_init(&s, buf, 4), "init");
+    assert_true(IntStack_isempty(&s), "empty");
+    assert_true(IntStack_top(&s) == NULL, "top empty");
+    assert_false(IntStack_pop(&s, &x), "pop empty");
+    assert_true(x == -1, "untouched x");
+
+    assert_true(IntStack_push(&s, 1), "push");
+    assert_true(IntStack_push(&s, 2), "push");
+    assert_true(*IntStack_top(&s) == 2, "top");
+    assert_true(IntStack_pop(&s, &x) && x == 2, "pop");
+    assert_true(IntStack_len(&s) == 1, "len");
+
+    /* batch: only 3 of 5 fit */
+    int src[5] = {10, 11, 12, 13, 14};
+    assert_true(IntStack_push_n(&s, src, 5) == 3, "push_n");
+    assert_true(IntStack_isfull(&s), "full");
+    assert_false(IntStack_push(&s, 3), "push full");
+
+    int dst[5];
+    assert_true(IntStack_pop_n(&s, dst, 2) == 2, "pop_n");
+    assert_true(dst[0] == 11 && dst[1] == 12, "pop_n order");
+    assert_true(IntStack_pop_n(&s, dst, 5) == 2, "pop_n rest");
+    assert_true(dst[0] == 1 && dst[1] == 10, "pop_n rest order");
+    assert_true(IntStack_isempty(&s), "empty again");
+}
+
+
 int main()
 {
+    test_define();
+
     StackInt stack;
     stacki_init(&stack, 3);
     assert_true(stack_isempty(&stack.index), "init empty");
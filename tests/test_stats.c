@@ -0,0 +1,197 @@
+/* Test Statistics and Hooks */
+
+#include <stddef.h>
+#include <string.h>
+
+/* trace the operations */
+static size_t hook_enter;
+static size_t hook_exit;
+static size_t hook_fail;
+static const char *hook_last;
+
+#define DS_HOOK_ENTER(op, obj) ((void)(obj), hook_enter++, hook_last = (op))
+#define DS_HOOK_EXIT(op, obj, ok) ((void)(obj), (void)(op), hook_exit++, \
+                                   hook_fail += !(ok))
+
+#define DS_STATS
+#define DS_IMPLEMENTATION
+#include "objpool.h"
+#include "queue.h"
+#include "stack.h"
+#include "slist.h"
+#include "range.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 4
+
+static void hooks_reset()
+{
+    hook_enter = 0;
+    hook_exit = 0;
+    hook_fail = 0;
+    hook_last = NULL;
+}
+
+static void test_objpool()
+{
+    puts("stats/test_objpool");
+
+    ObjPool pool;
+    void *arena = malloc(OBJPOOL_SIZEOF(N, sizeof(size_t)));
+    void *obj[N + 1];
+    hooks_reset();
+
+    objpool_init(&pool, arena, N, sizeof(size_t));
+    for (int i=0; i <= N; i++){
+        obj[i] = objpool_acquire(&pool);
+    }
+    objpool_release(&pool, obj[0]);
+
+    DSStats s = objpool_stats(&pool);
+    assert_true(s.ops == N + 2, "ops");
+    assert_true(s.fails == 1, "fails");
+    assert_true(s.hwm == N, "hwm");
+    assert_true(hook_enter == N + 2 && hook_exit == N + 2, "hooks");
+    assert_true(hook_fail == 1, "hook fail");
+    assert_true(strcmp(hook_last, "objpool_release") == 0, "hook op");
+
+    objpool_stats_reset(&pool);
+    s = objpool_stats(&pool);
+    assert_true(s.ops == 0 && s.fails == 0, "reset");
+    assert_true(s.hwm == N - 1, "reset hwm is len");
+
+    s = objpool_stats(NULL);
+    assert_true(s.ops == 0 && s.hwm == 0, "NULL snapshot");
+
+    free(arena);
+}
+
+static void test_queue_stack()
+{
+    puts("stats/test_queue_stack");
+
+    QueueIndex q;
+    StackIndex st;
+    hooks_reset();
+
+    queue_init(&q, N);
+    stack_init(&st, N);
+    for (int i=0; i < N + 1; i++){
+        queue_enqueue(&q);
+        stack_push(&st);
+    }
+    for (int i=0; i < N + 2; i++){
+        queue_dequeue(&q);
+        stack_pop(&st);
+    }
+
+    DSStats s = queue_stats(&q);
+    assert_true(s.ops == 2 * N + 3, "queue ops");
+    assert_true(s.fails == 3, "queue fails");
+    assert_true(s.hwm == N, "queue hwm");
+
+    s = stack_stats(&st);
+    assert_true(s.ops == 2 * N + 3, "stack ops");
+    assert_true(s.fails == 3, "stack fails");
+    assert_true(s.hwm == N, "stack hwm");
+
+    assert_true(hook_enter == 2 * (2 * N + 3), "hooks");
+    assert_true(hook_fail == 6, "hook fails");
+
+    stack_stats_reset(&st);
+    queue_stats_reset(&q);
+    assert_true(queue_stats(&q).ops == 0, "queue reset");
+    assert_true(stack_stats(&st).hwm == 0, "stack reset");
+}
+
+static void test_slist()
+{
+    puts("stats/test_slist");
+
+    int v[N];
+    SList *list = slist_init(malloc(SLIST_SIZEOF(N)), N);
+    SList *other = malloc(sizeof(SList));
+    slist_share(other, list);
+
+    for (int i=0; i < N; i++){
+        assert_true(slist_push((i % 2)?other:list, &v[i]), "push");
+    }
+    assert_false(slist_push(list, &v[0]), "push full");
+    slist_pop(other);
+
+    DSStats s = slist_stats(list);
+    assert_true(s.ops == N / 2 + 1 && s.fails == 1, "list ops");
+    assert_true(s.hwm == N / 2, "list hwm");
+
+    /* the splice raises the high-water mark */
+    SListIter it;
+    slist_iter(&it, list);
+    slist_splice(&it, other);
+    assert_true(slist_stats(list).hwm == N - 1, "splice hwm");
+
+    s = slist_stats(other);
+    assert_true(s.ops == N / 2 + 1 && s.fails == 0, "other ops");
+
+    while (slist_pop(list) != NULL){
+    }
+    assert_true(slist_stats(list).fails == 2, "pop empty");
+
+    free(other);
+    free(list);
+}
+
+static int calls;
+
+static RangeType clamp(Range r, RangeType i)
+{
+    calls++;
+    return (i < r.start)?r.start:r.end;
+}
+
+static void test_range()
+{
+    puts("stats/test_range");
+
+    DSStats st = {0, 0, 0, 0};
+    Range r = range_init("Test", -2, 2, clamp);
+    Range plain = range_init("Plain", 0, 3, NULL);
+
+    assert_true(range_stats(r).ops == 0, "no counters");
+    range_at(r, 0); /* not counted */
+
+    range_set_stats(&r, &st);
+    range_at(r, 0);
+    range_at(r, 5);
+    range_of(r, 10);
+
+    RangeType in[6] = {-3, -2, 0, 2, 3, 1};
+    size_t out[6];
+    range_at_n(r, in, out, 6);
+    range_in_n(r, in, NULL, 6);
+
+    DSStats s = range_stats(r);
+    assert_true(s.ops == 15, "range ops");
+    assert_true(s.fails == 6, "range fails");
+    assert_true(s.clbks == 4, "range clbks");
+    assert_true(calls == 4, "callback calls");
+
+    /* without callback the violations are still counted */
+    range_set_stats(&plain, &st);
+    range_at(plain, 9);
+    assert_true(st.fails == 7 && st.clbks == 4, "no callback");
+}
+
+int main()
+{
+    test_objpool();
+    test_queue_stack();
+    test_slist();
+    test_range();
+
+    puts("OK");
+    return 0;
+}
@@ -0,0 +1,244 @@
+/* Test Hierarchical Timer Wheel */
+
+#define DS_IMPLEMENTATION
+#include "timerwheel.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 2000
+
+typedef struct {
+    uint64_t expected[N]; /* expiration of the handle, 0 if none */
+    size_t fired;
+    uint64_t last;        /* tick of the last expiration */
+    TimerWheel *tw;
+    bool reschedule;
+} Check;
+
+static void on_expire(size_t handle, uint64_t now, void *ctx)
+{
+    Check *c = ctx;
+    assert_true(handle < N && c->expected[handle] != 0, "expected handle");
+    /* on time, the expired ones at the first tick */
+    assert_true(c->expected[handle] == now || c->expected[handle] < c->last,
+                "on time");
+    assert_true(now >= c->last, "in order");
+    c->last = now;
+    c->expected[handle] = 0;
+    c->fired++;
+
+    if (c->reschedule){
+        size_t h = timerwheel_schedule(c->tw, now + 100);
+        assert_true(h == handle, "reuse handle");
+        c->expected[h] = now + 100;
+        c->reschedule = false;
+    }
+}
+
+static void test_init()
+{
+    puts("timerwheel/test_init");
+
+    void *arena = malloc(TIMERWHEEL_SIZEOF(2));
+    assert_true(timerwheel_init(NULL, 2, 0) == NULL, "arena null");
+    assert_true(timerwheel_init(arena, 0, 0) == NULL, "capacity 0");
+
+    TimerWheel *tw = timerwheel_init(arena, 2, 100);
+    assert_true(tw != NULL, "init");
+    assert_true(timerwheel_len(tw) == 0, "empty");
+
+    size_t a = timerwheel_schedule(tw, 150);
+    size_t b = timerwheel_schedule(tw, 50);
+    assert_true(a != TIMERWHEEL_NIL && b != TIMERWHEEL_NIL, "schedule");
+    assert_true(timerwheel_schedule(tw, 200) == TIMERWHEEL_NIL, "full");
+    assert_true(timerwheel_expires(tw, a) == 150, "expires");
+    assert_true(timerwheel_pending(tw, b), "pending");
+
+    assert_true(timerwheel_cancel(tw, a), "cancel");
+    assert_false(timerwheel_cancel(tw, a), "cancel twice");
+    assert_false(timerwheel_pending(tw, a), "not pending");
+    assert_true(timerwheel_expires(tw, a) == UINT64_MAX, "expires cancelled");
+
+    /* the expired one fires at the next tick */
+    assert_true(timerwheel_advance(tw, 100, NULL, NULL) == 0, "no advance");
+    assert_true(timerwheel_advance(tw, 101, NULL, NULL) == 1, "past timer");
+    assert_true(timerwheel_len(tw) == 0, "empty again");
+
+    assert_true(timerwheel_len(NULL) == 0, "len null");
+    assert_true(timerwheel_schedule(NULL, 1) == TIMERWHEEL_NIL, "null");
+    assert_false(timerwheel_cancel(NULL, 0), "cancel null");
+    assert_true(timerwheel_advance(NULL, 1, NULL, NULL) == 0, "advance null");
+
+    free(arena);
+}
+
+static void test_expire()
+{
+    puts("timerwheel/test_expire");
+
+    static Check c;
+    TimerWheel *tw = timerwheel_init(malloc(TIMERWHEEL_SIZEOF(N)), N, 1000);
+    c.tw = tw;
+    c.last = 0;
+
+    /* every level, the range limit and beyond */
+    const uint64_t range = (uint64_t)1 << (TIMERWHEEL_BITS * TIMERWHEEL_LEVELS);
+    const uint64_t delays[] = {
+        1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 262143, 262144,
+        range - 1, range, range + 1, 3 * range + 17
+    };
+    const size_t k = sizeof(delays) / sizeof(delays[0]);
+    for (size_t i=0; i < k; i++){
+        size_t h = timerwheel_schedule(tw, 1000 + delays[i]);
+        c.expected[h] = 1000 + delays[i];
+    }
+
+    /* one tick at a time for the first levels */
+    for (uint64_t t=1001; t <= 1000 + 5000; t++){
+        timerwheel_advance(tw, t, on_expire, &c);
+    }
+    assert_true(c.fired == 10, "fired by tick");
+
+    /* big steps for the others */
+    size_t n = timerwheel_advance(tw, 1000 + 4 * range, on_expire, &c);
+    assert_true(n == k - 10 && c.fired == k, "fired all");
+    assert_true(timerwheel_len(tw) == 0, "empty");
+
+    free(tw);
+}
+
+static void test_random()
+{
+    puts("timerwheel/test_random");
+
+    static Check c;
+    TimerWheel *tw = timerwheel_init(malloc(TIMERWHEEL_SIZEOF(N)), N, 0);
+    c.tw = tw;
+    c.last = 0;
+    c.fired = 0;
+    size_t scheduled = 0;
+    size_t cancelled = 0;
+    uint64_t now = 0;
+
+    srand(3);
+    for (size_t round=0; round < 200; round++){
+        for (int j=0; j < 20; j++){
+            uint64_t delay = (uint64_t)(rand() % 4) == 0 ?
+                             (uint64_t)rand() % 300000 : (uint64_t)rand() % 500;
+            size_t h = timerwheel_schedule(tw, now + delay);
+            if (h == TIMERWHEEL_NIL){
+                break;
+            }
+            assert_true(c.expected[h] == 0, "free handle");
+            c.expected[h] = (delay == 0)?now + 1:now + delay;
+            scheduled++;
+        }
+        /* cancel some */
+        for (int j=0; j < 5; j++){
+            size_t h = (size_t)rand() % N;
+            if (c.expected[h] != 0){
+                assert_true(timerwheel_cancel(tw, h), "cancel pending");
+                c.expected[h] = 0;
+                cancelled++;
+            } else {
+                assert_false(timerwheel_cancel(tw, h), "cancel free");
+            }
+        }
+        c.reschedule = (round % 10 == 0);
+        if (c.reschedule){
+            scheduled++;
+        }
+        now += (uint64_t)rand() % 1000;
+        timerwheel_advance(tw, now, on_expire, &c);
+        c.reschedule = false;
+
+        /* nothing pending is late */
+        for (size_t h=0; h < N; h++){
+            assert_true(c.expected[h] == 0 || c.expected[h] > now,
+                        "nothing late");
+        }
+    }
+    timerwheel_advance(tw, now + 400000, on_expire, &c);
+    assert_true(timerwheel_len(tw) == 0, "all expired");
+    assert_true(c.fired + cancelled <= scheduled, "counts");
+
+    free(tw);
+}
+
+typedef struct {
+    TimerWheel *tw;
+    size_t other;  /* handle to cancel at the first expiration */
+    size_t fired[4];
+    size_t n;
+    size_t again;  /* handle scheduled by the callback */
+} Chain;
+
+static void on_chain(size_t handle, uint64_t now, void *ctx)
+{
+    Chain *c = ctx;
+    assert_false(timerwheel_pending(c->tw, handle), "released");
+    assert_true(c->n < 4, "fired too many");
+    c->fired[c->n++] = handle;
+
+    if (c->n == 1){
+        /* the other timer of the same tick */
+        assert_true(timerwheel_cancel(c->tw, c->other), "cancel in cb");
+        assert_false(timerwheel_cancel(c->tw, handle), "cancel expired");
+        /* already expired: the next tick */
+        c->again = timerwheel_schedule(c->tw, now);
+        assert_true(c->again != TIMERWHEEL_NIL, "schedule in cb");
+    }
+}
+
+static void test_callback()
+{
+    puts("timerwheel/test_callback");
+
+    static Chain c;
+    TimerWheel *tw = timerwheel_init(malloc(TIMERWHEEL_SIZEOF(4)), 4, 0);
+    c.tw = tw;
+
+    size_t a = timerwheel_schedule(tw, 5);
+    size_t b = timerwheel_schedule(tw, 5);
+    size_t d = timerwheel_schedule(tw, 5);
+    /* the last scheduled is the first expired (head of the slot), cancel
+     * the next one
+     */
+    c.other = b;
+
+    assert_true(timerwheel_advance(tw, 5, on_chain, &c) == 2, "tick 5");
+    assert_true(c.n == 2 && c.fired[0] == d && c.fired[1] == a, "fired");
+    /* the handle of the cancelled one is reused by the schedule */
+    assert_true(c.again == b, "cancelled and reused");
+    assert_true(timerwheel_len(tw) == 1, "len");
+    assert_true(timerwheel_expires(tw, c.again) == 5, "rescheduled");
+
+    assert_true(timerwheel_advance(tw, 6, on_chain, &c) == 1, "tick 6");
+    assert_true(c.n == 3 && c.fired[2] == c.again, "fired again");
+    assert_true(timerwheel_len(tw) == 0, "empty");
+
+    /* the free list is sane: all the handles come back once */
+    bool seen[4] = {false};
+    for (int k=0; k < 4; k++){
+        size_t h = timerwheel_schedule(tw, 10);
+        assert_true(h < 4 && !seen[h], "handle reuse");
+        seen[h] = true;
+    }
+    assert_true(timerwheel_schedule(tw, 10) == TIMERWHEEL_NIL, "full");
+
+    free(tw);
+}
+
+int main()
+{
+    test_init();
+    test_expire();
+    test_random();
+    test_callback();
+
+    puts("OK");
+    return 0;
+}
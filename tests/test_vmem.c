@@ -0,0 +1,95 @@
+/* Test Virtual Memory regions */
+
+#define DS_IMPLEMENTATION
+#include "vmem.h"
+#include "arena.h"
+#include "slist.h"
+#include "asserts.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define N 100000
+
+static void check(VMem *m, size_t size)
+{
+    assert_true(m->base != NULL, "base");
+    assert_true(m->size >= size, "usable size");
+    assert_true(m->size % m->page == 0, "whole pages");
+    assert_true((uintptr_t)m->base % m->page == 0, "aligned");
+
+    /* zero filled and writable */
+    uint8_t *b = m->base;
+    assert_true(b[0] == 0 && b[m->size - 1] == 0, "zero");
+    b[0] = 1;
+    b[m->size - 1] = 2;
+
+    /* the prefault keeps the content */
+    assert_true(vmem_prefault(m, 3) == m->size / m->page, "prefault");
+    assert_true(b[0] == 1 && b[m->size - 1] == 2, "content");
+}
+
+static void test_map()
+{
+    puts("vmem/test_map");
+
+    VMem m;
+    assert_false(vmem_map(NULL, 1, 0), "map null");
+    assert_false(vmem_map(&m, 0, 0), "map empty");
+    assert_false(vmem_map(&m, SIZE_MAX, 0), "map too big");
+    vmem_unmap(NULL);
+    assert_true(vmem_prefault(NULL, 1) == 0, "prefault null");
+
+    const unsigned flags[] = {
+        0, VMEM_POPULATE, VMEM_THP, VMEM_THP | VMEM_POPULATE, VMEM_HUGETLB,
+        VMEM_HUGETLB | VMEM_THP | VMEM_POPULATE
+    };
+    for (size_t i=0; i < sizeof(flags) / sizeof(flags[0]); i++){
+        size_t size = 3 * VMEM_HUGE_PAGE + 1;
+        assert_true(vmem_map(&m, size, flags[i]), "map");
+        /* the applied flags are among the requested */
+        assert_true((m.flags & ~flags[i]) == 0, "flags");
+        /* only the explicit huge pages are sure */
+        assert_true((m.flags & VMEM_HUGETLB) || m.page < VMEM_HUGE_PAGE,
+                    "huge page");
+        check(&m, size);
+        vmem_unmap(&m);
+        assert_true(m.base == NULL, "unmap");
+        vmem_unmap(&m);
+    }
+}
+
+static void test_slist()
+{
+    puts("vmem/test_slist");
+
+    VMem m;
+    assert_true(vmem_map(&m, ARENA_SIZEOF(SLIST_SIZEOF(N)), VMEM_THP),
+                "map");
+    Arena a;
+    assert_true(arena_init(&a, m.base, m.size), "arena");
+    SList *list = slist_init(arena_push(&a, SLIST_SIZEOF(N)), N);
+    assert_true(list != NULL, "slist");
+
+    static int values[N];
+    for (int i=0; i < N; i++){
+        values[i] = i;
+        assert_true(slist_push(list, &values[i]), "push");
+    }
+    for (int i=N-1; i >= 0; i--){
+        int *v = slist_pop(list);
+        assert_true(v != NULL && *v == i, "pop");
+    }
+
+    vmem_unmap(&m);
+}
+
+int main()
+{
+    test_map();
+    test_slist();
+
+    puts("OK");
+    return 0;
+}
@@ -0,0 +1,350 @@
+#ifndef _DS_TIMERWHEEL_H
+#define _DS_TIMERWHEEL_H
+
+/* Hierarchical Timer Wheel on memory arena.
+ * Namespace: timerwheel
+ *
+ * Timers expiring at an absolute tick (uint64_t, the unit is chosen by the
+ * user), identified by handles: the indexes of their nodes in the arena.
+ * Every level has TIMERWHEEL_SLOTS slots, a slot of the level l covers
+ * TIMERWHEEL_SLOTS^l ticks: a timer goes in the lowest level that reaches
+ * its expiration and moves down (cascade) when the lower level wraps.
+ * The slots are doubly linked lists of nodes by index, with a free list of
+ * nodes as slist.h: schedule and cancel are O(1).
+ * A bitmap of the non empty slots of every level lets timerwheel_advance
+ * skip the empty ticks, so a long advance costs the slots with timers and
+ * the cascades, not the ticks.
+ * The timers beyond the range of the levels wait in the last slots and are
+ * placed again at every cascade.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* the corresponding value for NULL in size_t indexes is SIZE_MAX */
+#define TIMERWHEEL_NIL SIZE_MAX
+/* slots of a level, bits of the tick per level */
+#define TIMERWHEEL_SLOTS 64
+#define TIMERWHEEL_BITS 6
+/* levels, TIMERWHEEL_SLOTS^TIMERWHEEL_LEVELS ticks in range (2^24) */
+#ifndef TIMERWHEEL_LEVELS
+#define TIMERWHEEL_LEVELS 4
+#endif
+#define TIMERWHEEL_SIZEOF(n) ( sizeof(TimerWheel) + \
+        (sizeof(TimerWheelNode) * (size_t)(n)) )
+
+typedef struct TimerWheel TimerWheel;
+typedef struct TimerWheelNode TimerWheelNode;
+
+/* Handle an expired timer during timerwheel_advance.
+ * The timer is already released: its handle can be reused by a schedule.
+ * now is the tick of the expiration being processed.
+ * ctx is the user pointer passed to timerwheel_advance.
+ */
+typedef void (*TimerWheelExpire)(size_t handle, uint64_t now, void *ctx);
+
+struct TimerWheelNode {
+    size_t next;      /* next node in the slot (or in the free list) */
+    size_t prev;      /* previous node in the slot */
+    size_t slot;      /* slot of the node, TIMERWHEEL_NIL if not scheduled */
+    uint64_t expires; /* tick of the expiration */
+};
+
+struct TimerWheel {
+    size_t size;    /* capacity */
+    size_t len;     /* number of scheduled timers */
+    size_t free;    /* index of the free list head node */
+    size_t used;    /* nodes never allocated are in [used, size) */
+    uint64_t now;   /* last tick processed */
+    uint64_t occupied[TIMERWHEEL_LEVELS]; /* bit per non empty slot */
+    size_t head[TIMERWHEEL_LEVELS * TIMERWHEEL_SLOTS]; /* first node */
+    TimerWheelNode *nodes; /* array of 'size' nodes */
+};
+
+/* Construct an empty wheel of indicated capacity into the memory arena,
+ * with now as the current tick.
+ * The arena must be at least TIMERWHEEL_SIZEOF(capacity) long
+ * otherwise the behavior is undefined.
+ * No aditional memory is allocated.
+ * Time complexity: O(1)
+ * Returns the pointer to the wheel in the arena or NULL in case of errors
+ */
+TimerWheel * timerwheel_init(void *arena, size_t capacity, uint64_t now);
+
+/* Move the current tick to now, expiring in order of tick the timers up
+ * to now: cb is called for every one (it can schedule and cancel).
+ * Time complexity: O(expired + cascaded + (now - prev now) / SLOTS)
+ * Return the number of expired timers.
+ */
+size_t timerwheel_advance(TimerWheel *tw, uint64_t now, TimerWheelExpire cb,
+                          void *ctx);
+
+/* Number of scheduled timers.
+ * Time complexity: O(1)
+ */
+static inline size_t timerwheel_len(const TimerWheel *tw)
+{
+    if (tw == NULL){
+        return 0;
+    }
+    return tw->len;
+} /* timerwheel_len */
+
+/* Return true if the handle refers to a scheduled timer */
+static inline bool timerwheel_pending(const TimerWheel *tw, size_t handle)
+{
+    if (tw == NULL || handle >= tw->used){
+        return false;
+    }
+    return tw->nodes[handle].slot != TIMERWHEEL_NIL;
+} /* timerwheel_pending */
+
+/* Tick of the expiration of a scheduled timer, UINT64_MAX if not pending */
+static inline uint64_t timerwheel_expires(const TimerWheel *tw, size_t handle)
+{
+    if (!timerwheel_pending(tw, handle)){
+        return UINT64_MAX;
+    }
+    return tw->nodes[handle].expires;
+} /* timerwheel_expires */
+
+/* Internal use.
+ * Link the node in the slot of the wheel for its expiration, not before the
+ * tick first (the first tick not yet processed).
+ */
+static inline void _timerwheel_place(TimerWheel *tw, size_t ind,
+                                     uint64_t first)
+{
+    TimerWheelNode *n = &tw->nodes[ind];
+    uint64_t at = (n->expires > first)?n->expires:first;
+    uint64_t delta = at - tw->now;
+
+    size_t l = 0;
+    while (l < TIMERWHEEL_LEVELS - 1 &&
+           delta >= ((uint64_t)1 << (TIMERWHEEL_BITS * (l + 1)))){
+        l++;
+    }
+    /* beyond the range: the farthest slot, placed again at its cascade */
+    if (delta >= ((uint64_t)1 << (TIMERWHEEL_BITS * (l + 1)))){
+        at = tw->now + ((uint64_t)1 << (TIMERWHEEL_BITS * (l + 1))) - 1;
+    }
+
+    size_t s = (size_t)(at >> (TIMERWHEEL_BITS * l)) & (TIMERWHEEL_SLOTS - 1);
+    size_t slot = l * TIMERWHEEL_SLOTS + s;
+
+    n->slot = slot;
+    n->prev = TIMERWHEEL_NIL;
+    n->next = tw->head[slot];
+    if (n->next != TIMERWHEEL_NIL){
+        tw->nodes[n->next].prev = ind;
+    }
+    tw->head[slot] = ind;
+    tw->occupied[l] |= (uint64_t)1 << s;
+} /* _timerwheel_place */
+
+/* Internal use.
+ * Unlink the node from its slot.
+ */
+static inline void _timerwheel_unlink(TimerWheel *tw, size_t ind)
+{
+    TimerWheelNode *n = &tw->nodes[ind];
+    size_t slot = n->slot;
+
+    if (n->prev != TIMERWHEEL_NIL){
+        tw->nodes[n->prev].next = n->next;
+    } else {
+        tw->head[slot] = n->next;
+        if (n->next == TIMERWHEEL_NIL){
+            tw->occupied[slot / TIMERWHEEL_SLOTS] &=
+                ~((uint64_t)1 << (slot % TIMERWHEEL_SLOTS));
+        }
+    }
+    if (n->next != TIMERWHEEL_NIL){
+        tw->nodes[n->next].prev = n->prev;
+    }
+    n->slot = TIMERWHEEL_NIL;
+} /* _timerwheel_unlink */
+
+/* Internal use.
+ * Put the node in the free list.
+ */
+static inline void _timerwheel_release(TimerWheel *tw, size_t ind)
+{
+    tw->nodes[ind].next = tw->free;
+    tw->free = ind;
+    tw->len--;
+} /* _timerwheel_release */
+
+/* Schedule a timer expiring at the tick expires (absolute). A timer
+ * already expired (expires <= current tick) expires at the next advance.
+ * Time complexity: O(1)
+ * Return the handle or TIMERWHEEL_NIL if the wheel is full.
+ */
+static inline size_t timerwheel_schedule(TimerWheel *tw, uint64_t expires)
+{
+    if (tw == NULL){
+        return TIMERWHEEL_NIL;
+    }
+
+    size_t ind;
+    if (tw->free != TIMERWHEEL_NIL){
+        ind = tw->free;
+        tw->free = tw->nodes[ind].next;
+    } else if (tw->used < tw->size){
+        ind = tw->used;
+        tw->used++;
+    } else {
+        return TIMERWHEEL_NIL;
+    }
+
+    /* the expired ones go in the next tick */
+    tw->nodes[ind].expires = expires;
+    _timerwheel_place(tw, ind, tw->now + 1);
+    tw->len++;
+    return ind;
+} /* timerwheel_schedule */
+
+/* Cancel a scheduled timer, its handle is released.
+ * Time complexity: O(1)
+ * Return false if the handle is not pending.
+ */
+static inline bool timerwheel_cancel(TimerWheel *tw, size_t handle)
+{
+    if (!timerwheel_pending(tw, handle)){
+        return false;
+    }
+
+    _timerwheel_unlink(tw, handle);
+    _timerwheel_release(tw, handle);
+    return true;
+} /* timerwheel_cancel */
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_TIMERWHEEL_IMPL)
+#define _DS_TIMERWHEEL_IMPL
+
+TimerWheel * timerwheel_init(void *arena, size_t capacity, uint64_t now)
+{
+    if (arena == NULL || capacity == 0 || capacity == TIMERWHEEL_NIL){
+        return NULL;
+    }
+
+    /* point to the end of the TimerWheel struct */
+    uint8_t *mem = (uint8_t*)arena;
+    mem = &mem[sizeof(TimerWheel)];
+
+    TimerWheel *tw = (TimerWheel*)arena;
+    tw->size = capacity;
+    tw->len = 0;
+    tw->free = TIMERWHEEL_NIL;
+    tw->used = 0;
+    tw->now = now;
+    tw->nodes = (TimerWheelNode*)mem;
+
+    for (size_t l=0; l < TIMERWHEEL_LEVELS; l++){
+        tw->occupied[l] = 0;
+    }
+    for (size_t s=0; s < TIMERWHEEL_LEVELS * TIMERWHEEL_SLOTS; s++){
+        tw->head[s] = TIMERWHEEL_NIL;
+    }
+
+    return tw;
+} /* timerwheel_init */
+
+/* Internal use.
+ * Detach the list of the slot, the slot becomes empty.
+ */
+static size_t _timerwheel_take(TimerWheel *tw, size_t slot)
+{
+    size_t first = tw->head[slot];
+    tw->head[slot] = TIMERWHEEL_NIL;
+    tw->occupied[slot / TIMERWHEEL_SLOTS] &=
+        ~((uint64_t)1 << (slot % TIMERWHEEL_SLOTS));
+    return first;
+} /* _timerwheel_take */
+
+/* Internal use.
+ * Move the timers of the slot of level l for the current tick to the lower
+ * levels. Return the index of the slot.
+ */
+static size_t _timerwheel_cascade(TimerWheel *tw, size_t l)
+{
+    size_t s = (size_t)(tw->now >> (TIMERWHEEL_BITS * l)) &
+               (TIMERWHEEL_SLOTS - 1);
+
+    for (size_t i = _timerwheel_take(tw, l * TIMERWHEEL_SLOTS + s);
+         i != TIMERWHEEL_NIL;){
+        size_t next = tw->nodes[i].next;
+        /* the level 0 slot of the current tick is processed after it */
+        _timerwheel_place(tw, i, tw->now);
+        i = next;
+    }
+    return s;
+} /* _timerwheel_cascade */
+
+/* Internal use.
+ * Ticks from the current one to the next non empty slot of level 0 or to
+ * the next cascade, whatever comes first (at least 1).
+ */
+static uint64_t _timerwheel_skip(const TimerWheel *tw)
+{
+    size_t s = (size_t)(tw->now & (TIMERWHEEL_SLOTS - 1));
+    /* slots after the current one, up to the wrap */
+    uint64_t after = (s == TIMERWHEEL_SLOTS - 1)?0:
+                     tw->occupied[0] & (~(uint64_t)0 << (s + 1));
+
+    if (after == 0){
+        return TIMERWHEEL_SLOTS - s;
+    }
+#if defined(__GNUC__)
+    return (uint64_t)__builtin_ctzll(after) - s;
+#else
+    size_t i = s + 1;
+    while (((after >> i) & 1) == 0){
+        i++;
+    }
+    return i - s;
+#endif
+} /* _timerwheel_skip */
+
+size_t timerwheel_advance(TimerWheel *tw, uint64_t now, TimerWheelExpire cb,
+                          void *ctx)
+{
+    if (tw == NULL){
+        return 0;
+    }
+
+    size_t cnt = 0;
+    while (tw->now < now){
+        uint64_t step = _timerwheel_skip(tw);
+        tw->now = (step > now - tw->now)?now:tw->now + step;
+
+        size_t s = (size_t)(tw->now & (TIMERWHEEL_SLOTS - 1));
+        /* the wrap of a level moves down a slot of the next one */
+        for (size_t l=1; s == 0 && l < TIMERWHEEL_LEVELS; l++){
+            s = _timerwheel_cascade(tw, l);
+        }
+
+        /* One at a time from the head: cb can cancel the other timers of
+         * the slot, its schedules go to other slots (from now + 1).
+         */
+        s = (size_t)(tw->now & (TIMERWHEEL_SLOTS - 1));
+        for (size_t i; (i = tw->head[s]) != TIMERWHEEL_NIL;){
+            /* an early one would be a bug of the placement */
+            assert(tw->nodes[i].expires <= tw->now);
+            _timerwheel_unlink(tw, i);
+            _timerwheel_release(tw, i);
+            cnt++;
+            if (cb != NULL){
+                cb(i, tw->now, ctx);
+            }
+        }
+    }
+
+    return cnt;
+} /* timerwheel_advance */
+
+#endif /* DS_IMPLEMENTATION */
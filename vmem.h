@@ -0,0 +1,340 @@
+#ifndef _DS_VMEM_H
+#define _DS_VMEM_H
+
+/* Virtual Memory regions for the arenas
+ * Namespace: vmem
+ *
+ * Large anonymous mappings to hold the arenas (directly or with arena.h),
+ * with huge pages to reduce the TLB misses of the traversals and
+ * prefaulting to move the page faults out of the first touch:
+ * - VMEM_HUGETLB: explicit huge pages (MAP_HUGETLB), they must be reserved
+ *   by the system (vm.nr_hugepages);
+ * - VMEM_THP: transparent huge pages (madvise MADV_HUGEPAGE) on a region
+ *   aligned to VMEM_HUGE_PAGE, the kernel decides: VMem.page stays the
+ *   normal one;
+ * - VMEM_POPULATE: the pages are faulted in by vmem_map (MAP_POPULATE).
+ * vmem_prefault faults in the pages with more threads.
+ * When a flag can not be applied vmem_map falls back to the normal pages
+ * and VMem.flags reports the ones applied. On systems other than Linux the
+ * region comes from malloc, without flags.
+ *
+ *  VMem m;
+ *  if (vmem_map(&m, SLIST_SIZEOF(n), VMEM_HUGETLB | VMEM_THP)){
+ *      vmem_prefault(&m, 4);
+ *      SList *list = slist_init(m.base, n);
+ *      ...
+ *      vmem_unmap(&m);
+ *  }
+ *
+ * Include it before any system header (it selects mmap and madvise), link
+ * with -pthread for vmem_prefault.
+ */
+
+#if !defined(_DEFAULT_SOURCE) && !defined(_GNU_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VMEM_HUGETLB  1u /* explicit huge pages */
+#define VMEM_THP      2u /* transparent huge pages */
+#define VMEM_POPULATE 4u /* fault in the pages during the map */
+
+/* size of the huge pages, the default one of x86-64 and aarch64 */
+#ifndef VMEM_HUGE_PAGE
+#define VMEM_HUGE_PAGE ((size_t)2 << 20)
+#endif
+
+/* maximum threads of vmem_prefault */
+#ifndef VMEM_MAX_THREADS
+#define VMEM_MAX_THREADS 64
+#endif
+
+typedef struct VMem VMem;
+
+struct VMem {
+    void *base;     /* the usable region, NULL if not mapped */
+    size_t size;    /* usable bytes, the requested size rounded to the page */
+    size_t page;    /* size of the pages, huge only with VMEM_HUGETLB */
+    unsigned flags; /* flags applied */
+    void *map;      /* the whole mapping */
+    size_t mapped;  /* bytes of the whole mapping */
+};
+
+/* Map a region of at least size bytes, zero filled.
+ * flags is a combination of VMEM_HUGETLB, VMEM_THP and VMEM_POPULATE (or 0
+ * for the normal pages), m->flags reports the ones applied.
+ * Return false if m is NULL, size is 0 or the system has no memory.
+ */
+bool vmem_map(VMem *m, size_t size, unsigned flags);
+
+/* Unmap the region, m is not mapped anymore. */
+void vmem_unmap(VMem *m);
+
+/* Fault in all the pages of the region with threads threads (at least 1),
+ * writing every page without changing its content. It is useful before
+ * the first use, when the mapping is not populated.
+ * Return the number of pages.
+ */
+size_t vmem_prefault(VMem *m, size_t threads);
+
+#endif
+
+#if defined(DS_IMPLEMENTATION) && !defined(_DS_VMEM_IMPL)
+#define _DS_VMEM_IMPL
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+#define VMEM_LINUX 1
+#ifndef MAP_ANONYMOUS
+#error "vmem.h must be included before the system headers"
+#endif
+#endif
+
+/* Internal use.
+ * Round size up to a multiple of the power of 2 align, 0 on overflow.
+ */
+static size_t _vmem_round(size_t size, size_t align)
+{
+    if (size > SIZE_MAX - (align - 1)){
+        return 0;
+    }
+    return (size + align - 1) & ~(align - 1);
+}
+
+#ifdef VMEM_LINUX
+
+/* Internal use.
+ * Map with explicit huge pages.
+ */
+static bool _vmem_hugetlb(VMem *m, size_t size, unsigned flags)
+{
+#ifdef MAP_HUGETLB
+    size_t len = _vmem_round(size, VMEM_HUGE_PAGE);
+    if (len == 0){
+        return false;
+    }
+    int mflags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    if (flags & VMEM_POPULATE){
+        mflags |= MAP_POPULATE;
+    }
+
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, mflags, -1, 0);
+    if (p == MAP_FAILED){
+        return false;
+    }
+
+    m->base = m->map = p;
+    m->size = m->mapped = len;
+    m->page = VMEM_HUGE_PAGE;
+    m->flags = VMEM_HUGETLB | (flags & VMEM_POPULATE);
+    return true;
+#else
+    (void)m;
+    (void)size;
+    (void)flags;
+    return false;
+#endif
+}
+
+/* Internal use.
+ * Map aligned to the huge pages and ask for the transparent ones.
+ */
+static bool _vmem_thp(VMem *m, size_t size, unsigned flags)
+{
+#ifdef MADV_HUGEPAGE
+    size_t len = _vmem_round(size, VMEM_HUGE_PAGE);
+    if (len == 0 || len > SIZE_MAX - VMEM_HUGE_PAGE){
+        return false;
+    }
+
+    /* map one huge page more and trim the unaligned ends */
+    size_t over = len + VMEM_HUGE_PAGE;
+    uint8_t *p = mmap(NULL, over, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED){
+        return false;
+    }
+    size_t head = (size_t)(-(uintptr_t)p & (VMEM_HUGE_PAGE - 1));
+    if (head > 0){
+        munmap(p, head);
+    }
+    if (over - head - len > 0){
+        munmap(&p[head + len], over - head - len);
+    }
+
+    m->base = m->map = &p[head];
+    m->size = m->mapped = len;
+    m->page = (size_t)sysconf(_SC_PAGESIZE);
+    m->flags = 0;
+    /* the advice does not grant the huge pages: the page stays the base one,
+     * the kernel can back the region (or a part of it) with normal pages
+     */
+    if (madvise(m->base, len, MADV_HUGEPAGE) == 0){
+        m->flags = VMEM_THP;
+    }
+    /* populate after the advice, to fault in huge pages */
+    if (flags & VMEM_POPULATE){
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(m->base, len, MADV_POPULATE_WRITE) != 0){
+            vmem_prefault(m, 1);
+        }
+#else
+        vmem_prefault(m, 1);
+#endif
+        m->flags |= VMEM_POPULATE;
+    }
+    return true;
+#else
+    (void)m;
+    (void)size;
+    (void)flags;
+    return false;
+#endif
+}
+
+#endif /* VMEM_LINUX */
+
+bool vmem_map(VMem *m, size_t size, unsigned flags)
+{
+    if (m == NULL || size == 0){
+        return false;
+    }
+    memset(m, 0, sizeof(*m));
+
+#ifdef VMEM_LINUX
+    if ((flags & VMEM_HUGETLB) && _vmem_hugetlb(m, size, flags)){
+        return true;
+    }
+    if ((flags & VMEM_THP) && _vmem_thp(m, size, flags)){
+        return true;
+    }
+
+    /* normal pages */
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = _vmem_round(size, page);
+    if (len == 0){
+        return false;
+    }
+    int mflags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (flags & VMEM_POPULATE){
+        mflags |= MAP_POPULATE;
+    }
+
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, mflags, -1, 0);
+    if (p == MAP_FAILED){
+        return false;
+    }
+
+    m->base = m->map = p;
+    m->size = m->mapped = len;
+    m->page = page;
+    m->flags = flags & VMEM_POPULATE;
+    return true;
+#else
+    (void)flags;
+    size_t len = _vmem_round(size, 4096);
+    m->base = m->map = (len == 0)?NULL:calloc(1, len);
+    if (m->base == NULL){
+        return false;
+    }
+    m->size = m->mapped = len;
+    m->page = 4096;
+    return true;
+#endif
+}
+
+void vmem_unmap(VMem *m)
+{
+    if (m == NULL || m->map == NULL){
+        return;
+    }
+
+#ifdef VMEM_LINUX
+    munmap(m->map, m->mapped);
+#else
+    free(m->map);
+#endif
+    memset(m, 0, sizeof(*m));
+}
+
+/* Internal use.
+ * Pages [first, last) of a prefault thread.
+ */
+typedef struct {
+    volatile uint8_t *base;
+    size_t page;
+    size_t first;
+    size_t last;
+} _VMemSlice;
+
+/* Internal use.
+ * Write every page of the slice with its own content.
+ */
+static void * _vmem_touch(void *arg)
+{
+    _VMemSlice *s = arg;
+
+    for (size_t i = s->first; i < s->last; i++){
+        volatile uint8_t *b = &s->base[i * s->page];
+        *b = *b;
+    }
+    return NULL;
+}
+
+size_t vmem_prefault(VMem *m, size_t threads)
+{
+    if (m == NULL || m->base == NULL){
+        return 0;
+    }
+
+    size_t pages = m->size / m->page;
+    if (pages == 0){
+        return 0;
+    }
+    threads = (threads == 0)?1:threads;
+    threads = (threads > VMEM_MAX_THREADS)?VMEM_MAX_THREADS:threads;
+    threads = (threads > pages)?pages:threads;
+
+    _VMemSlice s[VMEM_MAX_THREADS] = {{NULL, 0, 0, 0}};
+    for (size_t t=0; t < threads; t++){
+        s[t].base = m->base;
+        s[t].page = m->page;
+        s[t].first = pages * t / threads;
+        s[t].last = pages * (t + 1) / threads;
+    }
+
+#ifdef VMEM_LINUX
+    pthread_t th[VMEM_MAX_THREADS];
+    size_t started = 1;
+    /* the calling thread takes the first slice */
+    for (; started < threads; started++){
+        if (pthread_create(&th[started], NULL, _vmem_touch, &s[started])){
+            break;
+        }
+    }
+    /* the slices without a thread go to the calling one */
+    for (size_t t = started; t < threads; t++){
+        _vmem_touch(&s[t]);
+    }
+    _vmem_touch(&s[0]);
+    for (size_t t=1; t < started; t++){
+        pthread_join(th[t], NULL);
+    }
+#else
+    for (size_t t=0; t < threads; t++){
+        _vmem_touch(&s[t]);
+    }
+#endif
+
+    return pages;
+}
+
+#endif /* DS_IMPLEMENTATION */